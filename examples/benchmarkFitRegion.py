@@ -0,0 +1,119 @@
+#!/usr/bin/env python
+#
+# LSST Data Management System
+# Copyright 2008-2013 LSST Corporation.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+"""Benchmark the cost/accuracy trade-off of signal-to-noise adaptive CModel fit regions.
+
+Simulates small exponential galaxies at a range of signal-to-noise ratios, and fits each with CModel
+with and without PixelFitRegionControl.maxTrimSignalToNoise set, reporting the mean time per fit,
+the mean number of pixels in the final fit region, and the bias and scatter of the CModel flux
+(relative to the true flux, in units of the true flux).
+"""
+
+import time
+
+import numpy
+
+import lsst.geom
+import lsst.afw.geom
+import lsst.afw.image
+import lsst.afw.detection
+import lsst.shapelet
+import lsst.meas.modelfit
+
+PSF_SIGMA = 2.0
+GALAXY_RADIUS = 2.0
+TRUE_FLUX = 1000.0
+
+
+def makeExposure(noiseSigma, rng):
+    bbox = lsst.geom.Box2I(lsst.geom.Point2I(-40, -40), lsst.geom.Point2I(40, 40))
+    exposure = lsst.afw.image.ExposureF(bbox)
+    crval = lsst.geom.SpherePoint(45.0, 45.0, lsst.geom.degrees)
+    cdMatrix = lsst.afw.geom.makeCdMatrix(scale=0.2*lsst.geom.arcseconds, flipX=True)
+    exposure.setWcs(lsst.afw.geom.makeSkyWcs(crpix=lsst.geom.Point2D(0.0, 0.0), crval=crval,
+                                             cdMatrix=cdMatrix))
+    exposure.setPhotoCalib(lsst.afw.image.PhotoCalib(1.0))
+    exposure.setPsf(lsst.afw.detection.GaussianPsf(25, 25, PSF_SIGMA))
+    # Approximate the convolved exponential as a double Gaussian; this is a benchmark of the fit
+    # region, not of the galaxy model, so the exact profile doesn't matter.
+    y, x = numpy.mgrid[bbox.getMinY():bbox.getMaxY() + 1, bbox.getMinX():bbox.getMaxX() + 1]
+    r2 = x**2 + y**2
+    image = numpy.zeros(r2.shape, dtype=float)
+    for fraction, sigma in [(0.6, 0.7*GALAXY_RADIUS), (0.4, 1.6*GALAXY_RADIUS)]:
+        s2 = sigma**2 + PSF_SIGMA**2
+        image += fraction*numpy.exp(-0.5*r2/s2)/(2.0*numpy.pi*s2)
+    image *= TRUE_FLUX
+    image += noiseSigma*rng.randn(*image.shape)
+    exposure.getMaskedImage().getImage().getArray()[:, :] = image
+    exposure.getMaskedImage().getVariance().getArray()[:, :] = noiseSigma**2
+    return exposure
+
+
+def makePsfModel():
+    s = lsst.shapelet.ShapeletFunction(0, lsst.shapelet.HERMITE, PSF_SIGMA)
+    s.getCoefficients()[0] = 1.0 / lsst.shapelet.ShapeletFunction.FLUX_FACTOR
+    m = lsst.shapelet.MultiShapeletFunction()
+    m.addComponent(s)
+    return m
+
+
+def run(signalToNoise, maxTrimSignalToNoise, nTrials, rng):
+    ctrl = lsst.meas.modelfit.CModelControl()
+    ctrl.region.maxTrimSignalToNoise = maxTrimSignalToNoise
+    algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+    psfModel = makePsfModel()
+    # Noise level that gives (approximately) the requested PSF-weighted signal-to-noise ratio.
+    noiseSigma = TRUE_FLUX / (signalToNoise * (4.0*numpy.pi*(PSF_SIGMA**2 + GALAXY_RADIUS**2))**0.5)
+    fluxes = []
+    areas = []
+    elapsed = 0.0
+    for i in range(nTrials):
+        exposure = makeExposure(noiseSigma, rng)
+        psfMoments = exposure.getPsf().computeShape()
+        t0 = time.time()
+        result = algorithm.apply(exposure, psfModel, lsst.geom.Point2D(0.0, 0.0), psfMoments)
+        elapsed += time.time() - t0
+        if not result.flags[result.FAILED]:
+            fluxes.append(result.instFlux / TRUE_FLUX)
+            areas.append(result.finalFitRegion.getArea())
+    fluxes = numpy.array(fluxes)
+    return (elapsed / nTrials, numpy.mean(areas), fluxes.mean() - 1.0, fluxes.std(),
+            nTrials - len(fluxes))
+
+
+def main(nTrials=50, seed=5):
+    print("%6s %8s %10s %8s %9s %9s %6s" % (
+        "S/N", "trim", "time (ms)", "area", "bias", "scatter", "failed"
+    ))
+    for signalToNoise in (5.0, 10.0, 20.0, 50.0, 100.0):
+        for maxTrimSignalToNoise in (0.0, 1E3):
+            rng = numpy.random.RandomState(seed)
+            t, area, bias, scatter, nFailed = run(signalToNoise, maxTrimSignalToNoise, nTrials, rng)
+            print("%6.1f %8s %10.2f %8.1f %9.4f %9.4f %6d" % (
+                signalToNoise, "yes" if maxTrimSignalToNoise > 0 else "no", 1E3*t, area, bias, scatter,
+                nFailed
+            ))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,176 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+//
+// Benchmark the closed-form 2-d TruncatedGaussian::maximize() against the generic reduced-system solve
+// (permutation matrix + FullPivLU) it replaced, on random 2-d problems.  Prints the number of problems on
+// which the two disagree (where the generic answer is feasible), the maximum disagreement, the number on
+// which maximize() has a worse objective (expected to be zero), the number on which the generic answer is
+// infeasible, and the mean time per call for each.  Disagreements are expected only where both elements
+// of the untruncated mean are negative, where the generic solve returns the origin.
+//
+// Each timing is the best of nPasses passes over all problems, after an untimed warm-up pass.  Absolute
+// timings and their ratio depend on the compiler, optimization flags and machine, so no reference figures
+// are recorded here; run this with the build's own flags to compare the two paths.
+//
+// Usage: benchmarkTruncatedGaussian [nProblems [nPasses]]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Eigen/Eigenvalues"
+#include "Eigen/LU"
+
+#include "lsst/meas/modelfit/TruncatedGaussian.h"
+
+using lsst::meas::modelfit::Scalar;
+using lsst::meas::modelfit::Vector;
+using lsst::meas::modelfit::Matrix;
+using lsst::meas::modelfit::TruncatedGaussian;
+
+namespace {
+
+struct Problem {
+    Vector mu;
+    Vector s;
+    Matrix v;
+    Matrix hessian;
+};
+
+// The maximize() implementation used for all dimensions before the closed-form 2-d path was added:
+// clamp the negative components of mu at zero and solve for the rest.
+Vector maximizeGeneric(Problem const & p) {
+    int const n = p.mu.size();
+    Vector result(p.mu);
+    int k = 0;
+    for (int i = 0; i < n; ++i) {
+        if (result[i] < 0.0) {
+            ++k;
+        }
+    }
+    if (n == k) {
+        result.setZero();
+    } else if (k > 0) {
+        Eigen::VectorXi indices(n);
+        for (int i = 0, j1 = 0, j2 = n - k; i < n; ++i) {
+            if (result[i] < 0.0) {
+                indices[i] = j2;
+                ++j2;
+            } else {
+                indices[i] = j1;
+                ++j1;
+            }
+        }
+        Eigen::PermutationMatrix<Eigen::Dynamic> perm(indices);
+        Matrix pv = perm * p.v;
+        Matrix G = pv * p.s.asDiagonal() * pv.adjoint();
+        Vector nu = perm * p.mu;
+        Vector beta = Vector::Zero(n);
+        Eigen::FullPivLU<Matrix> solver(G.topLeftCorner(n - k, n - k));
+        beta.head(n - k) = solver.solve(G.topRightCorner(n - k, k) * nu.tail(k)) + nu.head(n - k);
+        result = perm.transpose() * beta;
+    }
+    return result;
+}
+
+} // anonymous
+
+int main(int argc, char ** argv) {
+    int const nProblems = (argc > 1) ? std::atoi(argv[1]) : 200000;
+    int const nPasses = (argc > 2) ? std::atoi(argv[2]) : 5;
+    std::mt19937 rng(1);
+    std::normal_distribution<Scalar> normal;
+    std::vector<Problem> problems(nProblems);
+    std::vector<TruncatedGaussian> tgs;
+    tgs.reserve(nProblems);
+    for (auto & p : problems) {
+        Matrix a(5, 2);
+        for (int i = 0; i < a.size(); ++i) {
+            a.data()[i] = normal(rng);
+        }
+        p.hessian = a.adjoint() * a;
+        p.mu = Vector(2);
+        p.mu << normal(rng), normal(rng);
+        Eigen::SelfAdjointEigenSolver<Matrix> eig(p.hessian);
+        p.s = eig.eigenvalues();
+        p.v = eig.eigenvectors();
+        tgs.push_back(TruncatedGaussian::fromSeriesParameters(0.0, -p.hessian * p.mu, p.hessian));
+    }
+
+    int nMismatch = 0;
+    int nInfeasible = 0;
+    int nWorse = 0;
+    Scalar maxDiff = 0.0;
+    for (int t = 0; t < nProblems; ++t) {
+        Problem const & p = problems[t];
+        Vector generic = maximizeGeneric(p);
+        Vector fast = tgs[t].maximize();
+        if ((generic.array() < 0.0).any()) {
+            ++nInfeasible;
+            continue;
+        }
+        // maximize() works from the mean it recovers from the series parameters, so allow for round-off
+        Vector dGeneric = generic - p.mu;
+        Vector dFast = fast - p.mu;
+        Scalar objGeneric = dGeneric.dot(p.hessian * dGeneric);
+        if (dFast.dot(p.hessian * dFast) > objGeneric + 1E-10 * (1.0 + objGeneric)) {
+            ++nWorse;
+        }
+        Scalar diff = (generic - fast).cwiseAbs().maxCoeff();
+        if (diff > 1E-10) {
+            ++nMismatch;
+            maxDiff = std::max(maxDiff, diff);
+        }
+    }
+    std::printf("feasible mismatches: %d (max difference %g); worse objective: %d; generic infeasible: %d\n",
+                nMismatch, maxDiff, nWorse, nInfeasible);
+
+    Scalar sum = 0.0;
+    for (int t = 0; t < nProblems; ++t) {
+        sum += maximizeGeneric(problems[t]).sum() + tgs[t].maximize().sum();
+    }
+    double bestGeneric = std::numeric_limits<double>::infinity();
+    double bestFast = std::numeric_limits<double>::infinity();
+    for (int pass = 0; pass < nPasses; ++pass) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (auto const & p : problems) {
+            sum += maximizeGeneric(p).sum();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (auto const & tg : tgs) {
+            sum += tg.maximize().sum();
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        bestGeneric = std::min(bestGeneric, std::chrono::duration<double, std::nano>(t1 - t0).count());
+        bestFast = std::min(bestFast, std::chrono::duration<double, std::nano>(t2 - t1).count());
+    }
+    std::printf("generic: %.1f ns/call, maximize(): %.1f ns/call, ratio %.2f (best of %d; checksum %g)\n",
+                bestGeneric / nProblems, bestFast / nProblems, bestGeneric / bestFast, nPasses, sum);
+    return 0;
+}
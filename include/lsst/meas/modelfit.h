@@ -26,10 +26,12 @@
 
 #include "lsst/meas/modelfit/AdaptiveImportanceSampler.h"
 #include "lsst/meas/modelfit/Sampler.h"
+#include "lsst/meas/modelfit/DirectSamplingObjective.h"
 #include "lsst/meas/modelfit/TruncatedGaussian.h"
 #include "lsst/meas/modelfit/Likelihood.h"
 #include "lsst/meas/modelfit/UnitTransformedLikelihood.h"
 #include "lsst/meas/modelfit/UnitSystem.h"
+#include "lsst/meas/modelfit/WcsLinearizationCache.h"
 #include "lsst/meas/modelfit/Prior.h"
 #include "lsst/meas/modelfit/MixturePrior.h"
 #include "lsst/meas/modelfit/SoftenedLinearPrior.h"
@@ -38,8 +40,10 @@
 #include "lsst/meas/modelfit/Model.h"
 #include "lsst/meas/modelfit/MultiModel.h"
 #include "lsst/meas/modelfit/Mixture.h"
+#include "lsst/meas/modelfit/CounterRandom.h"
 #include "lsst/meas/modelfit/optimizer.h"
 #include "lsst/meas/modelfit/GeneralPsfFitter.h"
+#include "lsst/meas/modelfit/PsfFitCache.h"
 #include "lsst/meas/modelfit/CModel.h"
 
 #endif // !LSST_MEAS_MODELFIT_H
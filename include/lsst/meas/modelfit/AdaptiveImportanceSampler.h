@@ -79,12 +79,16 @@ public:
      *  @param[in]  ctrls             Vector of control objects that define the iterations.
      *  @param[in]  doSaveIterations  Whether to save intermediate SampleSets and associated
      *                                proposal distributions.
+     *  @param[in]  nThreads          Number of threads used to evaluate the objective function, if
+     *                                SamplingObjective::isThreadSafe() returns true.  Samples and
+     *                                results do not depend on the number of threads.
      */
     AdaptiveImportanceSampler(
         afw::table::Schema & sampleSchema,
         PTR(afw::math::Random) rng,
         std::map<int,ImportanceSamplerControl> const & ctrls,
-        bool doSaveIterations=false
+        bool doSaveIterations=false,
+        int nThreads=1
     );
 
     void run(
@@ -99,6 +103,7 @@ public:
 
 private:
     bool _doSaveIterations;
+    int _nThreads;
     PTR(afw::math::Random)  _rng;
     std::map<int,ImportanceSamplerControl> _ctrls;
     afw::table::Key<Scalar> _weightKey;
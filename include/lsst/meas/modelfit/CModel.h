@@ -150,7 +150,12 @@ struct CModelStageControl {
         usePixelWeights(false),
         weightsMultiplier(1.0),
         doRecordHistory(true),
-        doRecordTime(true)
+        doRecordTime(true),
+        maxPsfOrder(-1),
+        binFactor(1),
+        minBinnedArea(200),
+        doRefineBinned(true),
+        adaptiveFluxTolerance(0.0)
     {}
 
     shapelet::RadialProfile const & getProfile() const {
@@ -224,6 +229,44 @@ struct CModelStageControl {
         "Whether to record the time spent in this stage"
     );
 
+    LSST_CONTROL_FIELD(
+        maxPsfOrder, int,
+        "Maximum shapelet order of the PSF approximation components the model is convolved with in this "
+        "stage; higher-order terms are dropped and the approximation renormalized.  Negative values (the "
+        "default) use the full approximation.  Setting this to 0 for the initial stage makes it cheaper "
+        "with little effect on the final fluxes."
+    );
+
+    LSST_CONTROL_FIELD(
+        binFactor, int,
+        "If greater than one, first optimize on pixels binned by this factor in each dimension (with a "
+        "correspondingly binned footprint and PSF approximation), which is much cheaper far from the "
+        "optimum.  Ignored in forced mode."
+    );
+
+    LSST_CONTROL_FIELD(
+        minBinnedArea, int,
+        "Minimum number of binned pixels in the binned footprint; sources with fewer are fit only at full "
+        "resolution."
+    );
+
+    LSST_CONTROL_FIELD(
+        doRefineBinned, bool,
+        "Whether to continue optimizing on full-resolution pixels after optimizing on binned pixels.  If "
+        "false, only the amplitudes and flux uncertainty are computed at full resolution, and the "
+        "objective and history refer to the binned fit."
+    );
+
+    LSST_CONTROL_FIELD(
+        adaptiveFluxTolerance, double,
+        "If positive, fit each source with the fewest Gaussian components (obtained by merging the "
+        "innermost components of the full nComponents approximation) for which the estimated fractional "
+        "flux bias relative to the full approximation, after convolution with the PSF and the pixel, is "
+        "no larger than this.  The estimate uses the ellipse from the initial stage, so this has no "
+        "effect on the initial stage itself.  The number of components used is recorded in the "
+        "'nComponents' field, and forced mode always uses the same model as the reference fit."
+    );
+
 };
 
 /**
@@ -235,7 +278,12 @@ struct CModelControl {
     CModelControl() :
         psfName("modelfit_DoubleShapeletPsfApprox"),
         minInitialRadius(0.1),
-        fallbackInitialMomentsPsfFactor(1.5)
+        fallbackInitialMomentsPsfFactor(1.5),
+        doCacheWcsLinearization(false),
+        wcsLinearizationTolerance(1E-6),
+        doKeepFitState(true),
+        pointSourceMaxRadiusRatio(0.0),
+        pointSourceMaxReducedChiSq(1.5)
     {
         initial.nComponents = 3; // use very rough model in initial fit
         initial.optimizer.gradientThreshold = 1E-3; // with slightly coarser convergence criteria
@@ -261,7 +309,8 @@ struct CModelControl {
     LSST_NESTED_CONTROL_FIELD(
         initial, lsst.meas.modelfit.cmodel, CModelStageControl,
         "An initial fit (usually with a fast, approximate model) used to warm-start the exp and dev fits, "
-        "convolved with only the zeroth-order terms in the multi-shapelet PSF approximation."
+        "convolved with the multi-shapelet PSF approximation truncated to initial.maxPsfOrder (the full "
+        "approximation by default; set it to 0 to use only the zeroth-order terms)."
     );
 
     LSST_NESTED_CONTROL_FIELD(
@@ -285,6 +334,39 @@ struct CModelControl {
         "  If <= 0.0, abort the fit early instead."
     );
 
+    LSST_CONTROL_FIELD(
+        doCacheWcsLinearization, bool,
+        "Interpolate local linearizations of the exposure Wcs from a grid shared by all sources on the "
+        "exposure (see WcsLinearizationCache), instead of linearizing the Wcs for each source.  This "
+        "changes the results at the level of wcsLinearizationTolerance."
+    );
+
+    LSST_CONTROL_FIELD(
+        wcsLinearizationTolerance, double,
+        "Maximum relative error in interpolated Wcs linearizations, if doCacheWcsLinearization is True."
+    );
+
+    LSST_CONTROL_FIELD(
+        doKeepFitState, bool,
+        "Whether results returned by CModelAlgorithm.apply and applyForced should retain each stage's "
+        "likelihood, objective and optimizer history.  These hold the pixels used in the fit, so this "
+        "should be False when keeping results for many sources; scalar outputs and parameter vectors "
+        "are always retained."
+    );
+
+    LSST_CONTROL_FIELD(
+        pointSourceMaxRadiusRatio, double,
+        "If the half-light radius of the initial fit is less than this multiple of the PSF's moments "
+        "radius (both determinant radii), fit the exp and dev components as point sources (amplitudes only, "
+        "with radius minInitialRadius) instead of running their nonlinear fits.  0 disables this."
+    );
+
+    LSST_CONTROL_FIELD(
+        pointSourceMaxReducedChiSq, double,
+        "Maximum chi^2 per pixel (using per-pixel variances) of each point-source fit (see "
+        "pointSourceMaxRadiusRatio); if either exceeds this, the full nonlinear fits are run instead."
+    );
+
 };
 
 /**
@@ -308,6 +390,9 @@ struct CModelStageResult {
 
     CModelStageResult();
 
+    /// Reset likelihood, objfunc and history, releasing the pixel data and optimizer trace they hold.
+    void releaseFitState();
+
     PTR(Model) model;    ///< Model object that defines the parametrization (defined fully by Control struct)
     PTR(Prior) prior;    ///< Bayesian priors on the parameters (defined fully by Control struct)
     PTR(OptimizerObjective) objfunc;  ///< Objective class used by the optimizer
@@ -349,10 +434,14 @@ struct CModelResult {
                                           ///  too small, so we used the configuration minimum instead.
         REGION_USED_INITIAL_ELLIPSE_MAX,  ///< Fit region implied by the best-fit ellipse of the initial was
                                           ///  too large, so we used the configuration maximum instead.
+        REGION_USED_INFORMATION_TRIM,     ///< Source was faint enough that the final fit region was trimmed
+                                          ///  to the ellipse containing most of the flux information.
         NO_SHAPE,                ///< Set if the input SourceRecord had no valid shape slot with which to
                                  ///  start the fit.
         SMALL_SHAPE,             ///< Initial moments were sufficiently small that we used minInitialRadius
                                  ///  to set the initial parameters.
+        POINT_SOURCE,            ///< Initial fit was unresolved, so the exp and dev components were fit as
+                                 ///  point sources (amplitudes only); see pointSourceMaxRadiusRatio.
         NO_SHAPELET_PSF,         ///< Set if the Psf shapelet approximation failed.
         BAD_CENTROID,            ///< Input centroid did not land within the fit region.
         BAD_REFERENCE,           ///< Reference fit failed, so forced fit will fail as well.
@@ -362,6 +451,9 @@ struct CModelResult {
 
     CModelResult();
 
+    /// Release the fit state held by all three stage results (see CModelStageResult::releaseFitState).
+    void releaseFitState();
+
     Scalar instFlux;       ///< Flux from the final linear fit
     Scalar instFluxErr;  ///< Flux uncertainty from the final linear fit
     Scalar instFluxInner;  ///< Flux measured strictly within the fit region (no extrapolation).
@@ -545,6 +637,16 @@ public:
     /// Copy values from a Result struct to a BaseRecord object.
     void writeResultToRecord(Result const & result, afw::table::BaseRecord & record) const;
 
+    /**
+     *  Discard the bad pixel bitmap cached from the most recently measured mask.
+     *
+     *  To avoid unpacking the mask for every source, the algorithm reuses a bitmap of its bad pixels
+     *  for as long as it is given the same mask object (with the same pixel buffer).  This must be
+     *  called if that mask is modified in place between calls to apply, applyForced, or measure, or if
+     *  it may be destroyed and replaced by another mask that reuses the same pixel buffer.
+     */
+    void resetBadPixelCache() const;
+
 private:
 
     friend class CModelAlgorithmControl;
@@ -0,0 +1,107 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+#ifndef LSST_MEAS_MODELFIT_CounterRandom_h_INCLUDED
+#define LSST_MEAS_MODELFIT_CounterRandom_h_INCLUDED
+
+#include <array>
+#include <cstdint>
+
+namespace lsst { namespace meas { namespace modelfit {
+
+/**
+ *  @brief A stateless, counter-based random number generator (Philox4x32-10).
+ *
+ *  Unlike afw::math::Random, a CounterRandom has no internal state: the random numbers for a sample
+ *  are a pure function of the seed, a source ID (e.g. an object ID), the index of the sample, and the
+ *  index of the draw within that sample.  That makes it possible to draw samples in any order or in
+ *  parallel while producing results that are bitwise identical for any number of threads.
+ *
+ *  Random numbers for a single sample are obtained from a Stream, which provides the same
+ *  uniform/gaussian/chisq interface as afw::math::Random.
+ */
+class CounterRandom {
+public:
+
+    /**
+     *  @brief Sequence of random numbers for a single sample.
+     *
+     *  Streams are cheap, single-threaded value objects; each thread should create its own.
+     */
+    class Stream {
+    public:
+
+        /// Return a uniformly-distributed random number in the open interval (0, 1).
+        double uniform();
+
+        /// Return a random number drawn from the unit normal distribution.
+        double gaussian();
+
+        /// Return a random number drawn from a chi-squared distribution with nu degrees of freedom.
+        double chisq(double nu);
+
+    private:
+
+        friend class CounterRandom;
+
+        Stream(CounterRandom const & parent, std::uint64_t sample);
+
+        CounterRandom const * _parent;
+        std::uint64_t _sample;
+        std::uint32_t _block;
+        int _nUniforms;
+        bool _hasGaussian;
+        double _uniforms[2];
+        double _gaussian;
+    };
+
+    /**
+     *  Construct a generator.
+     *
+     *  @param[in] seed      Seed that sets the key of the generator.
+     *  @param[in] sourceId  Identifier that distinguishes independent sets of samples drawn with the
+     *                       same seed.
+     */
+    explicit CounterRandom(std::uint64_t seed, std::uint32_t sourceId=0) :
+        _seed(seed), _sourceId(sourceId)
+    {}
+
+    std::uint64_t getSeed() const { return _seed; }
+
+    std::uint32_t getSourceId() const { return _sourceId; }
+
+    /// Return a Stream of random numbers for the sample with the given index.
+    Stream getStream(std::uint64_t sample) const { return Stream(*this, sample); }
+
+    /// Return the four 32-bit random integers for the given sample and block indices.
+    std::array<std::uint32_t,4> generate(std::uint64_t sample, std::uint32_t block) const;
+
+private:
+    std::uint64_t _seed;
+    std::uint32_t _sourceId;
+};
+
+}}} // namespace lsst::meas::modelfit
+
+#endif // !LSST_MEAS_MODELFIT_CounterRandom_h_INCLUDED
@@ -0,0 +1,103 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_MODELFIT_DirectSamplingObjective_h_INCLUDED
+#define LSST_MEAS_MODELFIT_DirectSamplingObjective_h_INCLUDED
+
+#include <functional>
+#include <mutex>
+
+#include "lsst/meas/modelfit/Sampler.h"
+#include "lsst/meas/modelfit/Prior.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+/**
+ *  @brief A SamplingObjective that evaluates the -log posterior of all (nonlinear and amplitude)
+ *         parameters directly.
+ *
+ *  Sample parameter vectors are the nonlinear parameters followed by the amplitudes.  The objective
+ *  value is @f$\frac{1}{2}\left|z - B(\theta)\alpha\right|^2 - \ln P(\theta,\alpha)@f$ (see Likelihood),
+ *  where the prior term is omitted if no Prior is given.
+ *
+ *  Likelihoods keep internal workspace, so a single Likelihood cannot compute model matrices for more
+ *  than one thread at a time.  A DirectSamplingObjective constructed with a LikelihoodFactory is
+ *  thread-safe: each Workspace holds its own Likelihood from the factory, which must return
+ *  equivalent Likelihoods that share no ndarray objects with each other.  The prior is shared and is
+ *  evaluated by only one thread at a time.
+ */
+class DirectSamplingObjective : public SamplingObjective {
+public:
+
+    typedef std::function<PTR(Likelihood)()> LikelihoodFactory;
+
+    /**
+     *  Construct an objective that can only be evaluated in one thread at a time.
+     *
+     *  @param[in]  likelihood   Likelihood to evaluate.
+     *  @param[in]  prior        Prior to evaluate; may be null.
+     */
+    DirectSamplingObjective(PTR(Likelihood) likelihood, PTR(Prior) prior);
+
+    /**
+     *  Construct a thread-safe objective.
+     *
+     *  @param[in]  factory      Function that returns a new Likelihood each time it is called.  It is
+     *                           called once on construction and once per Workspace.
+     *  @param[in]  prior        Prior to evaluate; may be null.
+     */
+    DirectSamplingObjective(LikelihoodFactory factory, PTR(Prior) prior);
+
+    ~DirectSamplingObjective() override;
+
+    int getParameterDim() const override;
+
+    Scalar operator()(
+        ndarray::Array<Scalar const,1,1> const & parameters,
+        afw::table::BaseRecord & sample
+    ) const override;
+
+    Scalar evaluate(
+        ndarray::Array<Scalar const,1,1> const & parameters,
+        afw::table::BaseRecord & sample,
+        Workspace & workspace
+    ) const override;
+
+    bool isThreadSafe() const override { return static_cast<bool>(_factory); }
+
+    /// Create a new workspace; evaluate() may only be passed workspaces created by this method.
+    std::unique_ptr<Workspace> makeWorkspace() const override;
+
+private:
+
+    class DirectWorkspace;
+
+    LikelihoodFactory _factory;
+    PTR(Prior) _prior;
+    std::unique_ptr<DirectWorkspace> _workspace;  // used by operator()
+    mutable std::mutex _priorMutex;
+};
+
+}}} // namespace lsst::meas::modelfit
+
+#endif // !LSST_MEAS_MODELFIT_DirectSamplingObjective_h_INCLUDED
@@ -29,6 +29,7 @@
 #include "lsst/meas/base/Algorithm.h"
 #include "lsst/meas/base/InputUtilities.h"
 #include "lsst/meas/modelfit/optimizer.h"
+#include "lsst/meas/modelfit/PsfFitCache.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
@@ -41,7 +42,8 @@ public:
     DoubleShapeletPsfApproxControl() :
         innerOrder(2), outerOrder(1),
         radiusRatio(2.0), peakRatio(0.1),
-        minRadius(1.0), minRadiusDiff(0.5), maxRadiusBoxFraction(0.4)
+        minRadius(1.0), minRadiusDiff(0.5), maxRadiusBoxFraction(0.4),
+        warmStartMaxDistance(0.0)
     {}
 
     LSST_CONTROL_FIELD(innerOrder, int, "Shapelet order of inner expansion (0 == Gaussian)");
@@ -70,6 +72,12 @@ public:
         "Don't allow the semi-major radius of any component to go above this fraction of the PSF image width"
     );
 
+    LSST_CONTROL_FIELD(
+        warmStartMaxDistance, double,
+        "If positive, start the profile fit from the most recent successful fit within this distance "
+        "(pixels) on the same exposure, instead of from the configured radius and peak ratios"
+    );
+
     LSST_NESTED_CONTROL_FIELD(
         optimizer, lsst.meas.modelfit.optimizer, OptimizerControl,
         "Configuration of the optimizer used by DoubleShapeletPsfsApproxAlgorithm::fitProfile()."
@@ -136,6 +144,22 @@ public:
      */
     static shapelet::MultiShapeletFunction initializeResult(Control const & ctrl);
 
+    /**
+     *  Create a MultiShapeletFunction from a previous fit, for use as a warm start.
+     *
+     *  The previous fit is rescaled to unit total flux and transformed to have unit circle moments,
+     *  preserving its profile (the relative radii, amplitudes and ellipticities of its components), so
+     *  the result may be passed directly to fitMoments().
+     *
+     *  @param[in]  ctrl      Control object specifying the details of the model and how to fit it.
+     *  @param[in]  previous  A previous fit of the same model, probably the result of measure() at a
+     *                        nearby position.
+     */
+    static shapelet::MultiShapeletFunction initializeResult(
+        Control const & ctrl,
+        shapelet::MultiShapeletFunction const & previous
+    );
+
     /**
      *  Update a MultiShapeletFunction's ellipses to match the first and second moments of a PSF image.
      *
@@ -244,7 +268,10 @@ public:
     /**
      *  Run all fitting stages on the Psf attached to the given Exposure, saving the results in measRecord.
      *
-     *  We first call fitMoments(), then fitProfile(), then fitShapelets().
+     *  We first call fitMoments(), then fitProfile(), then fitShapelets().  If
+     *  ctrl.warmStartMaxDistance is positive and a previous fit at a nearby position on the same
+     *  exposure succeeded, fitMoments() is applied to that fit (see initializeResult()) instead of
+     *  to the default initial profile.
      */
     void measure(
         afw::table::SourceRecord & measRecord,
@@ -261,6 +288,7 @@ public:
 
 private:
     Control _ctrl;
+    PTR(PsfFitCache) _cache;
     meas::base::SafeCentroidExtractor _centroidExtractor;
     shapelet::MultiShapeletFunctionKey _key;
     lsst::meas::base::FlagHandler _flagHandler;
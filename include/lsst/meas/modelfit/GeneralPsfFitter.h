@@ -254,7 +254,7 @@ public:
         Scalar noiseSigma=-1,
         int * pState = nullptr
     ) const {
-        return apply(afw::image::Image<float>(image, true), initial, noiseSigma);
+        return apply(afw::image::Image<float>(image, true), initial, noiseSigma, pState);
     }
     //@}
 
@@ -329,6 +329,20 @@ public:
         bool doApplyWeights=true
     ) const override;
 
+    /**
+     *  Compute analytic derivatives of the model with respect to the free center, ellipticity and radius
+     *  parameters of each component.
+     *
+     *  Returns false (indicating numerical derivatives should be used) if the Model was not constructed
+     *  by GeneralPsfFitter.
+     */
+    bool differentiateModel(
+        ndarray::Array<Scalar,2,-1> const & modelDerivative,
+        ndarray::Array<Scalar const,1,1> const & nonlinear,
+        ndarray::Array<Scalar const,1,1> const & amplitudes,
+        bool doApplyWeights=true
+    ) const override;
+
     virtual ~MultiShapeletPsfLikelihood();
 
 private:
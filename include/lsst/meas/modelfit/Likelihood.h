@@ -123,6 +123,34 @@ public:
         bool doApplyWeights=true
     ) const = 0;
 
+    /**
+     *  @brief Evaluate analytic derivatives of the model with respect to the nonlinear parameters,
+     *         or signal that they are not available.
+     *
+     *  Rather than the full (dataDim x amplitudeDim x nonlinearDim) derivative of the model matrix,
+     *  this computes its product with the amplitude vector, @f$\partial (B\alpha)/\partial\theta@f$,
+     *  which is all an optimizer needs to form the Jacobian of the residuals.
+     *
+     *  Subclasses that can compute these derivatives analytically should reimplement this method and
+     *  return true.  The default implementation returns false, indicating that numerical derivatives
+     *  must be used instead.
+     *
+     *  @param[out] modelDerivative  The dataDim x nonlinearDim matrix of derivatives.  It should be
+     *                               weighted if the data vector is.  Must be allocated, but need not
+     *                               be initialized.
+     *  @param[in] nonlinear     Vector of nonlinear parameters at which to evaluate the derivatives.
+     *  @param[in] amplitudes    Vector of linear parameters at which to evaluate the derivatives.
+     *  @param[in] doApplyWeights   If False, do not apply the weights to the derivatives.
+     */
+    virtual bool differentiateModel(
+        ndarray::Array<Scalar,2,-1> const & modelDerivative,
+        ndarray::Array<Scalar const,1,1> const & nonlinear,
+        ndarray::Array<Scalar const,1,1> const & amplitudes,
+        bool doApplyWeights=true
+    ) const {
+        return false;
+    }
+
     virtual ~Likelihood() {}
 
     // No copying
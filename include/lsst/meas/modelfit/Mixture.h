@@ -25,6 +25,7 @@
 #define LSST_MEAS_MODELFIT_Mixture_h_INCLUDED
 
 #include <limits>
+#include <vector>
 
 #include "Eigen/Cholesky"
 #include "Eigen/StdVector"
@@ -36,6 +37,7 @@
 #include "lsst/afw/math/Random.h"
 #include "lsst/afw/table/io/Persistable.h"
 #include "lsst/meas/modelfit/common.h"
+#include "lsst/meas/modelfit/CounterRandom.h"
 #include "lsst/afw/table/io/python.h"  // for declarePersistableFacade
 
 
@@ -97,7 +99,11 @@ private:
 
     void _stream(std::ostream & os, int offset=0) const;
 
+    // Recompute _sqrtDet and _maxSigmaEigenvalue from _sigmaLLT.
+    void _updateSigmaProperties();
+
     Scalar _sqrtDet;
+    Scalar _maxSigmaEigenvalue;
     Vector _mu;
     Eigen::LLT<Matrix> _sigmaLLT;
 };
@@ -125,6 +131,67 @@ private:
     int _dim;
 };
 
+class Mixture;
+
+/**
+ *  @brief Weighted sufficient statistics for an Expectation-Maximization update of a Mixture.
+ *
+ *  Mixture::accumulateEM adds the contributions of a batch of samples to these statistics, and
+ *  Mixture::updateEM(MixtureEMStatistics const &, ...) uses them to update the mixture parameters.
+ *  This makes it possible to run EM on sample sets that do not fit in memory at once (by accumulating
+ *  several batches before each update), to parallelize the expectation step (by accumulating separate
+ *  statistics in different threads and combining them with add()), and to run online or mini-batch EM
+ *  (by blending each new batch into a running average with scale() and add() before each update).
+ *
+ *  The statistics are computed relative to the component locations of the mixture they were
+ *  constructed from, and can only be used with mixtures with the same number of components and
+ *  dimensions.  Statistics relative to different locations (such as those from before and after an
+ *  update) may still be combined with add(), which shifts the moments to a common center.
+ */
+class MixtureEMStatistics {
+public:
+
+    /// Construct zero statistics for the given mixture.
+    explicit MixtureEMStatistics(Mixture const & mixture);
+
+    /// Return the number of components
+    int getComponentCount() const { return _weight.size(); }
+
+    /// Return the number of dimensions
+    int getDimension() const { return _dim; }
+
+    /// Return the total weight of all samples accumulated so far.
+    Scalar getTotalWeight() const { return _weight.sum(); }
+
+    /// Set all statistics to zero.
+    void reset();
+
+    /// Multiply all statistics by the given factor.
+    void scale(Scalar factor);
+
+    /// Add factor times the given statistics to these, shifting them to these statistics' centers.
+    void add(MixtureEMStatistics const & other, Scalar factor=1.0);
+
+private:
+
+    friend class Mixture;
+
+    int _dim;
+    Vector _weight;                  // sum of responsibilities r
+    Vector _gammaWeight;             // sum of r*gamma (gamma=1 for Gaussians)
+    std::vector<Vector> _center;     // reference point for the moments below (initial mu)
+    std::vector<Vector> _first;      // sum of r*gamma*(x - center)
+    std::vector<Matrix> _second;     // sum of r*gamma*(x - center)(x - center)^T
+};
+
+/**
+ *  @brief A weighted sum of Gaussian or Student's T distributions.
+ *
+ *  Const member functions (evaluation, derivatives, and drawing samples) do not modify any shared
+ *  state, so a single Mixture may be used concurrently from multiple threads as long as no thread
+ *  modifies it (via non-const member functions or mutable component access) at the same time.  Each
+ *  thread must use its own random number generator when drawing samples.
+ */
 class Mixture : public afw::table::io::PersistableFacade<Mixture>, public afw::table::io::Persistable {
 public:
 
@@ -189,6 +256,25 @@ public:
     /// Set the number of degrees of freedom in the component Student's T distributions (inf=Gaussian)
     void setDegreesOfFreedom(Scalar df=std::numeric_limits<Scalar>::infinity());
 
+    /**
+     *  @brief Set the relative tolerance used to skip negligible components when evaluating the PDF.
+     *
+     *  When the tolerance is nonzero, evaluation first computes a cheap upper bound on the contribution
+     *  of each component (using the largest eigenvalue of its sigma matrix in place of the full
+     *  Mahalanobis distance), then evaluates components in order of decreasing bound, stopping as soon
+     *  as the sum of the bounds of the remaining components is no more than the tolerance times the
+     *  running sum.  The result is never larger than the exact PDF, and is smaller by no more than
+     *  the tolerance times the exact value.  Components skipped this way are also omitted from
+     *  evaluateDerivatives (whose error is not formally bounded, but is of the same order).
+     *
+     *  The default tolerance is zero, which always evaluates all components.  The tolerance is not
+     *  persisted.
+     */
+    void setEvaluationTolerance(Scalar tolerance);
+
+    /// Return the relative tolerance used to skip negligible components (see setEvaluationTolerance).
+    Scalar getEvaluationTolerance() const { return _tolerance; }
+
     /**
      *  @brief Evaluate the probability density at the given point for the given component distribution.
      *
@@ -207,6 +293,10 @@ public:
      */
     template <typename Derived>
     Scalar evaluate(Eigen::MatrixBase<Derived> const & x) const {
+        if (_tolerance > 0.0) {
+            Scalar errorBound;
+            return evaluateWithErrorBound(x, errorBound);
+        }
         Scalar p = 0.0;
         for (const_iterator i = begin(); i != end(); ++i) {
             p += evaluate(*i, x);
@@ -214,6 +304,16 @@ public:
         return p;
     }
 
+    /**
+     *  @brief Evaluate the mixture PDF at the given point, and return a bound on the error due to
+     *         components skipped by the evaluation tolerance.
+     *
+     *  @param[in]  x           point to evaluate, shape=(dim,)
+     *  @param[out] errorBound  upper bound on the difference between the exact PDF and the
+     *                          returned value; zero if no components were skipped.
+     */
+    Scalar evaluateWithErrorBound(Eigen::Ref<Vector const> const & x, Scalar & errorBound) const;
+
     /**
      *  @brief Evaluate the distribution probability density function (PDF) at the given points
      *
@@ -281,6 +381,25 @@ public:
      */
     void draw(afw::math::Random & rng, ndarray::Array<Scalar,2,1> const & x) const;
 
+    /**
+     *  @brief Draw random variates from the distribution using a counter-based random number generator.
+     *
+     *  Sample i is drawn using only rng.getStream(offset + i), so the results depend only on the
+     *  generator's seed and source ID and on the sample indices, and are bitwise identical for any
+     *  number of threads.  The offset can be used to draw a large set of samples in several batches.
+     *
+     *  @param[in]  rng       counter-based random number generator
+     *  @param[out] x         array of points, shape=(numSamples, dim)
+     *  @param[in]  offset    index of the first sample, passed to CounterRandom::getStream
+     *  @param[in]  nThreads  number of threads to divide the samples between.
+     */
+    void draw(
+        CounterRandom const & rng,
+        ndarray::Array<Scalar,2,1> const & x,
+        std::uint64_t offset=0,
+        int nThreads=1
+    ) const;
+
     /**
      *  @brief Perform an Expectation-Maximization step, updating the component parameters to match
      *         the given weighted samples.
@@ -341,6 +460,40 @@ public:
         Scalar tau1=0.0, Scalar tau2=0.5
     );
 
+    /**
+     *  @brief Perform the Expectation step of an EM update, adding the contributions of the given
+     *         weighted samples to the given sufficient statistics.
+     *
+     *  Samples are processed in blocks, so memory use is independent of the number of samples.
+     *
+     *  @param[in] x         array of variables, shape=(numSamples, dim)
+     *  @param[in] w         array of weights, shape=(numSamples,)
+     *  @param[in,out] stats statistics to add to; must have been constructed from a mixture with
+     *                       the same number of components and dimensions.
+     *  @param[in] nThreads  number of threads to divide the samples between.
+     */
+    void accumulateEM(
+        ndarray::Array<Scalar const,2,1> const & x,
+        ndarray::Array<Scalar const,1,0> const & w,
+        MixtureEMStatistics & stats,
+        int nThreads=1
+    ) const;
+
+    /**
+     *  @brief Perform the Maximization step of an EM update, using sufficient statistics accumulated
+     *         by accumulateEM.
+     *
+     *  @param[in] stats         accumulated sufficient statistics
+     *  @param[in] restriction   Functor used to restrict the form of the updated mu and sigma
+     *  @param[in] tau1          damping parameter (see Mixture::updateEM)
+     *  @param[in] tau2          damping parameter (see Mixture::updateEM)
+     */
+    void updateEM(
+        MixtureEMStatistics const & stats,
+        UpdateRestriction const & restriction,
+        Scalar tau1=0.0, Scalar tau2=0.5
+    );
+
     /// Polymorphic deep copy
     virtual PTR(Mixture) clone() const;
 
@@ -380,11 +533,67 @@ private:
 
     template <typename Derived>
     Scalar _computeZ(Component const & component, Eigen::MatrixBase<Derived> const & x) const {
-        _workspace = x - component._mu;
-        component._sigmaLLT.matrixL().solveInPlace(_workspace);
-        return _workspace.squaredNorm();
+        // Per-thread scratch space, so const evaluation is thread-safe without allocating on every call.
+        static thread_local Vector workspace;
+        workspace = x - component._mu;
+        component._sigmaLLT.matrixL().solveInPlace(workspace);
+        return workspace.squaredNorm();
     }
 
+    // Evaluate the PDF at x, skipping negligible components according to _tolerance.  On return, the
+    // first nUsed elements of 'order' hold the component indices that were evaluated.
+    Scalar _evaluatePruned(
+        Eigen::Ref<Vector const> const & x,
+        std::vector<std::pair<Scalar,int>> & order,
+        int & nUsed,
+        Scalar & errorBound
+    ) const;
+
+    // Compute the squared Mahalanobis distances between a component and all points in x
+    // (shape=(nPoints, dim)), putting the results in the first nPoints elements of z; dx is workspace
+    // with at least nPoints columns.
+    template <typename Derived>
+    void _computeZBlock(
+        Component const & component,
+        Eigen::MatrixBase<Derived> const & x,
+        Matrix & dx,
+        Eigen::ArrayXd & z
+    ) const;
+
+    // Evaluate a component (including its weight) at all points in x (shape=(nPoints, dim)), putting
+    // the results in the first nPoints elements of z; dx is workspace with at least nPoints columns.
+    template <typename Derived>
+    void _evaluateBlock(
+        Component const & component,
+        Eigen::MatrixBase<Derived> const & x,
+        Matrix & dx,
+        Eigen::ArrayXd & z
+    ) const;
+
+    // Replace squared Mahalanobis distances with the (unweighted, normalized) component profile.
+    void _evaluateProfile(Eigen::Ref<Eigen::ArrayXd> z) const;
+
+    // Expectation step of updateEM for rows [begin, end) of x, which must be Eigen objects (not
+    // ndarray objects, as this may be called from multiple threads).
+    template <typename X, typename W>
+    void _accumulateEMRange(
+        X const & x, W const & w, int begin, int end,
+        MixtureEMStatistics & stats
+    ) const;
+
+    // Cumulative component weights, used to select a component when drawing.
+    std::vector<Scalar> _computeCumulativeWeights() const;
+
+    // Draw a single sample into x (dim contiguous elements); Rng may be afw::math::Random or
+    // CounterRandom::Stream.
+    template <typename Rng>
+    void _drawOne(
+        Rng & rng,
+        std::vector<Scalar> const & cumulative,
+        Vector & workspace,
+        Scalar * x
+    ) const;
+
     // Helper function used in updateEM
     void updateDampedSigma(int k, Matrix const & sigma, double tau1, double tau2);
 
@@ -396,7 +605,7 @@ private:
     int _dim;
     Scalar _df;
     Scalar _norm;
-    mutable Vector _workspace;
+    Scalar _tolerance;
     ComponentList _components;
 };
 
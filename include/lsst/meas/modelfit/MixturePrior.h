@@ -31,6 +31,10 @@ namespace lsst { namespace meas { namespace modelfit {
 
 /**
  *  @brief A prior that's flat in amplitude parameters, and uses a Mixture for nonlinear parameters.
+ *
+ *  All member functions are const and thread-safe (given a separate random number generator per
+ *  thread for drawAmplitudes), so a single MixturePrior may be shared between threads as long as its
+ *  Mixture is not modified.
  */
 class MixturePrior : public Prior {
 public:
@@ -43,6 +47,13 @@ public:
         ndarray::Array<Scalar const,1,1> const & amplitudes
     ) const override;
 
+    /// @copydoc Prior::evaluateBatch
+    void evaluateBatch(
+        ndarray::Array<Scalar const,2,1> const & nonlinear,
+        ndarray::Array<Scalar const,2,1> const & amplitudes,
+        ndarray::Array<Scalar,1,1> const & output
+    ) const override;
+
     /// @copydoc Prior::evaluateDerivatives
     void evaluateDerivatives(
         ndarray::Array<Scalar const,1,1> const & nonlinear,
@@ -24,11 +24,16 @@
 #ifndef LSST_MEAS_MODELFIT_PixelFitRegion_h_INCLUDED
 #define LSST_MEAS_MODELFIT_PixelFitRegion_h_INCLUDED
 
+#include <cstdint>
+#include <vector>
+
 #include "lsst/pex/config.h"
 #include "lsst/meas/modelfit/common.h"
+#include "lsst/geom/Box.h"
 #include "lsst/geom/Point.h"
 #include "lsst/afw/image/Mask.h"
 #include "lsst/afw/detection/Footprint.h"
+#include "lsst/afw/geom/SpanSet.h"
 #include "lsst/afw/geom/ellipses.h"
 
 namespace lsst { namespace meas { namespace modelfit {
@@ -43,7 +48,9 @@ struct PixelFitRegionControl {
         nFitRadiiMin(1.0),
         nFitRadiiMax(3.0),
         maxArea(100000),
-        maxBadPixelFraction(0.1)
+        maxBadPixelFraction(0.1),
+        maxTrimSignalToNoise(0.0),
+        informationFraction(0.99)
     {
         badMaskPlanes.push_back("EDGE");
         badMaskPlanes.push_back("SAT");
@@ -97,6 +104,104 @@ struct PixelFitRegionControl {
         "more than this and we don't even try."
     );
 
+    LSST_CONTROL_FIELD(
+        maxTrimSignalToNoise, double,
+        "Trim the final fit region of sources whose initial-fit signal-to-noise ratio is below this value "
+        "to the ellipse containing informationFraction of the expected Fisher information on the flux; "
+        "0 disables trimming.  For galaxies with r~2 pixels and a 2-pixel PSF, trimming to 0.99 uses ~30% "
+        "fewer pixels than the default region and increases the flux scatter by ~0.3%."
+    );
+
+    LSST_CONTROL_FIELD(
+        informationFraction, double,
+        "Fraction of the expected flux Fisher information the final fit region must contain when it is "
+        "trimmed (see maxTrimSignalToNoise)."
+    );
+
+};
+
+
+/**
+ *  @brief A packed, one-bit-per-pixel snapshot of the pixels in a Mask with any of a set of bits set.
+ *
+ *  BadPixelBitmap lets PixelFitRegion rasterize its ellipse and remove bad pixels in a single pass,
+ *  and lets the (comparatively expensive) unpacking of the mask and resolution of mask plane names
+ *  be done once per exposure rather than once per source.
+ *
+ *  A BadPixelBitmap is a snapshot; it does not reflect changes made to the mask after it was
+ *  constructed, and it does not keep the mask alive.  Use isSnapshotOf to check whether it was made
+ *  from a mask before reusing it.  It is immutable, and hence may be shared between threads.
+ */
+class BadPixelBitmap {
+public:
+
+    /**
+     *  Construct from the given region of a mask (which must be contained by the mask's bounding
+     *  box, in PARENT coordinates), or all of it if the region is empty.
+     */
+    BadPixelBitmap(
+        afw::image::Mask<> const & mask,
+        afw::image::MaskPixel badPixelMask,
+        geom::Box2I const & bbox=geom::Box2I()
+    );
+
+    /// Return the bitmask corresponding to the given mask plane names.
+    static afw::image::MaskPixel getPlaneBitMask(std::vector<std::string> const & planes);
+
+    /// Return the bounding box (in PARENT coordinates) covered by the bitmap.
+    geom::Box2I getBBox() const { return _bbox; }
+
+    /// Return the bitmask of pixels the bitmap considers bad.
+    afw::image::MaskPixel getBadPixelMask() const { return _badPixelMask; }
+
+    /**
+     *  Return true if the bitmap was constructed from all of the given mask.
+     *
+     *  This compares only the bounding box and the address and layout of the mask's pixels, and hence
+     *  takes constant time; it cannot detect changes made to the mask's pixels in place, or a mask that
+     *  has been freed and replaced by another at the same address.  Callers that reuse a bitmap must
+     *  ensure neither happens while it is in use.
+     */
+    bool isSnapshotOf(afw::image::Mask<> const & mask) const;
+
+    /// Return true if the given pixel (in PARENT coordinates, within getBBox()) is bad.
+    bool isBad(int x, int y) const {
+        int i = x - _bbox.getMinX();
+        return (_row(y)[i >> 6] >> (i & 63)) & 0x1;
+    }
+
+    /**
+     *  Rasterize an ellipse, returning only its good pixels.
+     *
+     *  The ellipse is rasterized exactly as in afw::geom::SpanSet::fromShape, then clipped to the
+     *  bitmap's bounding box, and bad pixels are removed, all in a single pass.
+     *
+     *  @param[in]  ellipse   Ellipse to rasterize.
+     *  @param[out] nTotal    Number of pixels in the ellipse and the bounding box (good or bad).
+     *  @param[out] nGood     Number of good pixels in the result.
+     */
+    std::shared_ptr<afw::geom::SpanSet> rasterize(
+        afw::geom::ellipses::Ellipse const & ellipse,
+        int & nTotal,
+        int & nGood
+    ) const;
+
+private:
+
+    std::uint64_t const * _row(int y) const {
+        return _bits.data() + (y - _bbox.getMinY())*_wordsPerRow;
+    }
+
+    // Return the position of the first pixel in [begin, end) of the given row with the given
+    // state (true for bad), or end if there is none; positions are relative to the bbox min x.
+    int _find(std::uint64_t const * row, int begin, int end, bool bad) const;
+
+    geom::Box2I _bbox;
+    afw::image::MaskPixel _badPixelMask;
+    afw::image::MaskPixel const * _maskData;  // identifies the mask's pixels; never dereferenced
+    ndarray::Vector<ndarray::Offset,2> _maskStrides;
+    int _wordsPerRow;
+    std::vector<std::uint64_t> _bits;
 };
 
 
@@ -116,13 +221,35 @@ public:
         afw::geom::ellipses::Quadrupole const & ellipse
     );
 
+    /**
+     *  Set the region ellipse from the deconvolved ellipse of an initial fit.
+     *
+     *  If signalToNoise is positive and below the control object's maxTrimSignalToNoise, the region is
+     *  then shrunk (if necessary) to the ellipse that contains informationFraction of the expected
+     *  Fisher information on the flux, approximating the PSF-convolved model as a Gaussian with the
+     *  moments of the deconvolved ellipse convolved with psfMoments.  For such a Gaussian (and uniform
+     *  noise) the information within r times its moments ellipse is 1 - exp(-r^2); the pixels beyond
+     *  that add cost to the fit but little information, which matters most for faint sources.
+     *
+     *  @return true if the ellipse was set by one of the configuration bounds or trimmed.
+     */
     bool applyEllipse(
         afw::geom::ellipses::Quadrupole const & deconvolved,
-        afw::geom::ellipses::Quadrupole const & psfMoments
+        afw::geom::ellipses::Quadrupole const & psfMoments,
+        Scalar signalToNoise=-1.0
     );
 
     void applyMask(afw::image::Mask<> const & mask, geom::Point2D const & center);
 
+    /**
+     *  Set the footprint to the good pixels of the fit region, using a bad pixel bitmap
+     *  precomputed for the full exposure.
+     *
+     *  This is equivalent to the Mask overload, but the bitmap's bad pixel mask is used instead of
+     *  the control object's badMaskPlanes, and the mask does not have to be unpacked again.
+     */
+    void applyMask(BadPixelBitmap const & bitmap, geom::Point2D const & center);
+
     afw::geom::ellipses::Quadrupole ellipse;
     PTR(afw::detection::Footprint) footprint;
     bool usedFootprintArea;
@@ -131,10 +258,10 @@ public:
     bool maxBadPixelFraction;
     bool usedMinEllipse;
     bool usedMaxEllipse;
+    bool usedInformationTrim;
 
 private:
     PixelFitRegionControl _ctrl;
-    afw::image::MaskPixel _badPixelMask;
 };
 
 
@@ -49,6 +49,23 @@ public:
         ndarray::Array<Scalar const,1,1> const & amplitudes
     ) const = 0;
 
+    /**
+     *  @brief Evaluate the prior at many points in nonlinear and amplitude space.
+     *
+     *  The default implementation just calls evaluate() on each point; subclasses should override
+     *  it when they can avoid the per-point overhead.
+     *
+     *  @param[in]   nonlinear        Nonlinear parameters, with shape (nPoints, nonlinearDim).
+     *  @param[in]   amplitudes       Linear parameters, with shape (nPoints, amplitudeDim).
+     *  @param[out]  output           Prior values, with shape (nPoints).  Must be allocated, but
+     *                                need not be initialized.
+     */
+    virtual void evaluateBatch(
+        ndarray::Array<Scalar const,2,1> const & nonlinear,
+        ndarray::Array<Scalar const,2,1> const & amplitudes,
+        ndarray::Array<Scalar,1,1> const & output
+    ) const;
+
     /**
      *  @brief Evaluate the derivatives of the prior at the given point in nonlinear and amplitude space.
      *
@@ -172,6 +189,13 @@ protected:
 
     explicit Prior(std::string const & tag="") : _tag(tag) {}
 
+    // Throw LengthError if the arguments to evaluateBatch do not have consistent shapes.
+    static void _checkBatchShapes(
+        ndarray::Array<Scalar const,2,1> const & nonlinear,
+        ndarray::Array<Scalar const,2,1> const & amplitudes,
+        ndarray::Array<Scalar,1,1> const & output
+    );
+
 private:
     std::string _tag;
 };
@@ -0,0 +1,113 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+#ifndef LSST_MEAS_MODELFIT_PsfFitCache_h_INCLUDED
+#define LSST_MEAS_MODELFIT_PsfFitCache_h_INCLUDED
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "lsst/geom/Point.h"
+#include "lsst/afw/detection/Psf.h"
+#include "lsst/shapelet/MultiShapeletFunction.h"
+#include "lsst/meas/modelfit/common.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+/**
+ *  @brief A thread-safe cache of recently converged PSF approximations, used to warm-start fits
+ *         at nearby positions on the same exposure.
+ *
+ *  Because PSF models vary slowly across the focal plane, a multi-shapelet approximation fit at one
+ *  position is usually a much better starting point for a fit at a nearby position than one derived
+ *  from image moments alone.  PsfFitCache holds the most recent fits (in kernel-image coordinates,
+ *  with the PSF centered at (0,0)) along with the positions at which they were computed.
+ *
+ *  The cache is bound to a single Psf object: inserting a fit for a different Psf discards all
+ *  previous entries, and lookups with a different Psf never succeed.  All methods lock an internal
+ *  mutex, so a single cache may be shared between threads; lookups always return the most recently
+ *  inserted match, so results are deterministic as long as the order of insertions is.
+ */
+class PsfFitCache {
+public:
+
+    /**
+     *  Construct an empty cache.
+     *
+     *  @param[in] maxDistance  Maximum distance (in pixels) between the position of a cached fit and
+     *                          the position at which it may be used as a starting point.
+     *  @param[in] maxSize      Maximum number of fits to retain; older fits are discarded first.
+     */
+    explicit PsfFitCache(Scalar maxDistance, int maxSize=16);
+
+    /// Return the maximum distance at which a cached fit may be used.
+    Scalar getMaxDistance() const { return _maxDistance; }
+
+    /// Return the maximum number of fits retained.
+    int getMaxSize() const { return _maxSize; }
+
+    /// Return the number of fits currently in the cache.
+    int getSize() const;
+
+    /**
+     *  Return a copy of the most recently inserted fit within getMaxDistance() of the given position,
+     *  or an empty pointer if there is none (or the cache is bound to a different Psf).
+     */
+    PTR(shapelet::MultiShapeletFunction) find(
+        PTR(afw::detection::Psf const) psf,
+        geom::Point2D const & position
+    ) const;
+
+    /**
+     *  Add a converged fit to the cache.
+     *
+     *  If the cache is currently bound to a different Psf, all previous entries are discarded first.
+     */
+    void insert(
+        PTR(afw::detection::Psf const) psf,
+        geom::Point2D const & position,
+        shapelet::MultiShapeletFunction const & fit
+    );
+
+    /// Remove all entries from the cache.
+    void clear();
+
+private:
+
+    struct Entry {
+        geom::Point2D position;
+        shapelet::MultiShapeletFunction fit;
+    };
+
+    Scalar _maxDistance;
+    int _maxSize;
+    mutable std::mutex _mutex;
+    std::weak_ptr<afw::detection::Psf const> _psf;
+    std::deque<Entry> _entries;
+};
+
+}}} // namespace lsst::meas::modelfit
+
+#endif // !LSST_MEAS_MODELFIT_PsfFitCache_h_INCLUDED
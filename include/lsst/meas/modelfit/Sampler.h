@@ -24,15 +24,47 @@
 #ifndef LSST_MEAS_MODELFIT_Sampler_h_INCLUDED
 #define LSST_MEAS_MODELFIT_Sampler_h_INCLUDED
 
+#include <memory>
+
 #include "lsst/afw/table/fwd.h"
 #include "lsst/meas/modelfit/Mixture.h"
 #include "lsst/meas/modelfit/Likelihood.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
+/**
+ *  @brief Objective function (usually -log posterior) evaluated by a Sampler for each sample.
+ *
+ *  Samplers may evaluate the objective for many samples concurrently if isThreadSafe() returns true.
+ *  Subclasses that support this must override evaluate() to use only the Workspace they are given
+ *  (rather than the shared _modelMatrix member), must not modify any other state, and must not copy
+ *  or create ndarray objects that share memory with the arguments or with each other's workspaces (as
+ *  ndarray reference counts are not thread-safe).  Each thread is given its own Workspace from
+ *  makeWorkspace() (which is always called serially), and its own sample records.
+ */
 class SamplingObjective {
 public:
 
+    /**
+     *  @brief Per-thread state for evaluate().
+     *
+     *  Subclasses of SamplingObjective may subclass this to hold additional state, and override
+     *  makeWorkspace() to create it.
+     */
+    class Workspace {
+    public:
+
+        explicit Workspace(ndarray::Array<Pixel,2,-1> const & modelMatrix_) : modelMatrix(modelMatrix_) {}
+
+        Workspace(Workspace const &) = delete;
+        Workspace & operator=(Workspace const &) = delete;
+
+        virtual ~Workspace() {}
+
+        /// Model matrix with shape (dataDim, amplitudeDim), as returned by makeModelMatrix().
+        ndarray::Array<Pixel,2,-1> modelMatrix;
+    };
+
     virtual int getParameterDim() const = 0;
 
     virtual Scalar operator()(
@@ -40,6 +72,30 @@ public:
         afw::table::BaseRecord & sample
     ) const = 0;
 
+    /**
+     *  @brief Evaluate the objective using the given workspace.
+     *
+     *  @param[in]  parameters   Parameter vector for the sample.
+     *  @param[out] sample       Record for the sample, which may be used to save additional values.
+     *  @param[in]  workspace    Workspace returned by makeWorkspace().
+     *
+     *  The default implementation ignores the workspace and delegates to operator().
+     */
+    virtual Scalar evaluate(
+        ndarray::Array<Scalar const,1,1> const & parameters,
+        afw::table::BaseRecord & sample,
+        Workspace & workspace
+    ) const;
+
+    /// Return true if evaluate() may be called concurrently from multiple threads (see class docs).
+    virtual bool isThreadSafe() const { return false; }
+
+    /// Create a new workspace for use with evaluate().
+    virtual std::unique_ptr<Workspace> makeWorkspace() const;
+
+    /// Allocate a new model matrix with shape (dataDim, amplitudeDim).
+    ndarray::Array<Pixel,2,-1> makeModelMatrix() const;
+
     virtual ~SamplingObjective() {}
 
 protected:
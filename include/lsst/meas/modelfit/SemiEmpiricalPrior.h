@@ -67,10 +67,18 @@ struct SemiEmpiricalPriorControl {
         "Number of degrees of freedom for the Student's T distribution on ln(radius)."
     );
 
+    LSST_CONTROL_FIELD(
+        tabulationTolerance, double,
+        "If positive, evaluate the ln(radius) tail and the ellipticity profile (and their derivatives) "
+        "from precomputed tables whose maximum error, relative to the peak of each tabulated quantity, "
+        "has been verified to be less than this value.  Zero disables tabulation."
+    );
+
     SemiEmpiricalPriorControl() :
         ellipticitySigma(0.3), ellipticityCore(0.001),
         logRadiusMinOuter(-6.001), logRadiusMinInner(-6.0),
-        logRadiusMu(-1.0), logRadiusSigma(0.45), logRadiusNu(50.0)
+        logRadiusMu(-1.0), logRadiusSigma(0.45), logRadiusNu(50.0),
+        tabulationTolerance(0.0)
     {}
 
     /// Raise InvalidParameterException if the configuration options are invalid.
@@ -80,6 +88,13 @@ struct SemiEmpiricalPriorControl {
 
 /**
  *  @brief A piecewise prior motivated by both real distributions and practical considerations.
+ *
+ *  When SemiEmpiricalPriorControl::tabulationTolerance is positive, the transcendental parts of the
+ *  prior (the Student's T tail in ln(radius) and the exponential ellipticity profile) are replaced by
+ *  piecewise quintic Hermite tables built at construction.  The number of table points is doubled
+ *  until the error measured at points between the nodes is below the tolerance; the achieved error
+ *  is available from getTabulationError().  Arguments outside the tabulated ranges (where the prior
+ *  is negligible) fall back to direct evaluation.
  */
 class SemiEmpiricalPrior : public Prior {
 public:
@@ -94,6 +109,13 @@ public:
         ndarray::Array<Scalar const,1,1> const & amplitudes
     ) const override;
 
+    /// @copydoc Prior::evaluateBatch
+    void evaluateBatch(
+        ndarray::Array<Scalar const,2,1> const & nonlinear,
+        ndarray::Array<Scalar const,2,1> const & amplitudes,
+        ndarray::Array<Scalar,1,1> const & output
+    ) const override;
+
     /// @copydoc Prior::evaluateDerivatives
     void evaluateDerivatives(
         ndarray::Array<Scalar const,1,1> const & nonlinear,
@@ -128,6 +150,12 @@ public:
         bool multiplyWeights=false
     ) const override;
 
+    /**
+     *  Return the maximum relative error of the tables used to evaluate the prior, as measured when
+     *  they were built, or zero if the prior is evaluated directly.
+     */
+    Scalar getTabulationError() const;
+
 private:
 
     struct Impl;
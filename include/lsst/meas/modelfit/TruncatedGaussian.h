@@ -30,6 +30,7 @@
 #include "lsst/base.h"
 #include "lsst/afw/math/Random.h"
 #include "lsst/meas/modelfit/common.h"
+#include "lsst/meas/modelfit/CounterRandom.h"
 
 // TODO: we should really integrate this with Mixture somehow
 
@@ -153,6 +154,32 @@ public:
      */
     static TruncatedGaussian fromStandardParameters(Vector const & mean, Matrix const & covariance);
 
+    /**
+     *  @brief Find the maximum of a truncated Gaussian given its series parameters, in any dimension.
+     *
+     *  This solves the non-negative quadratic program
+     *  @f[
+     *    \min_{\alpha \ge 0} \; g^T \alpha + \frac{1}{2}\alpha^T H \alpha
+     *  @f]
+     *  with the Lawson-Hanson active-set algorithm, without computing the integrals needed to construct
+     *  a TruncatedGaussian (which are only available in one and two dimensions).  It is intended for
+     *  positivity-constrained linear fits with many amplitudes.
+     *
+     *  @param[in] gradient     Vector of first derivatives @f$g@f$
+     *  @param[in] hessian      Matrix of second derivatives @f$H@f$ (symmetric positive semidefinite)
+     *  @param[in] initial      Optional starting point (e.g. the solution to a similar problem); its
+     *                          positive elements set the initial set of unconstrained parameters.
+     *                          Must be empty or have the same size as gradient.
+     *
+     *  @throws pex::exceptions::RuntimeError if the active-set iteration limit (5 times one more than
+     *          the dimension) is reached, which should only happen for badly-conditioned problems.
+     */
+    static Vector maximizeSeries(
+        Vector const & gradient,
+        Matrix const & hessian,
+        Vector const & initial=Vector()
+    );
+
     /**
      *  @brief Create a Sampler object that uses the given strategy
      *
@@ -187,6 +214,9 @@ public:
      *  This is simply the untruncated location parameter mu if all of its elements are positive;
      *  otherwise, one or more elements will be zero (and the rest may not be same as the elements
      *  of mu).
+     *
+     *  In one and two dimensions the maximum is found in closed form, by comparing the candidate
+     *  solutions for each set of components held at zero; otherwise maximizeSeries() is used.
      */
     Vector maximize() const;
 
@@ -241,6 +271,8 @@ private:
 
 /**
  *  @brief Helper class for evaluating the -log of a TruncatedGaussian
+ *
+ *  Evaluation does not modify the evaluator, so a single instance may be shared between threads.
  */
 class TruncatedGaussianLogEvaluator {
 public:
@@ -250,8 +282,15 @@ public:
     template <typename Derived>
     Scalar operator()(Eigen::MatrixBase<Derived> const & alpha) const {
         if ((alpha.array() < 0.0).any()) return std::numeric_limits<Scalar>::infinity();
-        _workspace = alpha - _mu;
-        return 0.5*(_rootH*_workspace).squaredNorm() + _norm;
+        if (_mu.size() == 2) {
+            // Fixed-size fast path for the common case (e.g. CModel's exp+dev linear fit).
+            Eigen::Vector2d delta = alpha.template head<2>() - _mu.template head<2>();
+            return 0.5*(_rootH.template topLeftCorner<2,2>()*delta).squaredNorm() + _norm;
+        }
+        // Per-thread scratch space, so evaluation is thread-safe without allocating on every call.
+        static thread_local Vector workspace;
+        workspace = alpha - _mu;
+        return 0.5*(_rootH*workspace).squaredNorm() + _norm;
     }
 
     Scalar operator()(ndarray::Array<Scalar const,1,1> const & alpha) const;
@@ -264,7 +303,6 @@ public:
 protected:
     Scalar _norm;
     Vector _mu;
-    mutable Vector _workspace;
     Matrix _rootH;
 };
 
@@ -296,6 +334,10 @@ private:
 
 /**
  *  @brief Helper class for drawing samples from a TruncatedGaussian
+ *
+ *  Drawing with a CounterRandom is reproducible and may be parallelized: sample i is drawn using only
+ *  rng.getStream(offset + i), so the results are bitwise identical for any number of threads.  A single
+ *  Sampler may be used from multiple threads, but each thread must use its own afw::math::Random.
  */
 class TruncatedGaussianSampler {
 public:
@@ -315,6 +357,16 @@ public:
      */
     Scalar operator()(afw::math::Random & rng, ndarray::Array<Scalar,1,1> const & alpha) const;
 
+    /**
+     *  @brief Draw a single sample from a TruncatedGaussian using a counter-based random stream
+     *
+     *  @param[in,out] rng   Random number stream for this sample
+     *  @param[out] alpha    Output sample vector to fill
+     *
+     *  @return the weight of the sample (always betweeen 0 and 1)
+     */
+    Scalar operator()(CounterRandom::Stream & rng, ndarray::Array<Scalar,1,1> const & alpha) const;
+
     /**
      *  @brief Draw multiple samples from a TruncatedGaussian
      *
@@ -323,19 +375,50 @@ public:
      *  @param[out] weights  Output weight vector to fill
      *  @param[in]  multiplyWeights  If true, multiply the weights vector by the weights rather than
      *                               fill it.
+     *
+     *  @return the average number of candidate samples drawn per output sample; this is always one for
+     *          ALIGN_AND_WEIGHT, and the inverse of the acceptance rate for DIRECT_WITH_REJECTION, so it
+     *          can be used to switch strategies adaptively.
+     *
+     *  With DIRECT_WITH_REJECTION, candidates are drawn, transformed, and tested in batches; the accepted
+     *  samples (and the state of the random number generator afterwards) are the same as if they had
+     *  been drawn one at a time.
      */
-    void operator()(
+    Scalar operator()(
         afw::math::Random & rng,
         ndarray::Array<Scalar,2,1> const & alpha,
         ndarray::Array<Scalar,1,1> const & weights,
         bool multiplyWeights=false
     ) const;
 
+    /**
+     *  @brief Draw multiple samples from a TruncatedGaussian using a counter-based random number generator
+     *
+     *  @param[in]  rng      Counter-based random number generator
+     *  @param[out] alpha    Output sample vector to fill; first dimension sets the number of samples
+     *  @param[out] weights  Output weight vector to fill
+     *  @param[in]  multiplyWeights  If true, multiply the weights vector by the weights rather than
+     *                               fill it.
+     *  @param[in]  offset   Index of the first sample, passed to CounterRandom::getStream
+     *  @param[in]  nThreads Number of threads to divide the samples between
+     *
+     *  @return the average number of candidate samples drawn per output sample
+     */
+    Scalar operator()(
+        CounterRandom const & rng,
+        ndarray::Array<Scalar,2,1> const & alpha,
+        ndarray::Array<Scalar,1,1> const & weights,
+        bool multiplyWeights=false,
+        std::uint64_t offset=0,
+        int nThreads=1
+    ) const;
+
     ~TruncatedGaussianSampler(); // defined in .cc so it can see Impl's dtor
 
     class Impl; // public so we can inherit from it in the .cc file
 
 private:
+    int _dim;
     PTR(Impl) _impl;
 };
 
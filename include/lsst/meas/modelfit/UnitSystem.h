@@ -29,6 +29,7 @@
 #include "lsst/afw/geom/SkyWcs.h"
 #include "lsst/afw/image/PhotoCalib.h"
 #include "lsst/geom/AffineTransform.h"
+#include "lsst/geom/LinearTransform.h"
 
 #include "lsst/meas/modelfit/common.h"
 
@@ -70,6 +71,8 @@ private:
     static std::shared_ptr<const afw::image::PhotoCalib> getDefaultPhotoCalib();
 };
 
+class WcsLinearizationCache;
+
 /**
  *  @brief A local mapping between two UnitSystems
  *
@@ -90,8 +93,63 @@ struct LocalUnitTransform {
     LocalUnitTransform(geom::Point2D const& sourcePixel, UnitSystem const& source,
                        UnitSystem const& destination);
 
+    /// Construct from its components; the surface brightness factor is computed from the other two.
+    LocalUnitTransform(geom::AffineTransform const& geometric_, double flux_)
+            : geometric(geometric_), flux(flux_), sb(flux_ / geometric_.getLinear().computeDeterminant()) {}
+
+    /**
+     *  @brief Construct the transform from a "standard" UnitSystem to another UnitSystem analytically.
+     *
+     *  The result is equivalent to
+     *  @code
+     *  UnitSystem standard(destination.wcs->pixelToSky(destinationPixel), destination.photoCalib, flux);
+     *  LocalUnitTransform(geom::Point2D(0.0, 0.0), standard, destination);
+     *  @endcode
+     *  but avoids constructing the standard system's Wcs and PhotoCalib (and the Wcs pair transform
+     *  between them); instead the tangent-plane Jacobian of the standard system is composed with the
+     *  local linearization of the destination Wcs at destinationPixel.  This is much cheaper when it
+     *  must be done for every source.
+     *
+     *  @param[in] destinationPixel  Position of the object in destination pixel coordinates, which
+     *                               defines the center of the standard system.
+     *  @param[in] flux              Flux (in destination units) that is unit flux in the standard system.
+     *  @param[in] destination       UnitSystem to transform to.
+     */
+    static LocalUnitTransform fromStandard(geom::Point2D const& destinationPixel, double flux,
+                                           UnitSystem const& destination);
+
+    /**
+     *  @brief Construct the transform from a "standard" UnitSystem to another UnitSystem, using a
+     *         cache of linearizations of the destination Wcs.
+     *
+     *  The cache must have been constructed from destination.wcs.
+     */
+    static LocalUnitTransform fromStandard(geom::Point2D const& destinationPixel, double flux,
+                                           UnitSystem const& destination,
+                                           WcsLinearizationCache const& cache);
+
+    /**
+     *  @brief Construct the transform between two UnitSystems from their local linearizations.
+     *
+     *  The two pixel positions must correspond to the same sky position, and the linear transforms
+     *  must map each system's pixels to the plane tangent to the sky at that position (see
+     *  WcsLinearizationCache::computePixelToTangent).  This is equivalent to (but much cheaper than)
+     *  LocalUnitTransform(sourcePixel, source, destination) when the linearizations are cached.
+     */
+    static LocalUnitTransform fromJacobians(geom::Point2D const& sourcePixel,
+                                            geom::LinearTransform const& sourceToTangent,
+                                            UnitSystem const& source,
+                                            geom::Point2D const& destinationPixel,
+                                            geom::LinearTransform const& destinationToTangent,
+                                            UnitSystem const& destination);
+
     /// Construct an identity transform for both geometry and flux.
     LocalUnitTransform() : geometric(), flux(1.0), sb(1.0) {}
+
+private:
+    static LocalUnitTransform _fromStandard(geom::Point2D const& destinationPixel, double flux,
+                                            UnitSystem const& destination,
+                                            geom::LinearTransform const& destinationToTangent);
 };
 
 }  // namespace modelfit
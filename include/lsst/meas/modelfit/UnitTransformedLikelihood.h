@@ -39,6 +39,7 @@
 #include "lsst/meas/modelfit/Model.h"
 #include "lsst/meas/modelfit/Likelihood.h"
 #include "lsst/meas/modelfit/UnitSystem.h"
+#include "lsst/meas/modelfit/WcsLinearizationCache.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
@@ -75,16 +76,20 @@ public:
      * @param[in] footprint     Footprint of source (galaxy) on calexp
      * @param[in] exposure      Subregion of calexp that includes footprint
      * @param[in] psf           Multi-shapelet representation of exposure PSF evaluated at location of galaxy
+     * @param[in] wcsCache      Optional cache of linearizations of the exposure's Wcs, used to avoid
+     *                          building a Wcs pair transform for every source.
      */
     explicit EpochFootprint(
         afw::detection::Footprint const &footprint,
         afw::image::Exposure<Pixel> const &exposure,
-        shapelet::MultiShapeletFunction const &psf
+        shapelet::MultiShapeletFunction const &psf,
+        PTR(WcsLinearizationCache const) wcsCache=PTR(WcsLinearizationCache const)()
     );
 
     afw::detection::Footprint const footprint;  ///< footprint of source (galaxy)
     afw::image::Exposure<Pixel> const exposure; ///< subregion of exposure that includes footprint
     shapelet::MultiShapeletFunction const psf;   ///< multi-shapelet model of exposure PSF
+    PTR(WcsLinearizationCache const) const wcsCache; ///< linearizations of the exposure Wcs (may be null)
 };
 
 /**
@@ -151,6 +156,31 @@ public:
         UnitTransformedLikelihoodControl const & ctrl
     );
 
+    /**
+     * @brief Initialize a UnitTransformedLikelihood with data from a single exposure, using a
+     *        precomputed transform from the fit system to the exposure.
+     *
+     * This avoids re-evaluating the fit system's Wcs when the caller already has the local transform
+     * (e.g. from LocalUnitTransform::fromStandard).
+     *
+     * @param[in] model             Object that defines the model to fit and its parameters.
+     * @param[in] fixed             Model parameters that are held fixed.
+     * @param[in] fitSysToMeasSys   Local transform from the fit system to the exposure's system
+     * @param[in] exposure          Exposure containing the data to fit
+     * @param[in] footprint         Footprint that defines the pixels to include in the fit
+     * @param[in] psf               Shapelet approximation to the PSF
+     * @param[in] ctrl              Control object with various options
+     */
+    explicit UnitTransformedLikelihood(
+        PTR(Model) model,
+        ndarray::Array<Scalar const,1,1> const & fixed,
+        LocalUnitTransform const & fitSysToMeasSys,
+        afw::image::Exposure<Pixel> const & exposure,
+        afw::detection::Footprint const & footprint,
+        shapelet::MultiShapeletFunction const & psf,
+        UnitTransformedLikelihoodControl const & ctrl
+    );
+
     virtual ~UnitTransformedLikelihood();
 
 private:
@@ -0,0 +1,140 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_MODELFIT_WcsLinearizationCache_h_INCLUDED
+#define LSST_MEAS_MODELFIT_WcsLinearizationCache_h_INCLUDED
+
+#include <memory>
+#include <vector>
+
+#include "lsst/geom/Box.h"
+#include "lsst/geom/LinearTransform.h"
+#include "lsst/afw/geom/SkyWcs.h"
+
+#include "lsst/meas/modelfit/common.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+/**
+ *  @brief A precomputed grid of local Wcs Jacobians over an exposure's bounding box.
+ *
+ *  The quantity cached is the Jacobian of the mapping from pixel coordinates to the plane tangent to
+ *  the sky at that pixel, with (east, north) axes in radians; this is smooth everywhere on the sky
+ *  (unlike the Jacobian of the mapping to (ra, dec)), and it is all that is needed to relate the
+ *  local geometry of two Wcss at a common sky position (see LocalUnitTransform).
+ *
+ *  The Jacobian is evaluated exactly on a regular grid and bilinearly interpolated in between.
+ *  The error of bilinear interpolation within a cell of size (dx, dy) is at most
+ *  (dx^2/8) max|J_xx| + (dy^2/8) max|J_yy|, and the grid is refined until this is within the requested
+ *  relative tolerance in every cell.  The second derivatives are not known analytically; they are
+ *  estimated from second differences of the grid values at the cell's corners, inflated by a safety
+ *  factor of two, and the exact error at each cell's center is checked as well.  The result is hence a
+ *  reliable bound only for Wcss whose second derivatives vary by less than that factor within a cell,
+ *  which is true of smooth (e.g. TAN-SIP) Wcss on the scale of any grid that meets the tolerance.
+ *  If the tolerance cannot be met with a reasonably-sized grid, or for points outside the bounding box,
+ *  the Jacobian is computed exactly on every call instead.
+ *
+ *  A WcsLinearizationCache is immutable after construction, and hence may be shared freely between
+ *  threads; use get() to share a single cache for an exposure between measurement plugins.
+ */
+class WcsLinearizationCache {
+public:
+
+    /**
+     *  Construct a cache by evaluating the Jacobian of the given Wcs on a grid.
+     *
+     *  @param[in] wcs             Wcs to linearize.
+     *  @param[in] bbox            Pixel bounding box the grid should cover.
+     *  @param[in] tolerance       Maximum relative error (with respect to the largest element of the
+     *                             exact Jacobian) of interpolated Jacobians.
+     *  @param[in] initialSpacing  Grid spacing (in pixels) to start refining from.
+     */
+    WcsLinearizationCache(
+        std::shared_ptr<afw::geom::SkyWcs const> wcs,
+        geom::Box2I const & bbox,
+        Scalar tolerance=1E-6,
+        int initialSpacing=256
+    );
+
+    /**
+     *  Return a cache for the given Wcs and bounding box, shared with any other callers that have
+     *  requested one with the same arguments.
+     *
+     *  Caches are identified by the address of the Wcs (not its value); a small number of the most
+     *  recently requested caches are retained between calls.  This function is thread-safe.
+     */
+    static std::shared_ptr<WcsLinearizationCache const> get(
+        std::shared_ptr<afw::geom::SkyWcs const> const & wcs,
+        geom::Box2I const & bbox,
+        Scalar tolerance=1E-6
+    );
+
+    /// Compute the Jacobian from pixels to the local tangent plane (radians) directly from a Wcs.
+    static geom::LinearTransform computePixelToTangent(
+        afw::geom::SkyWcs const & wcs,
+        geom::Point2D const & pixel
+    );
+
+    /// Return the Jacobian from pixels to the local tangent plane (radians) at the given pixel.
+    geom::LinearTransform getPixelToTangent(geom::Point2D const & pixel) const;
+
+    /// Return the Wcs this cache linearizes.
+    std::shared_ptr<afw::geom::SkyWcs const> getWcs() const { return _wcs; }
+
+    /// Return the pixel bounding box covered by the grid.
+    geom::Box2I getBBox() const { return _bbox; }
+
+    /// Return the maximum relative error of interpolated Jacobians.
+    Scalar getTolerance() const { return _tolerance; }
+
+    /// Return whether Jacobians within the bounding box are interpolated (rather than computed exactly).
+    bool isInterpolated() const { return !_values.empty(); }
+
+    /// Return the grid dimensions (number of points in x and y), or (0, 0) if not interpolated.
+    geom::Extent2I getGridSize() const { return geom::Extent2I(_nx, _ny); }
+
+private:
+
+    // Fill _values on an nx x ny grid covering the bounding box.
+    void _fillGrid(int nx, int ny);
+
+    // Return true if the error bound (see class docs) of the current grid is within tolerance.
+    bool _checkGrid() const;
+
+    // Interpolate the grid; (fx, fy) are grid coordinates, which must lie within the grid.
+    Eigen::Matrix2d _interpolate(Scalar fx, Scalar fy) const;
+
+    std::shared_ptr<afw::geom::SkyWcs const> _wcs;
+    geom::Box2I _bbox;
+    geom::Box2D _region;  // pixel-edge region covered by the grid
+    Scalar _tolerance;
+    int _nx;
+    int _ny;
+    Scalar _dx;
+    Scalar _dy;
+    std::vector<Scalar> _values;  // 4 Jacobian elements (row-major) per grid point, x varying fastest
+};
+
+}}} // namespace lsst::meas::modelfit
+
+#endif // !LSST_MEAS_MODELFIT_WcsLinearizationCache_h_INCLUDED
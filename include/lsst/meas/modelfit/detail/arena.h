@@ -0,0 +1,159 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#ifndef LSST_MEAS_MODELFIT_DETAIL_arena_h_INCLUDED
+#define LSST_MEAS_MODELFIT_DETAIL_arena_h_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "ndarray.h"
+
+namespace lsst { namespace meas { namespace modelfit { namespace detail {
+
+/**
+ *  A bump allocator for the temporary arrays used while measuring a single source.
+ *
+ *  Memory is handed out from large blocks by advancing an offset, and reset() releases everything
+ *  allocated since the last reset at once.  Arrays allocated from an Arena hold a reference to the
+ *  block they live in, so an array that outlives a reset remains valid: its block is simply not reused
+ *  (and is freed when the last such array is destroyed).  When a measurement needs more than one block,
+ *  the next one after a reset is sized to hold everything, so in steady state each measurement draws
+ *  from a single block that is allocated once per thread.
+ *
+ *  An Arena is not thread-safe; each thread should use its own (see ArenaScope).
+ */
+class Arena {
+public:
+
+    /// Default minimum size of a block, in bytes.
+    static std::size_t const DEFAULT_BLOCK_SIZE = 1 << 20;
+
+    /// Largest block that will be retained for reuse after a reset, in bytes.
+    static std::size_t const MAX_RETAINED_BLOCK_SIZE = 1 << 26;
+
+    explicit Arena(std::size_t blockSize=DEFAULT_BLOCK_SIZE);
+
+    Arena(Arena const &) = delete;
+    Arena & operator=(Arena const &) = delete;
+
+    /**
+     *  Allocate uninitialized, suitably aligned memory.
+     *
+     *  @param[in]  bytes   Number of bytes to allocate.
+     *  @param[out] owner   Set to the block containing the returned memory; the memory remains valid
+     *                      as long as a copy of owner exists.
+     */
+    void * allocate(std::size_t bytes, std::shared_ptr<char> & owner);
+
+    /// Allocate an uninitialized 1-d array.
+    template <typename T>
+    ndarray::Array<T,1,1> allocate(std::size_t n) {
+        std::shared_ptr<char> owner;
+        T * data = static_cast<T*>(allocate(n*sizeof(T), owner));
+        return ndarray::external(
+            data, ndarray::makeVector(ndarray::Size(n)), ndarray::makeVector(ndarray::Offset(1)), owner
+        );
+    }
+
+    /// Allocate an uninitialized row-major 2-d array.
+    template <typename T>
+    ndarray::Array<T,2,2> allocate(std::size_t n0, std::size_t n1) {
+        std::shared_ptr<char> owner;
+        T * data = static_cast<T*>(allocate(n0*n1*sizeof(T), owner));
+        return ndarray::external(
+            data,
+            ndarray::makeVector(ndarray::Size(n0), ndarray::Size(n1)),
+            ndarray::makeVector(ndarray::Offset(n1), ndarray::Offset(1)),
+            owner
+        );
+    }
+
+    /// Release all memory allocated since the last reset.
+    void reset();
+
+    /// Return the size of the blocks that will be allocated next, in bytes.
+    std::size_t getBlockSize() const { return _blockSize; }
+
+    /// Return the number of bytes allocated since the last reset (including alignment padding).
+    std::size_t getBytesAllocated() const { return _allocated; }
+
+private:
+
+    void _addBlock(std::size_t minSize);
+
+    std::size_t _blockSize;
+    std::size_t _allocated;  // bytes used in previous blocks plus _offset
+    std::size_t _offset;     // bytes used in the current block
+    std::size_t _capacity;   // size of the current block
+    std::vector<std::shared_ptr<char>> _blocks;  // blocks used since the last reset; current is last
+    std::shared_ptr<char> _spare;  // block retained by the last reset for reuse
+    std::size_t _spareSize;
+};
+
+/**
+ *  RAII object that makes the calling thread's Arena available to allocateWorkspace.
+ *
+ *  Scopes may be nested; the arena is reset when the outermost scope ends.  Code that allocates
+ *  workspace arrays should not need to know whether a scope is active: without one, allocateWorkspace
+ *  falls back to ordinary heap allocation.
+ */
+class ArenaScope {
+public:
+
+    ArenaScope();
+
+    ArenaScope(ArenaScope const &) = delete;
+    ArenaScope & operator=(ArenaScope const &) = delete;
+
+    ~ArenaScope();
+
+    /// Return the calling thread's Arena if an ArenaScope is active in it, or nullptr otherwise.
+    static Arena * getActive();
+
+};
+
+/// Allocate an uninitialized 1-d array from the active Arena, or from the heap if there is none.
+template <typename T>
+ndarray::Array<T,1,1> allocateWorkspace(std::size_t n) {
+    Arena * arena = ArenaScope::getActive();
+    if (arena) {
+        return arena->allocate<T>(n);
+    }
+    return ndarray::allocate(n);
+}
+
+/// Allocate an uninitialized row-major 2-d array from the active Arena, or from the heap if there is none.
+template <typename T>
+ndarray::Array<T,2,2> allocateWorkspace(std::size_t n0, std::size_t n1) {
+    Arena * arena = ArenaScope::getActive();
+    if (arena) {
+        return arena->allocate<T>(n0, n1);
+    }
+    return ndarray::allocate(n0, n1);
+}
+
+}}}} // namespace lsst::meas::modelfit::detail
+
+#endif // !LSST_MEAS_MODELFIT_DETAIL_arena_h_INCLUDED
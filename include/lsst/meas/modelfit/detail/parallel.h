@@ -0,0 +1,88 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+#ifndef LSST_MEAS_MODELFIT_DETAIL_parallel_h_INCLUDED
+#define LSST_MEAS_MODELFIT_DETAIL_parallel_h_INCLUDED
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace lsst { namespace meas { namespace modelfit { namespace detail {
+
+/**
+ *  Divide the range [0, n) into at most nThreads contiguous chunks of at least minChunkSize elements
+ *  each and call func(chunk, begin, end) for each, in separate threads.
+ *
+ *  The number of chunks actually used is returned; chunk indices are always in [0, nThreads).  The
+ *  function object must be safe to call concurrently; in particular, it should not copy or create
+ *  ndarray objects, whose reference counts are not thread-safe.  If it throws, all chunks are still
+ *  allowed to finish, and then the exception from the first chunk that threw is rethrown.
+ */
+template <typename F>
+int parallelFor(int n, int nThreads, int minChunkSize, F func) {
+    int nChunks = std::max(1, std::min(nThreads, (n + minChunkSize - 1) / minChunkSize));
+    if (nChunks == 1) {
+        func(0, 0, n);
+        return 1;
+    }
+    int const chunkSize = (n + nChunks - 1) / nChunks;
+    nChunks = (n + chunkSize - 1) / chunkSize;
+    std::vector<std::exception_ptr> errors(nChunks);
+    auto run = [&func, &errors](int chunk, int begin, int end) {
+        try {
+            func(chunk, begin, end);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nChunks - 1);
+    int chunk = 0;
+    try {
+        for (; chunk < nChunks - 1; ++chunk) {
+            threads.emplace_back(run, chunk, chunk*chunkSize, std::min(n, (chunk + 1)*chunkSize));
+        }
+    } catch (...) {
+        // couldn't start a thread; run the rest of the chunks in this one
+        for (; chunk < nChunks - 1; ++chunk) {
+            run(chunk, chunk*chunkSize, std::min(n, (chunk + 1)*chunkSize));
+        }
+    }
+    run(nChunks - 1, (nChunks - 1)*chunkSize, n);
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    for (auto const & error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return nChunks;
+}
+
+}}}} // namespace lsst::meas::modelfit::detail
+
+#endif // !LSST_MEAS_MODELFIT_DETAIL_parallel_h_INCLUDED
@@ -60,6 +60,56 @@ public:
 /// p(x0)=v0 to p(x1)=v1, with p'(x0)=s0 and p'(x1)=s1.
 Eigen::Vector4d solveRampPoly(double v0, double v1, double x0, double x1, double s0, double s1);
 
+/**
+ * Piecewise quintic Hermite interpolant on a uniform grid.
+ *
+ * The interpolant is defined by the values and first and second derivatives
+ * of a function at the grid points, so it and its first two derivatives are
+ * continuous, and those derivatives are accurate approximations to the
+ * derivatives of the original function.  Each segment is stored as a
+ * polynomial in the fractional position within the segment, so evaluation
+ * is a table lookup followed by a short Horner loop.
+ */
+class QuinticHermiteTable {
+public:
+
+    /// Construct from function values and first and second derivatives at n
+    /// equally-spaced points from x0 to x1 (inclusive); n must be at least 2.
+    QuinticHermiteTable(
+        double x0, double x1,
+        Eigen::VectorXd const & v, Eigen::VectorXd const & d1, Eigen::VectorXd const & d2
+    );
+
+    /// Return true if x is within the range of the table.
+    bool contains(double x) const { return x >= _x0 && x <= _x1; }
+
+    double getMin() const { return _x0; }
+
+    double getMax() const { return _x1; }
+
+    /// Evaluate the interpolant at x, which must be within the range of the table.
+    double p(double x) const;
+
+    /// Evaluate the interpolant at every element of x.  Elements outside the range of the table are
+    /// evaluated at its nearest end, so callers should replace them.
+    Eigen::ArrayXd p(Eigen::ArrayXd const & x) const;
+
+    /// Evaluate the first derivative of the interpolant at x.
+    double d1(double x) const;
+
+    /// Evaluate the second derivative of the interpolant at x.
+    double d2(double x) const;
+
+private:
+
+    int _findSegment(double x, double & t) const;
+
+    double _x0;
+    double _x1;
+    double _h;
+    Eigen::Matrix<double,Eigen::Dynamic,6,Eigen::RowMajor> _coeffs;
+};
+
 }}}} // namespace lsst::meas::modelfit::detail
 
 #endif // !LSST_MEAS_MODELFIT_DETAIL_polynomials_h_INCLUDED
@@ -39,7 +39,7 @@ namespace lsst { namespace meas { namespace modelfit { namespace detail {
  *    \frac{1}{2\pi}\int_z^{\infty}dx\;e^{-x^2/(2z^2)}
  *  @f]
  *
- *  This is just a simple wrapper around boost::math::erfc, used to provide the particular form
+ *  This is just a simple wrapper around std::erfc, used to provide the particular form
  *  expected by bvnu.
  */
 double phid(double z);
@@ -68,6 +68,20 @@ double phid(double z);
  */
 double bvnu(double h, double k, double rho);
 
+/**
+ *  @brief Compute bivariate normal probabilities for arrays of inputs
+ *
+ *  This computes the same quantity as the scalar overload for each element of the input arrays, which
+ *  must all have the same size as the output array.  Inputs are grouped by the @f$|\rho|@f$ regime that
+ *  determines the quadrature order, so each group can be evaluated with vectorized array operations.
+ */
+void bvnu(
+    ndarray::Array<double const,1,0> const & h,
+    ndarray::Array<double const,1,0> const & k,
+    ndarray::Array<double const,1,0> const & rho,
+    ndarray::Array<double,1,0> const & out
+);
+
 }}}} // namespace lsst::meas::modelfit::detail
 
 #endif // !LSST_MEAS_MODELFIT_integrals_h_INCLUDED
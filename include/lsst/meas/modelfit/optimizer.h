@@ -52,9 +52,11 @@ public:
      *
      *  Most fitting problems that can be formulated in terms of
      *  (multi-shapelet) Models, Likelihoods, and Priors can just use this
-     *  Objective.  The returned Objective relies on numerical derivatives,
-     *  however, so simple problems where analytic derivatives are easy to
-     *  implement may merit a custom OptimizerObjective.
+     *  Objective.  The returned Objective uses analytic derivatives when
+     *  the Likelihood provides them (see Likelihood::differentiateModel),
+     *  and falls back to numerical derivatives otherwise, so simple problems
+     *  where analytic derivatives are easy to implement may merit a custom
+     *  OptimizerObjective.
      */
     static PTR(OptimizerObjective) makeFromLikelihood(
         PTR(Likelihood) likelihood,
@@ -141,6 +143,20 @@ public:
      */
     virtual Scalar computePrior(ndarray::Array<Scalar const,1,1> const & parameters) const { return 1.0; }
 
+    /**
+     *  Compute the value of the Bayesian prior at many points.
+     *
+     *  @param[in]  parameters    An array with shape (nPoints, parameterSize).
+     *  @param[out] output        Output array for prior values with shape (nPoints).  Must be
+     *                            allocated, but need not be initialized.
+     *
+     *  The default implementation calls computePrior on each point.
+     */
+    virtual void computePriorBatch(
+        ndarray::Array<Scalar const,2,1> const & parameters,
+        ndarray::Array<Scalar,1,1> const & output
+    ) const;
+
     /**
      *  Compute the first and second derivatives of the Bayesian prior with respect to the parameters.
      *
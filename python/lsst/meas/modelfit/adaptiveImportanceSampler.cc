@@ -59,8 +59,9 @@ PYBIND11_MODULE(adaptiveImportanceSampler, mod) {
 
     PyAdaptiveImportanceSampler clsAdaptiveImportanceSampler(mod, "AdaptiveImportanceSampler");
     clsAdaptiveImportanceSampler.def(py::init<afw::table::Schema &, std::shared_ptr<afw::math::Random>,
-                                              std::map<int, ImportanceSamplerControl> const &, bool>(),
-                                     "sampleSchema"_a, "rng"_a, "ctrls"_a, "doSaveIteration"_a = false);
+                                              std::map<int, ImportanceSamplerControl> const &, bool, int>(),
+                                     "sampleSchema"_a, "rng"_a, "ctrls"_a, "doSaveIteration"_a = false,
+                                     "nThreads"_a = 1);
     // virtual run method already wrapped by Sampler base class
     clsAdaptiveImportanceSampler.def("computeNormalizedPerplexity",
                                      &AdaptiveImportanceSampler::computeNormalizedPerplexity);
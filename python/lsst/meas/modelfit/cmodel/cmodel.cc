@@ -60,6 +60,11 @@ static PyCModelStageControl declareCModelStageControl(py::module &mod) {
     LSST_DECLARE_NESTED_CONTROL_FIELD(cls, CModelStageControl, optimizer);
     LSST_DECLARE_CONTROL_FIELD(cls, CModelStageControl, doRecordHistory);
     LSST_DECLARE_CONTROL_FIELD(cls, CModelStageControl, doRecordTime);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelStageControl, maxPsfOrder);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelStageControl, binFactor);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelStageControl, minBinnedArea);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelStageControl, doRefineBinned);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelStageControl, adaptiveFluxTolerance);
     return cls;
 }
 
@@ -73,6 +78,11 @@ static PyCModelControl declareCModelControl(py::module &mod) {
     LSST_DECLARE_NESTED_CONTROL_FIELD(cls, CModelControl, dev);
     LSST_DECLARE_CONTROL_FIELD(cls, CModelControl, minInitialRadius);
     LSST_DECLARE_CONTROL_FIELD(cls, CModelControl, fallbackInitialMomentsPsfFactor);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelControl, doCacheWcsLinearization);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelControl, wcsLinearizationTolerance);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelControl, doKeepFitState);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelControl, pointSourceMaxRadiusRatio);
+    LSST_DECLARE_CONTROL_FIELD(cls, CModelControl, pointSourceMaxReducedChiSq);
     return cls;
 }
 
@@ -101,6 +111,7 @@ static PyCModelStageResult declareCModelStageResult(py::module &mod) {
     PyCModelStageResult cls(mod, "CModelStageResult");
 
     cls.def(py::init<>());
+    cls.def("releaseFitState", &CModelStageResult::releaseFitState);
 
     cls.attr("FAILED") = py::cast(int(CModelStageResult::FAILED));
     cls.attr("TR_SMALL") = py::cast(int(CModelStageResult::TR_SMALL));
@@ -142,6 +153,7 @@ static PyCModelResult declareCModelResult(py::module &mod) {
     PyCModelResult cls(mod, "CModelResult");
 
     cls.def(py::init<>());
+    cls.def("releaseFitState", &CModelResult::releaseFitState);
 
     cls.attr("FAILED") = py::cast(int(CModelResult::FAILED));
     cls.attr("REGION_MAX_AREA") = py::cast(int(CModelResult::REGION_MAX_AREA));
@@ -152,6 +164,8 @@ static PyCModelResult declareCModelResult(py::module &mod) {
             py::cast(int(CModelResult::REGION_USED_INITIAL_ELLIPSE_MIN));
     cls.attr("REGION_USED_INITIAL_ELLIPSE_MAX") =
             py::cast(int(CModelResult::REGION_USED_INITIAL_ELLIPSE_MAX));
+    cls.attr("REGION_USED_INFORMATION_TRIM") = py::cast(int(CModelResult::REGION_USED_INFORMATION_TRIM));
+    cls.attr("POINT_SOURCE") = py::cast(int(CModelResult::POINT_SOURCE));
     cls.attr("NO_FLUX") = py::cast(int(CModelResult::NO_FLUX));
 
     // Data members are intentionally read-only from the Python side;
@@ -202,6 +216,7 @@ static PyCModelAlgorithm declareCModelAlgorithm(py::module &mod) {
             "measRecord"_a, "exposure"_a, "refRecord"_a);
     cls.def("fail", &CModelAlgorithm::fail, "measRecord"_a, "error"_a);
     cls.def("writeResultToRecord", &CModelAlgorithm::writeResultToRecord, "result"_a, "record"_a);
+    cls.def("resetBadPixelCache", &CModelAlgorithm::resetBadPixelCache);
     return cls;
 }
 
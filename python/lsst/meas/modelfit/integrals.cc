@@ -23,6 +23,8 @@
 
 #include "pybind11/pybind11.h"
 
+#include "ndarray/pybind11.h"
+
 #include "lsst/meas/modelfit/integrals.h"
 
 namespace py = pybind11;
@@ -35,7 +37,12 @@ namespace {
 
 PYBIND11_MODULE(integrals, mod) {
     mod.def("phid", &detail::phid);
-    mod.def("bvnu", &detail::bvnu);
+    mod.def("bvnu", (double (*)(double, double, double)) & detail::bvnu, "h"_a, "k"_a, "rho"_a);
+    mod.def("bvnu",
+            (void (*)(ndarray::Array<double const, 1, 0> const &, ndarray::Array<double const, 1, 0> const &,
+                      ndarray::Array<double const, 1, 0> const &, ndarray::Array<double, 1, 0> const &)) &
+                    detail::bvnu,
+            "h"_a, "k"_a, "rho"_a, "out"_a);
 }
 
 }
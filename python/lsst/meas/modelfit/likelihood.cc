@@ -53,6 +53,8 @@ PYBIND11_MODULE(likelihood, mod) {
     cls.def("getModel", &Likelihood::getModel);
     cls.def("computeModelMatrix", &Likelihood::computeModelMatrix, "modelMatrix"_a, "nonlinear"_a,
             "doApplyWeights"_a = true);
+    cls.def("differentiateModel", &Likelihood::differentiateModel, "modelDerivative"_a, "nonlinear"_a,
+            "amplitudes"_a, "doApplyWeights"_a = true);
 }
 
 }
@@ -44,9 +44,20 @@ namespace {
 using PyMixtureComponent = py::class_<MixtureComponent>;
 using PyMixtureUpdateRestriction =
         py::class_<MixtureUpdateRestriction, std::shared_ptr<MixtureUpdateRestriction>>;
+using PyMixtureEMStatistics = py::class_<MixtureEMStatistics, std::shared_ptr<MixtureEMStatistics>>;
+using PyCounterRandom = py::class_<CounterRandom, std::shared_ptr<CounterRandom>>;
 using PyMixture = py::class_<Mixture, std::shared_ptr<Mixture>, afw::table::io::PersistableFacade<Mixture>,
                              afw::table::io::Persistable>;
 
+static PyCounterRandom declareCounterRandom(py::module &mod) {
+    PyCounterRandom cls(mod, "CounterRandom");
+    cls.def(py::init<std::uint64_t, std::uint32_t>(), "seed"_a, "sourceId"_a = 0);
+    cls.def("getSeed", &CounterRandom::getSeed);
+    cls.def("getSourceId", &CounterRandom::getSourceId);
+    cls.def("generate", &CounterRandom::generate, "sample"_a, "block"_a);
+    return cls;
+}
+
 static PyMixtureComponent declareMixtureComponent(py::module &mod) {
     PyMixtureComponent cls(mod, "MixtureComponent");
     cls.def("getDimension", &MixtureComponent::getDimension);
@@ -74,6 +85,18 @@ static PyMixtureUpdateRestriction declareMixtureUpdateRestriction(py::module &mo
     return cls;
 }
 
+static PyMixtureEMStatistics declareMixtureEMStatistics(py::module &mod) {
+    PyMixtureEMStatistics cls(mod, "MixtureEMStatistics");
+    cls.def(py::init<Mixture const &>(), "mixture"_a);
+    cls.def("getComponentCount", &MixtureEMStatistics::getComponentCount);
+    cls.def("getDimension", &MixtureEMStatistics::getDimension);
+    cls.def("getTotalWeight", &MixtureEMStatistics::getTotalWeight);
+    cls.def("reset", &MixtureEMStatistics::reset);
+    cls.def("scale", &MixtureEMStatistics::scale, "factor"_a);
+    cls.def("add", &MixtureEMStatistics::add, "other"_a, "factor"_a = 1.0);
+    return cls;
+}
+
 static PyMixture declareMixture(py::module &mod) {
     afw::table::io::python::declarePersistableFacade<Mixture>(mod, "Mixture");
     PyMixture cls(mod, "Mixture");
@@ -94,6 +117,15 @@ static PyMixture declareMixture(py::module &mod) {
     cls.def("getDegreesOfFreedom", &Mixture::getDegreesOfFreedom);
     cls.def("setDegreesOfFreedom", &Mixture::setDegreesOfFreedom,
             "df"_a = std::numeric_limits<Scalar>::infinity());
+    cls.def("setEvaluationTolerance", &Mixture::setEvaluationTolerance, "tolerance"_a);
+    cls.def("getEvaluationTolerance", &Mixture::getEvaluationTolerance);
+    cls.def("evaluateWithErrorBound",
+            [](Mixture const &self, ndarray::Array<Scalar, 1, 0> const &array) {
+                Scalar errorBound = 0.0;
+                Scalar p = self.evaluateWithErrorBound(ndarray::asEigenMatrix(array), errorBound);
+                return py::make_tuple(p, errorBound);
+            },
+            "x"_a);
     cls.def("evaluate",
             [](Mixture const &self, MixtureComponent const &component,
                ndarray::Array<Scalar, 1, 0> const &array) -> Scalar {
@@ -115,7 +147,13 @@ static PyMixture declareMixture(py::module &mod) {
                                ndarray::Array<Scalar,1,1> const &,
                                ndarray::Array<Scalar,2,1> const &>(&Mixture::evaluateDerivatives, py::const_),
             "x"_a, "gradient"_a, "hessian"_a);
-    cls.def("draw", &Mixture::draw, "rng"_a, "x"_a);
+    cls.def("draw", (void (Mixture::*)(afw::math::Random &, ndarray::Array<Scalar, 2, 1> const &) const) &
+                            Mixture::draw,
+            "rng"_a, "x"_a);
+    cls.def("draw", (void (Mixture::*)(CounterRandom const &, ndarray::Array<Scalar, 2, 1> const &,
+                                       std::uint64_t, int) const) &
+                            Mixture::draw,
+            "rng"_a, "x"_a, "offset"_a = 0, "nThreads"_a = 1);
     cls.def("updateEM", (void (Mixture::*)(ndarray::Array<Scalar const, 2, 1> const &,
                                            ndarray::Array<Scalar const, 1, 0> const &, Scalar, Scalar)) &
                                 Mixture::updateEM,
@@ -129,6 +167,11 @@ static PyMixture declareMixture(py::module &mod) {
                                            MixtureUpdateRestriction const &restriction, Scalar, Scalar)) &
                                 Mixture::updateEM,
             "x"_a, "restriction"_a, "tau1"_a = 0.0, "tau2"_a = 0.5);
+    cls.def("updateEM", (void (Mixture::*)(MixtureEMStatistics const &, MixtureUpdateRestriction const &,
+                                           Scalar, Scalar)) &
+                                Mixture::updateEM,
+            "stats"_a, "restriction"_a, "tau1"_a = 0.0, "tau2"_a = 0.5);
+    cls.def("accumulateEM", &Mixture::accumulateEM, "x"_a, "w"_a, "stats"_a, "nThreads"_a = 1);
     cls.def("clone", &Mixture::clone);
     cls.def(py::init<int, Mixture::ComponentList &, Scalar>(), "dim"_a, "components"_a,
             "df"_a = std::numeric_limits<Scalar>::infinity());
@@ -140,11 +183,14 @@ static PyMixture declareMixture(py::module &mod) {
 PYBIND11_MODULE(mixture, mod) {
     py::module::import("lsst.afw.math");
 
+    declareCounterRandom(mod);
     auto clsMixtureComponent = declareMixtureComponent(mod);
     auto clsMixtureUpdateRestriction = declareMixtureUpdateRestriction(mod);
     auto clsMixture = declareMixture(mod);
+    auto clsMixtureEMStatistics = declareMixtureEMStatistics(mod);
     clsMixture.attr("Component") = clsMixtureComponent;
     clsMixture.attr("UpdateRestriction") = clsMixtureUpdateRestriction;
+    clsMixture.attr("EMStatistics") = clsMixtureEMStatistics;
 }
 
 }
@@ -62,6 +62,7 @@ static PyOptimizerObjective declareOptimizerObjective(py::module &mod) {
             "derivatives"_a);
     cls.def("hasPrior", &OptimizerObjective::hasPrior);
     cls.def("computePrior", &OptimizerObjective::computePrior, "parameters"_a);
+    cls.def("computePriorBatch", &OptimizerObjective::computePriorBatch, "parameters"_a, "output"_a);
     cls.def("differentiatePrior", &OptimizerObjective::differentiatePrior, "parameters"_a, "gradient"_a,
             "hessian"_a);
     return cls;
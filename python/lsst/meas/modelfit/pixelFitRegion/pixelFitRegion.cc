@@ -38,10 +38,12 @@ namespace {
 
 using PyPixelFitRegionControl = py::class_<PixelFitRegionControl, std::shared_ptr<PixelFitRegionControl>>;
 using PyPixelFitRegion = py::class_<PixelFitRegion, std::shared_ptr<PixelFitRegion>>;
+using PyBadPixelBitmap = py::class_<BadPixelBitmap, std::shared_ptr<BadPixelBitmap>>;
 
 PYBIND11_MODULE(pixelFitRegion, mod) {
     py::module::import("lsst.afw.image");
     py::module::import("lsst.afw.detection");
+    py::module::import("lsst.afw.geom");
     py::module::import("lsst.afw.geom.ellipses");
 
     using Control = PixelFitRegionControl;
@@ -56,14 +58,39 @@ PYBIND11_MODULE(pixelFitRegion, mod) {
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, maxArea);
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, badMaskPlanes);
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, maxBadPixelFraction);
+    LSST_DECLARE_CONTROL_FIELD(clsControl, Control, maxTrimSignalToNoise);
+    LSST_DECLARE_CONTROL_FIELD(clsControl, Control, informationFraction);
+
+    PyBadPixelBitmap clsBitmap(mod, "BadPixelBitmap");
+    clsBitmap.def(py::init<afw::image::Mask<> const &, afw::image::MaskPixel, geom::Box2I const &>(),
+                  "mask"_a, "badPixelMask"_a, "bbox"_a = geom::Box2I());
+    clsBitmap.def_static("getPlaneBitMask", &BadPixelBitmap::getPlaneBitMask, "planes"_a);
+    clsBitmap.def("getBBox", &BadPixelBitmap::getBBox);
+    clsBitmap.def("getBadPixelMask", &BadPixelBitmap::getBadPixelMask);
+    clsBitmap.def("isSnapshotOf", &BadPixelBitmap::isSnapshotOf, "mask"_a);
+    clsBitmap.def("isBad", &BadPixelBitmap::isBad, "x"_a, "y"_a);
+    clsBitmap.def("rasterize",
+                  [](BadPixelBitmap const & self, afw::geom::ellipses::Ellipse const & ellipse) {
+                      int nTotal = 0;
+                      int nGood = 0;
+                      auto spans = self.rasterize(ellipse, nTotal, nGood);
+                      return py::make_tuple(spans, nTotal, nGood);
+                  },
+                  "ellipse"_a);
 
     PyPixelFitRegion cls(mod, "PixelFitRegion");
     cls.def(py::init<Control const &, afw::geom::ellipses::Quadrupole const &,
                      afw::geom::ellipses::Quadrupole const &, Scalar, int>(),
             "ctrl"_a, "moments"_a, "psfMoments"_a, "kronRadius"_a, "footprintArea"_a);
     cls.def(py::init<Control const &, afw::geom::ellipses::Quadrupole const &>(), "ctrl"_a, "ellipse"_a);
-    cls.def("applyEllipse", &PixelFitRegion::applyEllipse, "deconvolved"_a, "psfMoments"_a);
-    cls.def("applyMask", &PixelFitRegion::applyMask, "mask"_a, "center"_a);
+    cls.def("applyEllipse", &PixelFitRegion::applyEllipse, "deconvolved"_a, "psfMoments"_a,
+            "signalToNoise"_a = -1.0);
+    cls.def("applyMask",
+            py::overload_cast<afw::image::Mask<> const &, geom::Point2D const &>(&PixelFitRegion::applyMask),
+            "mask"_a, "center"_a);
+    cls.def("applyMask",
+            py::overload_cast<BadPixelBitmap const &, geom::Point2D const &>(&PixelFitRegion::applyMask),
+            "bitmap"_a, "center"_a);
     // Data members are intentionally read-only from the Python side;
     // they should only be set by the constructor and apply methods.
     cls.def_readonly("ellipse", &PixelFitRegion::ellipse);
@@ -74,6 +101,7 @@ PYBIND11_MODULE(pixelFitRegion, mod) {
     cls.def_readonly("maxBadPixelFraction", &PixelFitRegion::maxBadPixelFraction);
     cls.def_readonly("usedMinEllipse", &PixelFitRegion::usedMinEllipse);
     cls.def_readonly("usedMaxEllipse", &PixelFitRegion::usedMaxEllipse);
+    cls.def_readonly("usedInformationTrim", &PixelFitRegion::usedInformationTrim);
 }
 
 }
@@ -44,6 +44,7 @@ static void declarePrior(py::module &mod) {
     PyPrior cls(mod, "Prior");
     cls.def("getTag", &Prior::getTag);
     cls.def("evaluate", &Prior::evaluate, "nonlinear"_a, "amplitudes"_a);
+    cls.def("evaluateBatch", &Prior::evaluateBatch, "nonlinear"_a, "amplitudes"_a, "output"_a);
     cls.def("evaluateDerivatives", &Prior::evaluateDerivatives, "nonlinear"_a, "amplitudes"_a,
             "nonlinearGradient"_a, "amplitudeGradient"_a, "nonlinearHessian"_a, "amplitudeHessian"_a,
             "crossHessian"_a);
@@ -79,10 +80,12 @@ static void declareSemiEmpiricalPrior(py::module &mod) {
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, logRadiusMu);
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, logRadiusSigma);
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, logRadiusNu);
+    LSST_DECLARE_CONTROL_FIELD(clsControl, Control, tabulationTolerance);
     clsControl.def("validate", &Control::validate);
 
     PyClass cls(mod, "SemiEmpiricalPrior");
     cls.def(py::init<Control>(), "ctrl"_a);
+    cls.def("getTabulationError", &Class::getTabulationError);
     cls.attr("Control") = clsControl;
     // virtual methods already wrapped by Prior base class
 }
@@ -23,10 +23,13 @@
 
 #include "pybind11/pybind11.h"
 
+#include "ndarray/pybind11.h"
+
 #include "lsst/pex/config/python.h"
 
 #include "lsst/meas/modelfit/DoubleShapeletPsfApprox.h"
 #include "lsst/meas/modelfit/GeneralPsfFitter.h"
+#include "lsst/meas/modelfit/PsfFitCache.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -52,6 +55,7 @@ void declareDoubleShapelet(py::module &mod) {
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, minRadius);
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, minRadiusDiff);
     LSST_DECLARE_CONTROL_FIELD(clsControl, Control, maxRadiusBoxFraction);
+    LSST_DECLARE_CONTROL_FIELD(clsControl, Control, warmStartMaxDistance);
     LSST_DECLARE_NESTED_CONTROL_FIELD(clsControl, Control, optimizer);
 
     PyAlgorithm clsAlgorithm(mod, "DoubleShapeletPsfApproxAlgorithm");
@@ -64,7 +68,14 @@ void declareDoubleShapelet(py::module &mod) {
 
     clsAlgorithm.def(py::init<Control const &, std::string const &, afw::table::Schema &>(), "ctrl"_a,
                      "name"_a, "schema"_a);
-    clsAlgorithm.def_static("initializeResult", &Algorithm::initializeResult, "ctrl"_a);
+    clsAlgorithm.def_static("initializeResult",
+                            (shapelet::MultiShapeletFunction (*)(Control const &)) &Algorithm::initializeResult,
+                            "ctrl"_a);
+    clsAlgorithm.def_static("initializeResult",
+                            (shapelet::MultiShapeletFunction (*)(Control const &,
+                                                                 shapelet::MultiShapeletFunction const &)) &
+                                    Algorithm::initializeResult,
+                            "ctrl"_a, "previous"_a);
     clsAlgorithm.def_static("fitMoments", &Algorithm::fitMoments, "result"_a, "ctrl"_a, "psfImage"_a);
     clsAlgorithm.def_static("makeObjective", &Algorithm::makeObjective, "moments"_a, "ctrl"_a, "psfImage"_a);
     clsAlgorithm.def_static("fitProfile", &Algorithm::fitProfile, "result"_a, "ctrl"_a, "psfImage"_a);
@@ -73,6 +84,17 @@ void declareDoubleShapelet(py::module &mod) {
     clsAlgorithm.def("fail", &Algorithm::fail, "measRecord"_a, "error"_a = nullptr);
 }
 
+void declarePsfFitCache(py::module &mod) {
+    py::class_<PsfFitCache, std::shared_ptr<PsfFitCache>> cls(mod, "PsfFitCache");
+    cls.def(py::init<Scalar, int>(), "maxDistance"_a, "maxSize"_a = 16);
+    cls.def("getMaxDistance", &PsfFitCache::getMaxDistance);
+    cls.def("getMaxSize", &PsfFitCache::getMaxSize);
+    cls.def("getSize", &PsfFitCache::getSize);
+    cls.def("find", &PsfFitCache::find, "psf"_a, "position"_a);
+    cls.def("insert", &PsfFitCache::insert, "psf"_a, "position"_a, "fit"_a);
+    cls.def("clear", &PsfFitCache::clear);
+}
+
 void declareGeneral(py::module &mod) {
     using ComponentControl = GeneralPsfFitterComponentControl;
     using Control = GeneralPsfFitterControl;
@@ -147,19 +169,32 @@ void declareGeneral(py::module &mod) {
                              Algorithm::measure,
                      "measRecord"_a, "image"_a, "moments"_a);
     clsAlgorithm.def("fail", &Algorithm::fail, "measRecord"_a, "error"_a = nullptr);
+}
+
+void declareMultiShapeletPsfLikelihood(py::module &mod) {
+    using PyLikelihood = py::class_<MultiShapeletPsfLikelihood, std::shared_ptr<MultiShapeletPsfLikelihood>,
+                                    Likelihood>;
 
-    // MultiShapeletPsfLikelihood intentionally not exposed to Python.
+    // Exposed only so its analytic derivatives can be tested against finite differences.
+    PyLikelihood cls(mod, "MultiShapeletPsfLikelihood");
+    cls.def(py::init<ndarray::Array<Pixel const, 2, 1> const &, geom::Point2I const &, std::shared_ptr<Model>,
+                     Scalar, ndarray::Array<Scalar const, 1, 1> const &>(),
+            "image"_a, "xy0"_a, "model"_a, "sigma"_a, "fixed"_a);
 }
 
 PYBIND11_MODULE(psf, mod) {
+    py::module::import("lsst.afw.detection");
     py::module::import("lsst.afw.image");
     py::module::import("lsst.afw.geom.ellipses");
     py::module::import("lsst.meas.base");
     py::module::import("lsst.shapelet");
+    py::module::import("lsst.meas.modelfit.likelihood");
     py::module::import("lsst.meas.modelfit.optimizer");
 
+    declarePsfFitCache(mod);
     declareDoubleShapelet(mod);
     declareGeneral(mod);
+    declareMultiShapeletPsfLikelihood(mod);
 }
 
 }
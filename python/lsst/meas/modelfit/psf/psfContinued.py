@@ -32,7 +32,8 @@ import lsst.meas.base
 from .psf import (
     GeneralPsfFitterControl, GeneralPsfFitterComponentControl,
     GeneralPsfFitter, GeneralPsfFitterAlgorithm,
-    DoubleShapeletPsfApproxAlgorithm, DoubleShapeletPsfApproxControl
+    DoubleShapeletPsfApproxAlgorithm, DoubleShapeletPsfApproxControl,
+    PsfFitCache
 )
 
 
@@ -69,6 +70,14 @@ class GeneralShapeletPsfApproxConfig(lsst.pex.config.Config):
              " and their order"),
         default=["DoubleShapelet"]
     )
+    warmStartMaxDistance = lsst.pex.config.Field(
+        dtype=float,
+        doc=("If positive, start each model's fit from that model's most recent"
+             " successful fit within this distance (pixels) on the same"
+             " exposure, instead of from the PSF moments or the previous model"
+             " in the sequence"),
+        default=0.0
+    )
 
     def setDefaults(self):
         super(GeneralShapeletPsfApproxConfig, self).setDefaults()
@@ -117,6 +126,13 @@ class GeneralShapeletPsfApproxMixin:
     the previous one as an input, using GeneralPsfFitter::adapt to hopefully
     allow these previous fits to reduce the time spent on the next one.
 
+    If config.warmStartMaxDistance is positive, each model in the sequence
+    instead starts from its own most recent successful fit within that
+    distance on the same exposure (when there is one), as held by a
+    PsfFitCache per model.  Because the PSF varies slowly across the focal
+    plane, this usually reduces the number of optimizer iterations
+    considerably.
+
     At present, this plugin does not define any failure flags, which will
     almost certainly have to be changed in the future.  So far, however, I
     haven't actually seen it fail on any PSFs I've given it, so I'll wait
@@ -137,6 +153,10 @@ class GeneralShapeletPsfApproxMixin:
                 schema[name][m].getPrefix()
             )
             self.sequence.append((fitter, schema[name][m].getPrefix()))
+        if config.warmStartMaxDistance > 0.0:
+            self.caches = [PsfFitCache(config.warmStartMaxDistance) for m in config.sequence]
+        else:
+            self.caches = [None for m in config.sequence]
 
     def measure(self, measRecord, exposure):
         """Fit the configured sequence of models the given Exposure's Psf, as
@@ -155,15 +175,22 @@ class GeneralShapeletPsfApproxMixin:
         # initialize the parameters For every other element in the fitting
         # sequence, use the previous fit to initialize the parameters
         lastResult = None
-        for fitter, name in self.sequence:
+        position = measRecord.getCentroid()
+        for (fitter, name), cache in zip(self.sequence, self.caches):
             try:
-                if lastModel is None:
+                warmStart = cache.find(psf, position) if cache is not None else None
+                if warmStart is not None:
+                    fitter.measure(measRecord, psfImage, warmStart)
+                elif lastModel is None:
                     fitter.measure(measRecord, psfImage, psfShape)
                 else:
                     fitter.measure(measRecord, psfImage,
                                    fitter.adapt(lastResult, lastModel))
                 lastResult = measRecord.get(fitter.getKey())
                 lastModel = fitter.getModel()
+                # measure raises if the fit did not converge, so only good fits reach the cache
+                if cache is not None:
+                    cache.insert(psf, position, lastResult)
             except lsst.meas.base.baseMeasurement.FATAL_EXCEPTIONS:
                 raise
             except lsst.meas.base.MeasurementError as error:
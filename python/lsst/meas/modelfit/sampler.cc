@@ -22,10 +22,12 @@
  */
 
 #include "pybind11/pybind11.h"
+#include "pybind11/functional.h"
 
 #include "ndarray/pybind11.h"
 
 #include "lsst/meas/modelfit/Sampler.h"
+#include "lsst/meas/modelfit/DirectSamplingObjective.h"
 #include "lsst/afw/table/BaseRecord.h"
 #include "lsst/afw/table/BaseTable.h"
 #include "lsst/afw/table/Catalog.h"
@@ -39,16 +41,35 @@ namespace modelfit {
 namespace {
 
 using PySamplingObjective = py::class_<SamplingObjective, std::shared_ptr<SamplingObjective>>;
+using PySamplingObjectiveWorkspace = py::class_<SamplingObjective::Workspace>;
+using PyDirectSamplingObjective =
+        py::class_<DirectSamplingObjective, std::shared_ptr<DirectSamplingObjective>, SamplingObjective>;
 using PySampler = py::class_<Sampler, std::shared_ptr<Sampler>>;
 
 PYBIND11_MODULE(sampler, mod) {
     py::module::import("lsst.afw.table");
     py::module::import("lsst.meas.modelfit.mixture");
     py::module::import("lsst.meas.modelfit.likelihood");
+    py::module::import("lsst.meas.modelfit.priors");
 
     PySamplingObjective clsSamplingObjective(mod, "SamplingObjective");
     clsSamplingObjective.def("getParameterDim", &SamplingObjective::getParameterDim);
     clsSamplingObjective.def("__call__", &SamplingObjective::operator(), "parameters"_a, "sample"_a);
+    clsSamplingObjective.def("evaluate", &SamplingObjective::evaluate, "parameters"_a, "sample"_a,
+                             "workspace"_a);
+    clsSamplingObjective.def("isThreadSafe", &SamplingObjective::isThreadSafe);
+    clsSamplingObjective.def("makeWorkspace", &SamplingObjective::makeWorkspace);
+    clsSamplingObjective.def("makeModelMatrix", &SamplingObjective::makeModelMatrix);
+
+    PySamplingObjectiveWorkspace clsSamplingObjectiveWorkspace(clsSamplingObjective, "Workspace");
+    clsSamplingObjectiveWorkspace.def_readonly("modelMatrix", &SamplingObjective::Workspace::modelMatrix);
+
+    PyDirectSamplingObjective clsDirectSamplingObjective(mod, "DirectSamplingObjective");
+    clsDirectSamplingObjective.def(py::init<std::shared_ptr<Likelihood>, std::shared_ptr<Prior>>(),
+                                   "likelihood"_a, "prior"_a = nullptr);
+    clsDirectSamplingObjective.def(
+            py::init<DirectSamplingObjective::LikelihoodFactory, std::shared_ptr<Prior>>(),
+            "factory"_a, "prior"_a = nullptr);
 
     PySampler clsSampler(mod, "Sampler");
     clsSampler.def("run", &Sampler::run, "objective"_a, "proposal"_a, "samples"_a);
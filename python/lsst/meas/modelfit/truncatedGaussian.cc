@@ -67,6 +67,7 @@ static PyClass declareEvaluator(py::module &mod, std::string const &name) {
 
 PYBIND11_MODULE(truncatedGaussian, mod) {
     py::module::import("lsst.afw.math");
+    py::module::import("lsst.meas.modelfit.mixture");  // for CounterRandom
 
     PyTruncatedGaussian cls(mod, "TruncatedGaussian");
     py::enum_<TruncatedGaussian::SampleStrategy>(cls, "SampleStrategy")
@@ -86,6 +87,8 @@ PYBIND11_MODULE(truncatedGaussian, mod) {
     cls.def("evaluate", &TruncatedGaussian::evaluate);
     cls.def("getDim", &TruncatedGaussian::getDim);
     cls.def("maximize", &TruncatedGaussian::maximize);
+    cls.def_static("maximizeSeries", &TruncatedGaussian::maximizeSeries, "gradient"_a, "hessian"_a,
+                   "initial"_a = Vector());
     cls.def("getUntruncatedFraction", &TruncatedGaussian::getUntruncatedFraction);
     cls.def("getLogPeakAmplitude", &TruncatedGaussian::getLogPeakAmplitude);
     cls.def("getLogIntegral", &TruncatedGaussian::getLogIntegral);
@@ -100,10 +103,18 @@ PYBIND11_MODULE(truncatedGaussian, mod) {
                    (Scalar (Sampler::*)(afw::math::Random &, ndarray::Array<Scalar, 1, 1> const &) const) &
                            Sampler::operator(),
                    "rng"_a, "alpha"_a);
-    clsSampler.def("__call__", (void (Sampler::*)(afw::math::Random &, ndarray::Array<Scalar, 2, 1> const &,
-                                                  ndarray::Array<Scalar, 1, 1> const &, bool) const) &
-                                       Sampler::operator(),
+    clsSampler.def("__call__",
+                   (Scalar (Sampler::*)(afw::math::Random &, ndarray::Array<Scalar, 2, 1> const &,
+                                        ndarray::Array<Scalar, 1, 1> const &, bool) const) &
+                           Sampler::operator(),
                    "rng"_a, "alpha"_a, "weights"_a, "multiplyWeights"_a = false);
+    clsSampler.def("__call__",
+                   (Scalar (Sampler::*)(CounterRandom const &, ndarray::Array<Scalar, 2, 1> const &,
+                                        ndarray::Array<Scalar, 1, 1> const &, bool, std::uint64_t,
+                                        int) const) &
+                           Sampler::operator(),
+                   "rng"_a, "alpha"_a, "weights"_a, "multiplyWeights"_a = false, "offset"_a = 0,
+                   "nThreads"_a = 1);
 
     cls.attr("Sampler") = clsSampler;
 }
@@ -24,6 +24,7 @@
 #include "pybind11/pybind11.h"
 
 #include "lsst/meas/modelfit/UnitSystem.h"
+#include "lsst/meas/modelfit/WcsLinearizationCache.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -35,6 +36,7 @@ namespace {
 
 using PyUnitSystem = py::class_<UnitSystem, std::shared_ptr<UnitSystem>>;
 using PyLocalUnitTransform = py::class_<LocalUnitTransform, std::shared_ptr<LocalUnitTransform>>;
+using PyWcsLinearizationCache = py::class_<WcsLinearizationCache, std::shared_ptr<WcsLinearizationCache>>;
 
 PYBIND11_MODULE(unitSystem, mod) {
     py::module::import("lsst.afw.image");
@@ -63,6 +65,35 @@ PYBIND11_MODULE(unitSystem, mod) {
     clsLocalUnitTransform.def(py::init<geom::Point2D const &, UnitSystem const &, UnitSystem const &>(),
                               "sourcePixel"_a, "source"_a, "destination"_a);
     clsLocalUnitTransform.def(py::init<>());
+    clsLocalUnitTransform.def(py::init<geom::AffineTransform const &, double>(), "geometric"_a, "flux"_a);
+    clsLocalUnitTransform.def_static(
+            "fromStandard",
+            py::overload_cast<geom::Point2D const &, double, UnitSystem const &>(
+                    &LocalUnitTransform::fromStandard),
+            "destinationPixel"_a, "flux"_a, "destination"_a);
+    clsLocalUnitTransform.def_static(
+            "fromStandard",
+            py::overload_cast<geom::Point2D const &, double, UnitSystem const &,
+                              WcsLinearizationCache const &>(&LocalUnitTransform::fromStandard),
+            "destinationPixel"_a, "flux"_a, "destination"_a, "cache"_a);
+    clsLocalUnitTransform.def_static("fromJacobians", &LocalUnitTransform::fromJacobians, "sourcePixel"_a,
+                                     "sourceToTangent"_a, "source"_a, "destinationPixel"_a,
+                                     "destinationToTangent"_a, "destination"_a);
+
+    PyWcsLinearizationCache clsWcsLinearizationCache(mod, "WcsLinearizationCache");
+    clsWcsLinearizationCache.def(
+            py::init<std::shared_ptr<afw::geom::SkyWcs const>, geom::Box2I const &, Scalar, int>(),
+            "wcs"_a, "bbox"_a, "tolerance"_a = 1E-6, "initialSpacing"_a = 256);
+    clsWcsLinearizationCache.def_static("get", &WcsLinearizationCache::get, "wcs"_a, "bbox"_a,
+                                        "tolerance"_a = 1E-6);
+    clsWcsLinearizationCache.def_static("computePixelToTangent",
+                                        &WcsLinearizationCache::computePixelToTangent, "wcs"_a, "pixel"_a);
+    clsWcsLinearizationCache.def("getPixelToTangent", &WcsLinearizationCache::getPixelToTangent, "pixel"_a);
+    clsWcsLinearizationCache.def("getWcs", &WcsLinearizationCache::getWcs);
+    clsWcsLinearizationCache.def("getBBox", &WcsLinearizationCache::getBBox);
+    clsWcsLinearizationCache.def("getTolerance", &WcsLinearizationCache::getTolerance);
+    clsWcsLinearizationCache.def("isInterpolated", &WcsLinearizationCache::isInterpolated);
+    clsWcsLinearizationCache.def("getGridSize", &WcsLinearizationCache::getGridSize);
 }
 
 }
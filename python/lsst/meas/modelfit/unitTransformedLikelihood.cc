@@ -60,11 +60,13 @@ PYBIND11_MODULE(unitTransformedLikelihood, mod) {
 
     PyEpochFootprint clsEpochFootprint(mod, "EpochFootprint");
     clsEpochFootprint.def(py::init<afw::detection::Footprint const &, afw::image::Exposure<Pixel> const &,
-                                   shapelet::MultiShapeletFunction const &>(),
-                          "footprint"_a, "exposure"_a, "psf"_a);
+                                   shapelet::MultiShapeletFunction const &,
+                                   std::shared_ptr<WcsLinearizationCache const>>(),
+                          "footprint"_a, "exposure"_a, "psf"_a, "wcsCache"_a = nullptr);
     clsEpochFootprint.def_readonly("footprint", &EpochFootprint::footprint);
     clsEpochFootprint.def_readonly("exposure", &EpochFootprint::exposure);
     clsEpochFootprint.def_readonly("psf", &EpochFootprint::psf);
+    clsEpochFootprint.def_readonly("wcsCache", &EpochFootprint::wcsCache);
 
     PyUnitTransformedLikelihood clsUnitTransformedLikelihood(mod, "UnitTransformedLikelihood");
     clsUnitTransformedLikelihood.def(
@@ -78,6 +80,12 @@ PYBIND11_MODULE(unitTransformedLikelihood, mod) {
                      geom::SpherePoint const &, std::vector<std::shared_ptr<EpochFootprint>> const &,
                      UnitTransformedLikelihoodControl const &>(),
             "model"_a, "fixed"_a, "fitSys"_a, "position"_a, "epochFootprintList"_a, "ctrl"_a);
+    clsUnitTransformedLikelihood.def(
+            py::init<std::shared_ptr<Model>, ndarray::Array<Scalar const, 1, 1> const &,
+                     LocalUnitTransform const &, afw::image::Exposure<Pixel> const &,
+                     afw::detection::Footprint const &, shapelet::MultiShapeletFunction const &,
+                     UnitTransformedLikelihoodControl const &>(),
+            "model"_a, "fixed"_a, "fitSysToMeasSys"_a, "exposure"_a, "footprint"_a, "psf"_a, "ctrl"_a);
 }
 
 }
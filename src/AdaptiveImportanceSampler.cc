@@ -21,6 +21,7 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 #include <cmath>
+#include <vector>
 
 #include "ndarray/eigen.h"
 
@@ -28,36 +29,57 @@
 #include "lsst/afw/table/BaseRecord.h"
 #include "lsst/afw/table/Catalog.h"
 #include "lsst/meas/modelfit/AdaptiveImportanceSampler.h"
+#include "lsst/meas/modelfit/detail/parallel.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
 namespace {
 
-// Given a sample catalog with log unnormalized weights, transform to normalized weights
-Scalar computeRobustWeights(afw::table::BaseCatalog & samples, afw::table::Key<Scalar> const & weightKey) {
+// Columnar storage for the samples with finite objective values from a single sampler iteration.  The
+// sampler works on these arrays directly, and only copies them into the catalog records when it is done.
+struct SampleColumns {
+
+    SampleColumns(int nSamples, int parameterDim, int iterCtrl_, int iterRepeat_) :
+        size(0), iterCtrl(iterCtrl_), iterRepeat(iterRepeat_),
+        parameters(ndarray::allocate(nSamples, parameterDim)),
+        objective(ndarray::allocate(nSamples)),
+        proposal(ndarray::allocate(nSamples)),
+        weight(ndarray::allocate(nSamples)),
+        records(nSamples)
+    {}
+
+    int size;        // number of samples actually stored; arrays may be larger
+    int iterCtrl;    // control map key for this iteration
+    int iterRepeat;  // repeat index for this iteration
+    ndarray::Array<Scalar,2,2> parameters;
+    ndarray::Array<Scalar,1,1> objective;
+    ndarray::Array<Scalar,1,1> proposal;
+    ndarray::Array<Scalar,1,1> weight;
+    std::vector<PTR(afw::table::BaseRecord)> records;
+};
+
+// Given an array of log unnormalized weights, transform to normalized weights (in place), using a
+// single log-sum-exp pass rather than sorting.
+Scalar computeRobustWeights(ndarray::Array<Scalar,1,1> const & weights) {
     LOG_LOGGER trace4Logger = LOG_GET("TRACE4.meas.modelfit.AdaptiveImportanceSampler");
     static Scalar const CLIP_THRESHOLD = 100; // clip samples with weight < e^{-CLIP_THRESHOLD} * wMax
-    LOGL_DEBUG(trace4Logger, "Starting computeRobustWeights with %d samples", int(samples.size()));
-    // Sort the sample by weight so we can accumulate robustly.
-    samples.sort(weightKey);
-    Scalar uMax = samples.back().get(weightKey);
+    LOGL_DEBUG(trace4Logger, "Starting computeRobustWeights with %d samples", int(weights.getSize<0>()));
+    auto u = ndarray::asEigenArray(weights);
+    Scalar uMax = u.maxCoeff();
     Scalar uClip = uMax - CLIP_THRESHOLD;
-    afw::table::BaseCatalog::iterator const iClip = samples.lower_bound(uClip, weightKey);
-    LOGL_DEBUG(trace4Logger, "uMax=%g, uClip=%g, iClip at offset %d", uMax, uClip, int(iClip - samples.begin()));
-    for (afw::table::BaseCatalog::iterator i = samples.begin(); i != iClip; ++i) {
-        i->set(weightKey, 0.0);
-    }
-    Scalar wSum = 0.0;
-    for (afw::table::BaseCatalog::iterator i = iClip; i != samples.end(); ++i) {
-        Scalar w = std::exp(i->get(weightKey) - uMax);
-        i->set(weightKey, w);
-        wSum += w;
-    }
+    LOGL_DEBUG(trace4Logger, "uMax=%g, uClip=%g", uMax, uClip);
+    u = (u < uClip).select(0.0, (u - uMax).exp());
+    Scalar wSum = u.sum();
     LOGL_DEBUG(trace4Logger, "Uncorrected wSum=%g", wSum);
-    for (afw::table::BaseCatalog::iterator i = iClip; i != samples.end(); ++i) {
-        (*i)[weightKey] /= wSum;
-    }
-    return - uMax - std::log(wSum / samples.size());
+    u /= wSum;
+    return - uMax - std::log(wSum / weights.getSize<0>());
+}
+
+// Normalized perplexity of an array of normalized weights.
+Scalar computeWeightPerplexity(ndarray::Array<Scalar const,1,1> const & weights) {
+    auto w = ndarray::asEigenArray(weights);
+    Scalar h = -(w > 0.0).select(w * w.log(), 0.0).sum();
+    return std::exp(h) / weights.getSize<0>();
 }
 
 } // anonymous
@@ -66,9 +88,11 @@ AdaptiveImportanceSampler::AdaptiveImportanceSampler(
     afw::table::Schema & sampleSchema,
     PTR(afw::math::Random) rng,
     std::map<int,ImportanceSamplerControl> const & ctrls,
-    bool doSaveIterations
+    bool doSaveIterations,
+    int nThreads
 ) :
     _doSaveIterations(doSaveIterations),
+    _nThreads(nThreads),
     _rng(rng),
     _ctrls(ctrls),
     _weightKey(sampleSchema["weight"]),
@@ -88,6 +112,12 @@ AdaptiveImportanceSampler::AdaptiveImportanceSampler(
     ),
     _parametersKey(sampleSchema["parameters"])
 {
+    if (_nThreads < 1) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("nThreads must be >= 1; got %d") % _nThreads).str()
+        );
+    }
     if (_doSaveIterations) {
         _iterCtrlKey = sampleSchema.addField(
             afw::table::Field<int>(
@@ -112,6 +142,10 @@ void AdaptiveImportanceSampler::run(
     LOG_LOGGER trace3Logger = LOG_GET("TRACE3.meas.modelfit.AdaptiveImportanceSampler");
     double perplexity = 0.0;
     int parameterDim = objective.getParameterDim();
+    // Columnar samples for the iterations that will be saved in the output catalog: all of them if
+    // _doSaveIterations, or just the last one otherwise.
+    std::vector<SampleColumns> saved;
+    bool ranAny = false;
     for (std::map<int,ImportanceSamplerControl>::const_iterator i = _ctrls.begin(); i != _ctrls.end(); ++i) {
         ImportanceSamplerControl const & ctrl = i->second;
         int nRepeat = 0;
@@ -121,41 +155,64 @@ void AdaptiveImportanceSampler::run(
                 nRepeat, ctrl.nSamples, ctrl.nUpdateSteps, ctrl.targetPerplexity
             );
             ++nRepeat;
-            if (!_doSaveIterations) {
-                samples.clear();
-            }
-            afw::table::BaseCatalog subSamples(samples.getTable());
-            ndarray::Array<Scalar,2,2> parameters = ndarray::allocate(ctrl.nSamples, parameterDim);
+            ranAny = true;
+            SampleColumns columns(ctrl.nSamples, parameterDim, i->first, nRepeat - 1);
+            ndarray::Array<Scalar,2,2> parameters = columns.parameters;
             proposal->draw(*_rng, parameters);
             ndarray::Array<Scalar,1,1> probability = ndarray::allocate(ctrl.nSamples);
             proposal->evaluate(parameters, probability);
+            // Create the records and per-sample views serially, then evaluate the objective for all
+            // samples (possibly in parallel).
+            std::vector<PTR(afw::table::BaseRecord)> records(ctrl.nSamples);
+            std::vector<ndarray::Array<Scalar const,1,1>> sampleParameters(ctrl.nSamples);
+            for (int k = 0; k < ctrl.nSamples; ++k) {
+                records[k] = samples.getTable()->makeRecord();
+                sampleParameters[k] = parameters[k];
+            }
+            std::vector<Scalar> objectiveValues(ctrl.nSamples);
+            int const nThreads = objective.isThreadSafe() ? _nThreads : 1;
+            std::vector<std::unique_ptr<SamplingObjective::Workspace>> workspaces(nThreads);
+            for (auto & workspace : workspaces) {
+                workspace = objective.makeWorkspace();
+            }
+            detail::parallelFor(
+                ctrl.nSamples, nThreads, 1,
+                [&objective, &records, &sampleParameters, &objectiveValues, &workspaces](
+                    int chunk, int begin, int end
+                ) {
+                    for (int k = begin; k < end; ++k) {
+                        objectiveValues[k] = objective.evaluate(
+                            sampleParameters[k], *records[k], *workspaces[chunk]
+                        );
+                    }
+                }
+            );
+            sampleParameters.clear();
+            // Compact the samples with finite objective values to the front of the columns, in order.
+            int & n = columns.size;
             for (int k = 0; k < ctrl.nSamples; ++k) {
-                PTR(afw::table::BaseRecord) record = samples.addNew();
-                double objectiveValue = objective(parameters[k], *record);
-                if (std::isfinite(objectiveValue)) {
-                    subSamples.push_back(record);
-                    record->set(_parametersKey, parameters[k]);
-                    record->set(_objectiveKey, objectiveValue);
-                    record->set(_proposalKey, -std::log(probability[k]));
-                    if (_doSaveIterations) {
-                        record->set(_iterCtrlKey, i->first);
-                        record->set(_iterRepeatKey, nRepeat-1);
+                if (std::isfinite(objectiveValues[k])) {
+                    if (n != k) {
+                        parameters[n] = parameters[k];
                     }
+                    columns.objective[n] = objectiveValues[k];
+                    columns.proposal[n] = -std::log(probability[k]);
                     // for numerical reasons, in the first pass, we set w_i = ln(p_i/q_i);
                     // note that proposal[i] == -ln(q_i) and objective[i] == -ln(p_i)
-                    record->set(_weightKey, record->get(_proposalKey) - record->get(_objectiveKey));
-                } else {
-                    samples.pop_back();
+                    columns.weight[n] = columns.proposal[n] - columns.objective[n];
+                    columns.records[n] = records[k];
+                    ++n;
                 }
             }
-            if (samples.empty()) {
+            if (n == 0) {
                 throw LSST_EXCEPT(
                     pex::exceptions::LogicError,
                     "No finite objective values in entire sample set"
                 );
             }
-            computeRobustWeights(subSamples, _weightKey);
-            perplexity = computeNormalizedPerplexity(subSamples);
+            ndarray::Array<Scalar,1,1> weights = columns.weight[ndarray::view(0, n)];
+            computeRobustWeights(weights);
+            perplexity = computeWeightPerplexity(weights);
             if (!std::isfinite(perplexity)) {
                 throw LSST_EXCEPT(
                     pex::exceptions::LogicError,
@@ -166,19 +223,31 @@ void AdaptiveImportanceSampler::run(
                 "Normalized perplexity is %g; target is %g",
                 perplexity, ctrl.targetPerplexity
             );
-            if (ctrl.nUpdateSteps > 0) {
-                for (std::size_t k = 0; k < subSamples.size(); ++k) {
-                    parameters[k] = subSamples[k].get(_parametersKey);
-                    probability[k] = subSamples[k].get(_weightKey);
-                }
-                for (int j = 0; j < ctrl.nUpdateSteps; ++j) {
-                    proposal->updateEM(
-                        parameters[ndarray::view(0, subSamples.size())],
-                        probability[ndarray::view(0, subSamples.size())],
-                        ctrl.tau1, ctrl.tau2
-                    );
-                }
+            for (int j = 0; j < ctrl.nUpdateSteps; ++j) {
+                proposal->updateEM(parameters[ndarray::view(0, n)], weights, ctrl.tau1, ctrl.tau2);
+            }
+            if (!_doSaveIterations) {
+                saved.clear();
+            }
+            saved.push_back(std::move(columns));
+        }
+    }
+    // Now that sampling is complete, copy the saved columns into the output catalog.
+    if (ranAny && !_doSaveIterations) {
+        samples.clear();
+    }
+    for (SampleColumns const & columns : saved) {
+        for (int k = 0; k < columns.size; ++k) {
+            PTR(afw::table::BaseRecord) const & record = columns.records[k];
+            record->set(_parametersKey, columns.parameters[k]);
+            record->set(_objectiveKey, columns.objective[k]);
+            record->set(_proposalKey, columns.proposal[k]);
+            record->set(_weightKey, columns.weight[k]);
+            if (_doSaveIterations) {
+                record->set(_iterCtrlKey, columns.iterCtrl);
+                record->set(_iterRepeatKey, columns.iterRepeat);
             }
+            samples.push_back(record);
         }
     }
 }
@@ -20,8 +20,10 @@
  * the GNU General Public License along with this program.  If not,
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
+#include <algorithm>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <bitset>
 
 #include "boost/filesystem/path.hpp"
@@ -33,9 +35,12 @@
 #include "lsst/geom/SpherePoint.h"
 #include "lsst/afw/math/LeastSquares.h"
 #include "lsst/shapelet/FunctorKeys.h"
+#include "lsst/shapelet/MultiShapeletFunction.h"
 #include "lsst/meas/modelfit/TruncatedGaussian.h"
 #include "lsst/meas/modelfit/MultiModel.h"
 #include "lsst/meas/modelfit/CModel.h"
+#include "lsst/meas/modelfit/WcsLinearizationCache.h"
+#include "lsst/meas/modelfit/detail/arena.h"
 #include "lsst/meas/base/constants.h"
 
 namespace lsst { namespace meas { namespace modelfit {
@@ -118,6 +123,18 @@ CModelResult::CModelResult() :
     flags[FAILED] = true;
 }
 
+void CModelStageResult::releaseFitState() {
+    objfunc.reset();
+    likelihood.reset();
+    history = afw::table::BaseCatalog();
+}
+
+void CModelResult::releaseFitState() {
+    initial.releaseFitState();
+    exp.releaseFitState();
+    dev.releaseFitState();
+}
+
 
 // ------------------- Key Objects for transferring to/from afw::table Records ------------------------------
 
@@ -207,6 +224,12 @@ struct CModelStageKeys {
                     "Time spent in stage", "second"
                 );
             }
+            if (ctrl.adaptiveFluxTolerance > 0.0) {
+                nComponents = schema.addField<int>(
+                    schema.join(prefix, "nComponents"),
+                    "number of Gaussian components in the model used for the " + stage + " fit"
+                );
+            }
         } else {
             flags[CModelStageResult::BAD_REFERENCE] = schema.addField<afw::table::Flag>(
                 schema.join(prefix, "flag", "badReference"),
@@ -238,6 +261,12 @@ struct CModelStageKeys {
         fixed(schema[prefix]["fixed"])
     {
         flags[CModelStageResult::FAILED] = fluxFlag; // these flags refer to the same underlying field
+        try {
+            nComponents = schema[prefix]["nComponents"];
+        } catch (pex::exceptions::NotFoundError &) {
+            // only present when the reference fit used adaptiveFluxTolerance; otherwise it used the
+            // full model.
+        }
         LSST_THROW_IF_NE(
             model.getNonlinearDim(), nonlinear.getSize(),
             meas::base::FatalAlgorithmError,
@@ -273,6 +302,9 @@ struct CModelStageKeys {
         if (time.isValid()) {
             record.set(time, result.time);
         }
+        if (nComponents.isValid() && result.model) {
+            record.set(nComponents, result.model->getBasisVector().front()->getComponentCount());
+        }
         for (int b = 0; b < CModelStageResult::N_FLAGS; ++b) {
             if (flags[b].isValid()) {
                 record.set(flags[b], result.flags[b]);
@@ -289,6 +321,12 @@ struct CModelStageKeys {
         return result;
     }
 
+    // Return the number of Gaussian components in the model used for the reference fit, or zero if
+    // the reference fit always used the full model.
+    int getComponentCount(afw::table::BaseRecord const & record) const {
+        return nComponents.isValid() ? record.get(nComponents) : 0;
+    }
+
     bool checkBadReferenceFlag(afw::table::BaseRecord & record) const {
         if (flags[CModelStageResult::BAD_REFERENCE].isValid()) {
             if (record.get(flags[CModelStageResult::BAD_REFERENCE])) {
@@ -310,6 +348,7 @@ struct CModelStageKeys {
     afw::table::ArrayKey<Scalar> fixed;
     afw::table::Key<Scalar> time;
     afw::table::Key<int> nIter;
+    afw::table::Key<int> nComponents;
 };
 
 // Master Keys object for CModel; holds keys that aren't specific to one nonlinear stage
@@ -401,10 +440,21 @@ struct CModelKeys {
                 schema.join(prefix, "flags", "region", "usedInitialEllipseMax"),
                 "the pixel region for the final fit was set to the upper bound defined by the initial fit"
             );
+            flags[CModelResult::REGION_USED_INFORMATION_TRIM] = schema.addField<afw::table::Flag>(
+                schema.join(prefix, "flags", "region", "usedInformationTrim"),
+                "the pixel region for the final fit was trimmed to contain region.informationFraction of "
+                "the expected flux information, because the source was fainter than "
+                "region.maxTrimSignalToNoise"
+            );
             flags[CModelResult::NO_SHAPE] = schema.addField<afw::table::Flag>(
                 schema.join(prefix, "flag", "noShape"),
                 "the shape slot needed to initialize the parameters failed or was not defined"
             );
+            flags[CModelResult::POINT_SOURCE] = schema.addField<afw::table::Flag>(
+                schema.join(prefix, "flags", "pointSource"),
+                "the initial fit was unresolved, so the exp and dev components were fit as point sources "
+                "(amplitudes only) instead of with nonlinear fits"
+            );
             flags[CModelResult::SMALL_SHAPE] = schema.addField<afw::table::Flag>(
                 schema.join(prefix, "flags", "smallShape"),
                 (boost::format(
@@ -549,54 +599,279 @@ struct CModelKeys {
 
 namespace {
 
+// Return the Wcs linearization cache shared by all sources on the given exposure, or an empty pointer
+// if caching is disabled.
+PTR(WcsLinearizationCache const) getWcsLinearizationCache(
+    CModelControl const & ctrl,
+    afw::image::Exposure<Pixel> const & exposure
+) {
+    if (!ctrl.doCacheWcsLinearization || !exposure.getWcs()) {
+        return PTR(WcsLinearizationCache const)();
+    }
+    return WcsLinearizationCache::get(exposure.getWcs(), exposure.getBBox(), ctrl.wcsLinearizationTolerance);
+}
+
+// Return the given multi-shapelet PSF approximation with every component truncated to at most the
+// given shapelet order, renormalized to the flux of the full approximation; a negative order returns the
+// PSF unchanged.
+shapelet::MultiShapeletFunction truncatePsf(shapelet::MultiShapeletFunction const & psf, int maxOrder) {
+    if (maxOrder < 0) {
+        return psf;
+    }
+    bool truncated = false;
+    shapelet::MultiShapeletFunction result;
+    for (auto const & component : psf.getComponents()) {
+        if (component.getOrder() <= maxOrder) {
+            result.addComponent(component);
+        } else {
+            shapelet::ShapeletFunction lower(maxOrder, component.getBasisType(), component.getEllipse());
+            lower.getCoefficients().deep() =
+                component.getCoefficients()[ndarray::view(0, shapelet::computeSize(maxOrder))];
+            result.addComponent(lower);
+            truncated = true;
+        }
+    }
+    if (truncated) {
+        // Higher-order even terms contribute to the integral, so dropping them changes the flux.
+        result.normalize(psf.evaluate().integrate());
+    }
+    return result;
+}
+
 struct CModelStageData {
     geom::Point2D measSysCenter;       // position of the object in image ("meas") coordinates
-    geom::SpherePoint position;        // position of the object in ICRS ra,dec
-    UnitSystem measSys;                     // coordinate systems for the image being measured
-    UnitSystem fitSys;                      // coordinate systems for the model parameters
-    LocalUnitTransform fitSysToMeasSys;     // coordinate transform from fitSys to measSys
+    LocalUnitTransform fitSysToMeasSys;     // coordinate transform from fitSys (see @ref modelfitUnits)
+                                            // to the image being measured
     ndarray::Array<Scalar,1,1> parameters;  // all free parameters (nonlinear + amplitudes)
     ndarray::Array<Scalar,1,1> nonlinear;   // nonlinear parameters (a view into parameters array)
     ndarray::Array<Scalar,1,1> amplitudes;  // linear parameters (a view into parameters array)
     ndarray::Array<Scalar,1,1> fixed;       // fixed parameters (not being fit, still needed to eval model)
     shapelet::MultiShapeletFunction psf;    // multi-shapelet approximation to PSF
+    PTR(Model) model;                       // model being fit (may have fewer components than the stage's)
 
     CModelStageData(
         afw::image::Exposure<Pixel> const & exposure,
         Scalar approxFlux, geom::Point2D const & center,
         shapelet::MultiShapeletFunction const & psf_,
-        Model const & model
+        PTR(Model) const & model_,
+        WcsLinearizationCache const * wcsCache
     ) :
-        measSysCenter(center), position(exposure.getWcs()->pixelToSky(center)),
-        measSys(exposure), fitSys(position, exposure.getPhotoCalib(), approxFlux),
-        fitSysToMeasSys(fitSys.wcs->getPixelOrigin(), fitSys, measSys),
-        parameters(ndarray::allocate(model.getNonlinearDim() + model.getAmplitudeDim())),
-        nonlinear(parameters[ndarray::view(0, model.getNonlinearDim())]),
-        amplitudes(parameters[ndarray::view(model.getNonlinearDim(), parameters.getSize<0>())]),
-        fixed(ndarray::allocate(model.getFixedDim())),
-        psf(psf_)
+        measSysCenter(center),
+        fitSysToMeasSys(
+            wcsCache ? LocalUnitTransform::fromStandard(center, approxFlux, UnitSystem(exposure), *wcsCache)
+                     : LocalUnitTransform::fromStandard(center, approxFlux, UnitSystem(exposure))
+        ),
+        parameters(detail::allocateWorkspace<Scalar>(model_->getNonlinearDim() + model_->getAmplitudeDim())),
+        nonlinear(parameters[ndarray::view(0, model_->getNonlinearDim())]),
+        amplitudes(parameters[ndarray::view(model_->getNonlinearDim(), parameters.getSize<0>())]),
+        fixed(detail::allocateWorkspace<Scalar>(model_->getFixedDim())),
+        psf(psf_),
+        model(model_)
     {}
 
-    CModelStageData changeModel(Model const & model) const {
+    CModelStageData changeModel(
+        PTR(Model) const & model_,
+        shapelet::MultiShapeletFunction const & psf_
+    ) const {
         // If we allowed centroids to vary in some stages and not others, this would resize the parameter
         // arrays and update them accordingly.  For now we just assert that dimensions haven't changed
         // and do a deep-copy.
         // In theory, we should also assert that the ellipse parametrizations haven't changed, but that
         // assert would be too much work to be worthwhile, since at present all Models use the same
         // ellipse parametrization
-        assert(model.getNonlinearDim() == nonlinear.getSize<0>());
-        assert(model.getAmplitudeDim() == amplitudes.getSize<0>());
-        assert(model.getFixedDim() == fixed.getSize<0>());
+        assert(model_->getNonlinearDim() == nonlinear.getSize<0>());
+        assert(model_->getAmplitudeDim() == amplitudes.getSize<0>());
+        assert(model_->getFixedDim() == fixed.getSize<0>());
         CModelStageData r(*this);
-        r.parameters = ndarray::copy(parameters);
-        r.nonlinear = r.parameters[ndarray::view(0, model.getNonlinearDim())];
-        r.amplitudes = r.parameters[ndarray::view(model.getNonlinearDim(), parameters.getSize<0>())];
+        r.psf = psf_;
+        r.model = model_;
+        r.parameters = detail::allocateWorkspace<Scalar>(parameters.getSize<0>());
+        r.parameters.deep() = parameters;
+        r.nonlinear = r.parameters[ndarray::view(0, model_->getNonlinearDim())];
+        r.amplitudes = r.parameters[ndarray::view(model_->getNonlinearDim(), parameters.getSize<0>())];
         // don't need to deep-copy fixed parameters because they're, well, fixed
         return r;
     }
 
 };
 
+// Integer division rounding toward negative infinity.
+int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((b - 1 - a) / b);
+}
+
+// Return the PSF approximation in the coordinates of an image binned by the given factor: the 0th-order
+// terms of each component, scaled down by the binning factor and broadened by a Gaussian with the
+// variance of the binning kernel (the b x b sub-pixel centers within each binned pixel), with each
+// component's flux preserved.
+shapelet::MultiShapeletFunction binPsf(shapelet::MultiShapeletFunction const & psf, int factor) {
+    shapelet::MultiShapeletFunction result = truncatePsf(psf, 0);
+    Scalar const boxVariance = (factor*factor - 1.0) / (12.0*factor*factor);
+    geom::LinearTransform const scaling = geom::LinearTransform::makeScaling(1.0 / factor);
+    for (auto & component : result.getComponents()) {
+        Scalar flux = component.evaluate().integrate();
+        afw::geom::ellipses::Quadrupole core(component.getEllipse().getCore());
+        core.transform(scaling).inPlace();
+        core.convolve(afw::geom::ellipses::Quadrupole(boxVariance, boxVariance, 0.0)).inPlace();
+        component.getEllipse().setCore(core);
+        geom::Point2D center = component.getEllipse().getCenter();
+        component.getEllipse().setCenter(geom::Point2D(center.getX() / factor, center.getY() / factor));
+        component.normalize(flux);
+    }
+    return result;
+}
+
+// A CModel stage's pixel data binned by an integer factor, for coarse optimization.  Binned pixel
+// (X, Y) is the sum of the original pixels (x, y) with x in [bX, bX + b - 1] (and similarly for y),
+// so it is centered at x = bX + (b - 1)/2; only binned pixels that lie entirely within the original
+// footprint are included.
+struct BinnedStageInputs {
+    afw::image::Exposure<Pixel> exposure;  // binned image and variance, over the footprint bbox only
+    afw::detection::Footprint footprint;   // binned pixels to include in the fit
+    CModelStageData data;                  // shares parameter arrays with the full-resolution data
+
+    BinnedStageInputs(
+        afw::image::Exposure<Pixel> const & original,
+        afw::detection::Footprint const & originalFootprint,
+        CModelStageData const & originalData,
+        int factor
+    ) :
+        exposure(
+            geom::Box2I(
+                geom::Point2I(floorDiv(originalFootprint.getBBox().getMinX(), factor),
+                              floorDiv(originalFootprint.getBBox().getMinY(), factor)),
+                geom::Point2I(floorDiv(originalFootprint.getBBox().getMaxX(), factor),
+                              floorDiv(originalFootprint.getBBox().getMaxY(), factor))
+            )
+        ),
+        footprint(std::make_shared<afw::geom::SpanSet>()),
+        data(originalData)
+    {
+        geom::Box2I const bbox = exposure.getBBox();
+        ndarray::Array<Pixel,2,1> image = exposure.getMaskedImage().getImage()->getArray();
+        ndarray::Array<Pixel,2,1> variance = exposure.getMaskedImage().getVariance()->getArray();
+        image.deep() = 0.0;
+        variance.deep() = 0.0;
+        ndarray::Array<int,2,2> counts = ndarray::allocate(bbox.getHeight(), bbox.getWidth());
+        counts.deep() = 0;
+        ndarray::Array<Pixel const,2,1> originalImage = original.getMaskedImage().getImage()->getArray();
+        ndarray::Array<Pixel const,2,1> originalVariance =
+            original.getMaskedImage().getVariance()->getArray();
+        geom::Point2I const xy0 = original.getXY0();
+        for (auto const & span : *originalFootprint.getSpans()) {
+            int const y = span.getY();
+            int const j = floorDiv(y, factor) - bbox.getMinY();
+            for (int x = span.getMinX(); x <= span.getMaxX(); ++x) {
+                int const i = floorDiv(x, factor) - bbox.getMinX();
+                image[j][i] += originalImage[y - xy0.getY()][x - xy0.getX()];
+                variance[j][i] += originalVariance[y - xy0.getY()][x - xy0.getX()];
+                ++counts[j][i];
+            }
+        }
+        std::vector<afw::geom::Span> spans;
+        int const fullCount = factor*factor;
+        for (int j = 0; j < bbox.getHeight(); ++j) {
+            for (int i = 0; i < bbox.getWidth(); ++i) {
+                if (counts[j][i] != fullCount) continue;
+                int const begin = i;
+                while (i + 1 < bbox.getWidth() && counts[j][i + 1] == fullCount) ++i;
+                spans.push_back(
+                    afw::geom::Span(j + bbox.getMinY(), begin + bbox.getMinX(), i + bbox.getMinX())
+                );
+            }
+        }
+        footprint = afw::detection::Footprint(std::make_shared<afw::geom::SpanSet>(std::move(spans)));
+        Scalar const offset = -0.5*(factor - 1.0) / factor;
+        data.fitSysToMeasSys = LocalUnitTransform(
+            geom::AffineTransform(geom::LinearTransform::makeScaling(1.0 / factor),
+                                  geom::Extent2D(offset, offset))
+                * originalData.fitSysToMeasSys.geometric,
+            originalData.fitSysToMeasSys.flux
+        );
+        data.psf = binPsf(originalData.psf, factor);
+    }
+
+};
+
+// One circular Gaussian component of a RadialProfile basis: its flux for unit amplitude, and its variance
+// in units of the model ellipse (i.e. the component is the model ellipse scaled by sqrt(variance)).
+struct ProfileComponent {
+    Scalar flux;
+    Scalar variance;
+};
+
+typedef std::vector<ProfileComponent> ProfileComponentVector;
+
+afw::geom::ellipses::Ellipse const UNIT_CIRCLE(afw::geom::ellipses::Axes(1.0, 1.0, 0.0));
+
+// Return the components of a (single-element, zeroth-order) RadialProfile basis, sorted by radius.
+ProfileComponentVector getProfileComponents(shapelet::MultiShapeletBasis const & basis) {
+    ndarray::Array<double,1,1> coefficients = ndarray::allocate(basis.getSize());
+    coefficients.deep() = 1.0;
+    shapelet::MultiShapeletFunction function = basis.makeFunction(UNIT_CIRCLE, coefficients);
+    ProfileComponentVector result;
+    for (auto const & component : function.getComponents()) {
+        ProfileComponent p = {
+            component.evaluate().integrate(),
+            afw::geom::ellipses::Quadrupole(component.getEllipse().getCore()).getIxx()
+        };
+        result.push_back(p);
+    }
+    std::sort(
+        result.begin(), result.end(),
+        [](ProfileComponent const & a, ProfileComponent const & b) { return a.variance < b.variance; }
+    );
+    return result;
+}
+
+// Return a copy of the given components with the n innermost replaced by a single component with the
+// same total flux and flux-weighted variance.
+ProfileComponentVector mergeInnerComponents(ProfileComponentVector const & components, std::size_t n) {
+    ProfileComponent merged = {0.0, 0.0};
+    for (std::size_t i = 0; i < n; ++i) {
+        merged.flux += components[i].flux;
+        merged.variance += components[i].flux * components[i].variance;
+    }
+    merged.variance /= merged.flux;
+    ProfileComponentVector result(1, merged);
+    result.insert(result.end(), components.begin() + n, components.end());
+    return result;
+}
+
+// Construct a single-element, zeroth-order basis from circular Gaussian components.
+PTR(shapelet::MultiShapeletBasis) makeProfileBasis(ProfileComponentVector const & components) {
+    auto basis = std::make_shared<shapelet::MultiShapeletBasis>(1);
+    ndarray::Array<double,1,1> coefficients = ndarray::allocate(1);
+    coefficients[0] = 1.0;
+    for (auto const & component : components) {
+        Scalar radius = std::sqrt(component.variance);
+        ndarray::Array<double,2,2> matrix = ndarray::allocate(1, 1);
+        matrix[0][0] = 1.0;
+        // work out the flux of a unit-coefficient component with this radius, then rescale
+        shapelet::MultiShapeletBasis unit(1);
+        unit.addComponent(radius, 0, matrix);
+        matrix[0][0] = component.flux / unit.makeFunction(UNIT_CIRCLE, coefficients).evaluate().integrate();
+        basis->addComponent(radius, 0, matrix);
+    }
+    return basis;
+}
+
+// Return the inner product of two Gaussian mixtures (up to a constant factor) after scaling each
+// component by the given ellipse matrix and convolving with the given covariance.
+Scalar computeOverlap(
+    ProfileComponentVector const & a, ProfileComponentVector const & b,
+    Eigen::Matrix2d const & shape, Eigen::Matrix2d const & smoothing
+) {
+    Scalar result = 0.0;
+    for (auto const & i : a) {
+        for (auto const & j : b) {
+            Eigen::Matrix2d covariance = (i.variance + j.variance)*shape + 2.0*smoothing;
+            result += i.flux * j.flux / std::sqrt(covariance.determinant());
+        }
+    }
+    return result;
+}
+
 } // anonymous
 
 // ------------------- Private Implementation objects -------------------------------------------------------
@@ -610,7 +885,7 @@ ndarray::Array<Pixel,2,-1> makeModelMatrix(
     ndarray::Array<Scalar const,1,1> const & nonlinear
 ) {
     ndarray::Array<Pixel,2,2> modelMatrixT
-        = ndarray::allocate(likelihood.getAmplitudeDim(), likelihood.getDataDim());
+        = detail::allocateWorkspace<Pixel>(likelihood.getAmplitudeDim(), likelihood.getDataDim());
     ndarray::Array<Pixel,2,-1> modelMatrix = modelMatrixT.transpose();
     likelihood.computeModelMatrix(modelMatrix, nonlinear, false);
     return modelMatrix;
@@ -673,6 +948,8 @@ public:
     mutable Model::EllipseVector ellipses;   // workspace for asking Model to turn parameters into ellipses
     PTR(afw::table::BaseTable) historyTable;       // optimizer trace Table object
     PTR(OptimizerHistoryRecorder) historyRecorder; // optimizer trace keys/handler
+    std::vector<PTR(Model)> reducedModels;                // [n] has n Gaussians; [nComponents] is model
+    std::vector<ProfileComponentVector> reducedComponents; // Gaussians in each of reducedModels
 
     explicit CModelStageImpl(CModelStageControl const & ctrl) :
         profile(&ctrl.getProfile()),
@@ -685,6 +962,55 @@ public:
             historyRecorder.reset(new OptimizerHistoryRecorder(historySchema, model, true));
             historyTable = afw::table::BaseTable::make(historySchema);
         }
+        // Precompute models with the innermost components merged, for every possible count; these
+        // are needed in forced mode to reproduce the reference fit even if we don't select models.
+        ProfileComponentVector full = getProfileComponents(*model->getBasisVector().front());
+        std::size_t const n = full.size();
+        reducedModels.resize(n + 1);
+        reducedComponents.resize(n + 1);
+        for (std::size_t k = 1; k < n; ++k) {
+            reducedComponents[k] = mergeInnerComponents(full, n - k + 1);
+            reducedModels[k] = Model::make(makeProfileBasis(reducedComponents[k]), Model::FIXED_CENTER);
+        }
+        reducedModels[n] = model;
+        reducedComponents[n] = full;
+    }
+
+    // Return the model with the fewest Gaussian components whose estimated flux bias (relative to the
+    // full model) is within tolerance, for a source with the given ellipse (in measSys) after
+    // convolution with a PSF with the given moments and a square pixel.
+    PTR(Model) selectModel(
+        CModelStageControl const & ctrl,
+        afw::geom::ellipses::Quadrupole const & ellipse,
+        afw::geom::ellipses::Quadrupole const & psfMoments
+    ) const {
+        if (!(ctrl.adaptiveFluxTolerance > 0.0)) return model;
+        Eigen::Matrix2d const shape = ellipse.getMatrix();
+        Eigen::Matrix2d const smoothing = psfMoments.getMatrix() + Eigen::Matrix2d::Identity() / 12.0;
+        ProfileComponentVector const & full = reducedComponents.back();
+        for (std::size_t k = 1; k + 1 < reducedModels.size(); ++k) {
+            // amplitude that best fits the full model with this one, for infinite and uniform weights
+            Scalar amplitude = computeOverlap(reducedComponents[k], full, shape, smoothing)
+                / computeOverlap(reducedComponents[k], reducedComponents[k], shape, smoothing);
+            if (std::abs(amplitude - 1.0) <= ctrl.adaptiveFluxTolerance) {
+                return reducedModels[k];
+            }
+        }
+        return model;
+    }
+
+    // Return the model with the given number of Gaussian components, as recorded for a reference fit,
+    // or the full model if nComponents is zero.
+    PTR(Model) getReducedModel(int nComponents) const {
+        if (nComponents == 0) return model;
+        if (nComponents < 0 || std::size_t(nComponents) >= reducedModels.size()) {
+            throw LSST_EXCEPT(
+                meas::base::FatalAlgorithmError,
+                (boost::format("Reference fit used %d Gaussian components; configured profile has %d")
+                 % nComponents % (reducedModels.size() - 1)).str()
+            );
+        }
+        return reducedModels[nComponents];
     }
 
     // Create a blank result object, and just fill in the stuff that never changes.
@@ -703,6 +1029,7 @@ public:
         WeightSums const & sums
     ) const {
         // these are shallow assignments
+        result.model = data.model;
         result.nonlinear = data.nonlinear;
         result.amplitudes = data.amplitudes;
         result.fixed = data.fixed;
@@ -715,25 +1042,17 @@ public:
         result.instFluxErr = std::sqrt(sums.fluxVar)*result.instFlux/result.instFluxInner;
         // to compute the ellipse, we need to first read the nonlinear parameters into the workspace
         // ellipse vector, then transform from fitSys to measSys.
-        model->writeEllipses(data.nonlinear.begin(), data.fixed.begin(), ellipses.begin());
+        data.model->writeEllipses(data.nonlinear.begin(), data.fixed.begin(), ellipses.begin());
         result.ellipse = ellipses.front().getCore().transform(data.fitSysToMeasSys.geometric.getLinear());
     }
 
-    // Do the full nonlinear fit for this stage
-    void fit(
+    // Run the optimizer on the given likelihood, starting from and updating data.parameters, and set
+    // the optimizer-related outputs (flags, objective, objfunc, history) of the given result.
+    void optimize(
         CModelStageControl const & ctrl, CModelStageResult & result, CModelStageData const & data,
-        afw::image::Exposure<Pixel> const & exposure, afw::detection::Footprint const & footprint
+        PTR(UnitTransformedLikelihood) likelihood
     ) const {
-        long long startTime = 0;
-        if (ctrl.doRecordTime) {
-            startTime = daf::base::DateTime::now().nsecs();
-        }
-        result.likelihood = std::make_shared<UnitTransformedLikelihood>(
-            model, data.fixed, data.fitSys, data.position,
-            exposure, footprint, data.psf,
-            UnitTransformedLikelihoodControl(ctrl.usePixelWeights, ctrl.weightsMultiplier)
-        );
-        PTR(OptimizerObjective) objective = OptimizerObjective::makeFromLikelihood(result.likelihood, prior);
+        PTR(OptimizerObjective) objective = OptimizerObjective::makeFromLikelihood(likelihood, prior);
         result.objfunc = objective;
         Optimizer optimizer(objective, data.parameters, ctrl.optimizer);
         try {
@@ -776,6 +1095,53 @@ public:
         // Set the output parameter vectors.  We deep-assign to the data object to split nonlinear and
         // amplitudes, then shallow-assign these to the result object.
         data.parameters.deep() = optimizer.getParameters(); // sets nonlinear and amplitudes - they are views
+    }
+
+    // Do the full nonlinear fit for this stage
+    void fit(
+        CModelStageControl const & ctrl, CModelStageResult & result, CModelStageData const & data,
+        afw::image::Exposure<Pixel> const & exposure, afw::detection::Footprint const & footprint
+    ) const {
+        long long startTime = 0;
+        if (ctrl.doRecordTime) {
+            startTime = daf::base::DateTime::now().nsecs();
+        }
+        UnitTransformedLikelihoodControl likelihoodCtrl(ctrl.usePixelWeights, ctrl.weightsMultiplier);
+
+        // If configured, start by optimizing on binned pixels, which is much cheaper far from the optimum.
+        bool refine = true;
+        if (ctrl.binFactor > 1) {
+            BinnedStageInputs binned(exposure, footprint, data, ctrl.binFactor);
+            if (binned.footprint.getArea() >= static_cast<std::size_t>(ctrl.minBinnedArea)) {
+                CModelStageResult coarse = makeResult();
+                ndarray::Array<Scalar,1,1> start = ndarray::copy(data.parameters);
+                optimize(
+                    ctrl, coarse, binned.data,
+                    std::make_shared<UnitTransformedLikelihood>(
+                        data.model, binned.data.fixed, binned.data.fitSysToMeasSys,
+                        binned.exposure, binned.footprint, binned.data.psf, likelihoodCtrl
+                    )
+                );
+                if (!ctrl.doRefineBinned) {
+                    result.objfunc = coarse.objfunc;
+                    result.history = coarse.history;
+                    result.objective = coarse.objective;
+                    result.flags = coarse.flags;
+                    refine = false;
+                } else if (coarse.flags[CModelStageResult::NUMERIC_ERROR]) {
+                    data.parameters.deep() = start;  // don't start the full-resolution fit from garbage
+                }
+            }
+        }
+
+        // Flux and uncertainty (and the refined fit, if any) always use the full-resolution pixels.
+        result.likelihood = std::make_shared<UnitTransformedLikelihood>(
+            data.model, data.fixed, data.fitSysToMeasSys,
+            exposure, footprint, data.psf, likelihoodCtrl
+        );
+        if (refine) {
+            optimize(ctrl, result, data, result.likelihood);
+        }
 
         // This flux uncertainty is computed holding all the nonlinear parameters fixed, and treating
         // the best-fit model as a continuous aperture.  That's likely what we'd want for colors, but it
@@ -813,7 +1179,7 @@ public:
         afw::image::Exposure<Pixel> const & exposure, afw::detection::Footprint const & footprint
     ) const {
         result.likelihood = std::make_shared<UnitTransformedLikelihood>(
-            model, data.fixed, data.fitSys, data.position,
+            data.model, data.fixed, data.fitSysToMeasSys,
             exposure, footprint, data.psf, UnitTransformedLikelihoodControl(ctrl.usePixelWeights)
         );
         ndarray::Array<Pixel,2,-1> modelMatrix = makeModelMatrix(*result.likelihood, data.nonlinear);
@@ -853,18 +1219,42 @@ public:
                               // and extract shapelet PSF approximation.  May be null, depending
                               // on the CModelAlgorithm ctor called
     PTR(CModelKeys) refKeys;  // Key object used to retreive reference ellipses in forced mode
+    mutable std::mutex badPixelMutex;                  // guards badPixelBitmap
+    mutable PTR(BadPixelBitmap const) badPixelBitmap;  // bad pixels of the most recently measured mask
 
     explicit Impl(CModelControl const & ctrl) :
         initial(ctrl.initial), exp(ctrl.exp), dev(ctrl.dev)
     {
         // construct linear combination model
+        model = makeLinearModel(exp.model, dev.model);
+    }
+
+    // Construct a linear combination of an exponential and de Vaucouleur model.
+    static PTR(Model) makeLinearModel(PTR(Model) const & expModel, PTR(Model) const & devModel) {
         ModelVector components(2);
-        components[0] = exp.model;
-        components[1] = dev.model;
+        components[0] = expModel;
+        components[1] = devModel;
         Model::NameVector prefixes(2);
         prefixes[0] = "exp";
         prefixes[1] = "dev";
-        model = std::make_shared<MultiModel>(components, prefixes);
+        return std::make_shared<MultiModel>(components, prefixes);
+    }
+
+    // Return a bad pixel bitmap for the full mask, reusing the one from the previous call (and hence
+    // unpacking the mask only once per exposure) when it was made from the same mask.  This only
+    // compares the mask's identity, so the mask must not change while an exposure is being measured;
+    // see CModelAlgorithm::resetBadPixelCache.
+    PTR(BadPixelBitmap const) getBadPixelBitmap(
+        PixelFitRegionControl const & ctrl,
+        afw::image::Mask<> const & mask
+    ) const {
+        std::lock_guard<std::mutex> lock(badPixelMutex);
+        if (!badPixelBitmap || !badPixelBitmap->isSnapshotOf(mask)) {
+            badPixelBitmap = std::make_shared<BadPixelBitmap>(
+                mask, BadPixelBitmap::getPlaneBitMask(ctrl.badMaskPlanes)
+            );
+        }
+        return badPixelBitmap;
     }
 
     // Create a blank result object, filling in only the things that don't change
@@ -882,16 +1272,20 @@ public:
         CModelStageData const & expData, CModelStageData const & devData,
         afw::image::Exposure<Pixel> const & exposure, afw::detection::Footprint const & footprint
     ) const {
+        // the precomputed combined model can only be used if neither stage used a reduced model
+        PTR(Model) linearModel = (expData.model == exp.model && devData.model == dev.model) ? model
+            : makeLinearModel(expData.model, devData.model);
         // concatenate exp and dev parameter arrays to make parameter arrays for combined model
-        ndarray::Array<Scalar,1,1> nonlinear = ndarray::allocate(model->getNonlinearDim());
+        int const nonlinearDim = linearModel->getNonlinearDim();
+        ndarray::Array<Scalar,1,1> nonlinear = detail::allocateWorkspace<Scalar>(nonlinearDim);
         nonlinear[ndarray::view(0, exp.model->getNonlinearDim())] = expData.nonlinear;
-        nonlinear[ndarray::view(exp.model->getNonlinearDim(), model->getNonlinearDim())] = devData.nonlinear;
-        ndarray::Array<Scalar,1,1> fixed = ndarray::allocate(model->getFixedDim());
+        nonlinear[ndarray::view(exp.model->getNonlinearDim(), nonlinearDim)] = devData.nonlinear;
+        ndarray::Array<Scalar,1,1> fixed = detail::allocateWorkspace<Scalar>(linearModel->getFixedDim());
         fixed[ndarray::view(0, exp.model->getFixedDim())] = expData.fixed;
-        fixed[ndarray::view(exp.model->getFixedDim(), model->getFixedDim())] = devData.fixed;
+        fixed[ndarray::view(exp.model->getFixedDim(), linearModel->getFixedDim())] = devData.fixed;
 
         UnitTransformedLikelihood likelihood(
-            model, fixed, expData.fitSys, expData.position,
+            linearModel, fixed, expData.fitSysToMeasSys,
             exposure, footprint, expData.psf, UnitTransformedLikelihoodControl(false)
         );
         auto unweightedData = likelihood.getUnweightedData();
@@ -922,7 +1316,7 @@ public:
         // Doing a better job would involve taking into account that we have positivity constraints
         // on the two components, which means the actual uncertainty is neither Gaussian nor symmetric,
         // which is a lot harder to compute and a lot harder to use.
-        ndarray::Array<Pixel,1,1> model = ndarray::allocate(likelihood.getDataDim());
+        ndarray::Array<Pixel,1,1> model = detail::allocateWorkspace<Pixel>(likelihood.getDataDim());
         ndarray::asEigenMatrix(model) = ndarray::asEigenMatrix(modelMatrix) * amplitudes.cast<Pixel>();
         WeightSums sums(model, unweightedData, likelihood.getVariance());
         result.instFluxInner = sums.instFluxInner;
@@ -937,6 +1331,64 @@ public:
         result.objective = tg.evaluateLog()(amplitudes);
     }
 
+    // Return the variance-weighted chi^2 of a stage's best-fit model.  This can't use the stage's
+    // objective value, which (for linear-only fits) is computed from unweighted residuals.
+    static Scalar computeChiSq(CModelStageResult const & result, CModelStageData const & data) {
+        ndarray::Array<Pixel,2,-1> modelMatrix = makeModelMatrix(*result.likelihood, data.nonlinear);
+        Vector residuals = ndarray::asEigenMatrix(result.likelihood->getUnweightedData()).cast<Scalar>()
+            - ndarray::asEigenMatrix(modelMatrix).cast<Scalar>() * ndarray::asEigenMatrix(data.amplitudes);
+        return (residuals.array().square()
+                / ndarray::asEigenArray(result.likelihood->getVariance()).cast<Scalar>()).sum();
+    }
+
+    // Fit the exp and dev components as point sources (amplitudes only, with a radius of
+    // ctrl.minInitialRadius at the initial fit's center) if the initial fit is unresolved and the
+    // point-source fits are acceptable.  Returns true on success, in which case the stage data and
+    // results have been set in place of the nonlinear fits.
+    bool fitPointSource(
+        CModelControl const & ctrl, CModelResult & result,
+        afw::geom::ellipses::Ellipse const & initialEllipse,  // half-light ellipse in measSys
+        afw::geom::ellipses::Quadrupole const & psfMoments,
+        CModelStageData & expData, CModelStageData & devData,
+        afw::image::Exposure<Pixel> const & exposure, afw::detection::Footprint const & footprint
+    ) const {
+        if (!(ctrl.pointSourceMaxRadiusRatio > 0.0) || !(initialEllipse.getCore().getDeterminantRadius()
+                < ctrl.pointSourceMaxRadiusRatio*psfMoments.getDeterminantRadius())) {
+            return false;
+        }
+        afw::geom::ellipses::Ellipse pointEllipse(
+            afw::geom::ellipses::Quadrupole(
+                ctrl.minInitialRadius*ctrl.minInitialRadius, ctrl.minInitialRadius*ctrl.minInitialRadius, 0.0
+            ),
+            initialEllipse.getCenter()
+        );
+        pointEllipse.transform(expData.fitSysToMeasSys.geometric.inverted()).inPlace();
+        Scalar const maxChiSq = ctrl.pointSourceMaxReducedChiSq*footprint.getArea();
+
+        CModelStageData pointExpData = expData.changeModel(expData.model, expData.psf);
+        exp.ellipses.front() = pointEllipse;
+        pointExpData.model->readEllipses(exp.ellipses.begin(), pointExpData.nonlinear.begin(),
+                                pointExpData.fixed.begin());
+        CModelStageResult expResult = exp.makeResult();
+        exp.fitLinear(ctrl.exp, expResult, pointExpData, exposure, footprint);
+        if (!(computeChiSq(expResult, pointExpData) <= maxChiSq)) return false;
+
+        CModelStageData pointDevData = devData.changeModel(devData.model, devData.psf);
+        dev.ellipses.front() = pointEllipse;
+        pointDevData.model->readEllipses(dev.ellipses.begin(), pointDevData.nonlinear.begin(),
+                                pointDevData.fixed.begin());
+        CModelStageResult devResult = dev.makeResult();
+        dev.fitLinear(ctrl.dev, devResult, pointDevData, exposure, footprint);
+        if (!(computeChiSq(devResult, pointDevData) <= maxChiSq)) return false;
+
+        result.exp = expResult;
+        result.dev = devResult;
+        expData = pointExpData;
+        devData = pointDevData;
+        result.flags[CModelResult::POINT_SOURCE] = true;
+        return true;
+    }
+
     // Guess parameters for the initial fit stage from image moments
     void guessParametersFromMoments(
         CModelControl const & ctrl, CModelStageData & data,
@@ -1068,6 +1520,9 @@ CModelAlgorithm::Result CModelAlgorithm::apply(
 ) const {
     Result result = _impl->makeResult();
     _applyImpl(result, exposure, psf, center, moments, approxFlux, kronRadius, footprintArea);
+    if (!getControl().doKeepFitState) {
+        result.releaseFitState();
+    }
     return result;
 }
 
@@ -1095,7 +1550,9 @@ void CModelAlgorithm::_applyImpl(
 
     PixelFitRegion region(getControl().region, moments, psfMoments, kronRadius, footprintArea);
     result.initialFitRegion = region.ellipse;
-    region.applyMask(*exposure.getMaskedImage().getMask(), center);
+    PTR(BadPixelBitmap const) badPixels =
+        _impl->getBadPixelBitmap(getControl().region, *exposure.getMaskedImage().getMask());
+    region.applyMask(*badPixels, center);
     // TODO: have PixelFitRegion throw MeasurementError instead for some of these?
     // (logic should be correct, but we might be able to simplify the code)
     result.flags[CModelResult::REGION_MAX_AREA] = region.maxArea;
@@ -1123,14 +1580,17 @@ void CModelAlgorithm::_applyImpl(
     }
 
     // Set up coordinate systems and empty parameter vectors
-    CModelStageData initialData(exposure, approxFlux, center, psf, *_impl->initial.model);
+    PTR(WcsLinearizationCache const) wcsCache = getWcsLinearizationCache(getControl(), exposure);
+    CModelStageData initialData(
+        exposure, approxFlux, center, truncatePsf(psf, getControl().initial.maxPsfOrder),
+        _impl->initial.model, wcsCache.get()
+    );
     result.fitSysToMeasSys = initialData.fitSysToMeasSys;
 
     // Initialize the parameter vectors by doing deconvolving the moments
     _impl->guessParametersFromMoments(getControl(), initialData, moments, result);
 
-    // Do the initial fit
-    // TODO: use only 0th-order terms in psf
+    // Do the initial fit (possibly with a truncated PSF approximation; see CModelStageControl::maxPsfOrder)
     _impl->initial.fit(getControl().initial, result.initial, initialData, exposure, *region.footprint);
     if (result.initial.flags[CModelStageResult::FAILED]) return;
 
@@ -1139,24 +1599,42 @@ void CModelAlgorithm::_applyImpl(
                                         _impl->initial.ellipses.begin());
     _impl->initial.ellipses.front().transform(initialData.fitSysToMeasSys.geometric).inPlace();
 
-    // Revisit the pixel region to use in the fit, taking into account the initial ellipse
-    region.applyEllipse(_impl->initial.ellipses.front().getCore(), psfMoments);
+    // Revisit the pixel region to use in the fit, taking into account the initial ellipse (and, if
+    // configured to, the signal-to-noise ratio of the initial fit)
+    Scalar signalToNoise = result.initial.instFlux / result.initial.instFluxErr;
+    region.applyEllipse(_impl->initial.ellipses.front().getCore(), psfMoments,
+                        std::isfinite(signalToNoise) ? signalToNoise : -1.0);
     result.finalFitRegion = region.ellipse;
-    region.applyMask(*exposure.getMaskedImage().getMask(), center);
+    region.applyMask(*badPixels, center);
     // It's okay to "override" these flags, because we'd have already returned early if they were set above.
     result.flags[CModelResult::REGION_MAX_AREA] = region.maxArea;
     result.flags[CModelResult::REGION_MAX_BAD_PIXEL_FRACTION] = region.maxBadPixelFraction;
     result.flags[CModelResult::REGION_USED_INITIAL_ELLIPSE_MIN] = region.usedMinEllipse;
     result.flags[CModelResult::REGION_USED_INITIAL_ELLIPSE_MAX] = region.usedMaxEllipse;
+    result.flags[CModelResult::REGION_USED_INFORMATION_TRIM] = region.usedInformationTrim;
     if (!region.footprint) return;
 
-    // Do the exponential fit
-    CModelStageData expData = initialData.changeModel(*_impl->exp.model);
-    _impl->exp.fit(getControl().exp, result.exp, expData, exposure, *region.footprint);
+    // If configured, use fewer Gaussians for the exp and dev models when the initial fit is small enough
+    // (relative to the PSF) that the innermost ones are indistinguishable.
+    afw::geom::ellipses::Quadrupole initialCore(_impl->initial.ellipses.front().getCore());
+    CModelStageData expData = initialData.changeModel(
+        _impl->exp.selectModel(getControl().exp, initialCore, psfMoments),
+        truncatePsf(psf, getControl().exp.maxPsfOrder)
+    );
+    CModelStageData devData = initialData.changeModel(
+        _impl->dev.selectModel(getControl().dev, initialCore, psfMoments),
+        truncatePsf(psf, getControl().dev.maxPsfOrder)
+    );
 
-    // Do the de Vaucouleur fit
-    CModelStageData devData = initialData.changeModel(*_impl->dev.model);
-    _impl->dev.fit(getControl().dev, result.dev, devData, exposure, *region.footprint);
+    // If the initial fit is unresolved, try to skip the nonlinear fits and fit point sources instead
+    if (!_impl->fitPointSource(getControl(), result, _impl->initial.ellipses.front(), psfMoments,
+                               expData, devData, exposure, *region.footprint)) {
+        // Do the exponential fit
+        _impl->exp.fit(getControl().exp, result.exp, expData, exposure, *region.footprint);
+
+        // Do the de Vaucouleur fit
+        _impl->dev.fit(getControl().dev, result.dev, devData, exposure, *region.footprint);
+    }
 
     if (result.exp.flags[CModelStageResult::FAILED] ||result.dev.flags[CModelStageResult::FAILED])
         return;
@@ -1179,6 +1657,9 @@ CModelAlgorithm::Result CModelAlgorithm::applyForced(
 ) const {
     Result result = _impl->makeResult();
     _applyForcedImpl(result, exposure, psf, center, reference, approxFlux);
+    if (!getControl().doKeepFitState) {
+        result.releaseFitState();
+    }
     return result;
 }
 
@@ -1195,6 +1676,11 @@ void CModelAlgorithm::writeResultToRecord(
     _impl->keys->copyResultToRecord(result, record);
 }
 
+void CModelAlgorithm::resetBadPixelCache() const {
+    std::lock_guard<std::mutex> lock(_impl->badPixelMutex);
+    _impl->badPixelBitmap.reset();
+}
+
 void CModelAlgorithm::fail(
     afw::table::SourceRecord & record,
     meas::base::MeasurementError * error
@@ -1233,7 +1719,10 @@ void CModelAlgorithm::_applyForcedImpl(
     // region, even though it makes the initial fit regions less consistent between
     // regular and forced measurement.
     PixelFitRegion region(getControl().region, reference.finalFitRegion);
-    region.applyMask(*exposure.getMaskedImage().getMask(), center);
+    region.applyMask(
+        *_impl->getBadPixelBitmap(getControl().region, *exposure.getMaskedImage().getMask()),
+        center
+    );
     result.flags[CModelResult::REGION_MAX_AREA] = region.maxArea;
     result.flags[CModelResult::REGION_MAX_BAD_PIXEL_FRACTION] = region.maxBadPixelFraction;
     if (!region.footprint) return;
@@ -1257,7 +1746,11 @@ void CModelAlgorithm::_applyForcedImpl(
     }
 
     // Set up coordinate systems and empty parameter vectors
-    CModelStageData initialData(exposure, approxFlux, center, psf, *_impl->initial.model);
+    PTR(WcsLinearizationCache const) wcsCache = getWcsLinearizationCache(getControl(), exposure);
+    CModelStageData initialData(
+        exposure, approxFlux, center, truncatePsf(psf, getControl().initial.maxPsfOrder),
+        _impl->initial.model, wcsCache.get()
+    );
     result.fitSysToMeasSys = initialData.fitSysToMeasSys;
 
     // Initialize the parameter vectors from the reference values.  Because these are
@@ -1275,8 +1768,11 @@ void CModelAlgorithm::_applyForcedImpl(
         result.initial.flags[CModelStageResult::FAILED] = true;
     }
 
-    // Do the exponential fit (amplitudes only)
-    CModelStageData expData = initialData.changeModel(*_impl->exp.model);
+    // Do the exponential fit (amplitudes only), using the same (possibly reduced) model as the reference
+    CModelStageData expData = initialData.changeModel(
+        reference.exp.model ? reference.exp.model : _impl->exp.model,
+        truncatePsf(psf, getControl().exp.maxPsfOrder)
+    );
     if (!reference.exp.flags[CModelStageResult::FAILED]) {
         expData.nonlinear.deep() = reference.exp.nonlinear;
         expData.fixed.deep() = reference.exp.fixed;
@@ -1287,7 +1783,10 @@ void CModelAlgorithm::_applyForcedImpl(
     }
 
     // Do the de Vaucouleur fit (amplitudes only)
-    CModelStageData devData = initialData.changeModel(*_impl->dev.model);
+    CModelStageData devData = initialData.changeModel(
+        reference.dev.model ? reference.dev.model : _impl->dev.model,
+        truncatePsf(psf, getControl().dev.maxPsfOrder)
+    );
     if (!reference.dev.flags[CModelStageResult::FAILED]) {
         devData.nonlinear.deep() = reference.dev.nonlinear;
         devData.fixed.deep() = reference.dev.fixed;
@@ -1350,6 +1849,8 @@ void CModelAlgorithm::measure(
     afw::table::SourceRecord & measRecord,
     afw::image::Exposure<Pixel> const & exposure
 ) const {
+    // Draw temporary arrays from this thread's arena; only what we copy to the record survives.
+    detail::ArenaScope arenaScope;
     Result result = _impl->makeResult();
     // Read the shapelet approximation to the PSF, load/verify other inputs from the SourceRecord
     shapelet::MultiShapeletFunction psf = _processInputs(measRecord, exposure);
@@ -1405,6 +1906,8 @@ void CModelAlgorithm::measure(
     afw::image::Exposure<Pixel> const & exposure,
     afw::table::SourceRecord const & refRecord
 ) const {
+    // Draw temporary arrays from this thread's arena; only what we copy to the record survives.
+    detail::ArenaScope arenaScope;
     Result result = _impl->makeResult();
     // Read the shapelet approximation to the PSF, load/verify other inputs from the SourceRecord
     shapelet::MultiShapeletFunction psf = _processInputs(measRecord, exposure);
@@ -1415,6 +1918,8 @@ void CModelAlgorithm::measure(
     }
     try {
         Result refResult = _impl->refKeys->copyRecordToResult(refRecord);
+        refResult.exp.model = _impl->exp.getReducedModel(_impl->refKeys->exp.getComponentCount(refRecord));
+        refResult.dev.model = _impl->dev.getReducedModel(_impl->refKeys->dev.getComponentCount(refRecord));
         _applyForcedImpl(result, exposure, psf, measRecord.getCentroid(), refResult, approxFlux);
     } catch (...) {
         _impl->keys->copyResultToRecord(result, measRecord);
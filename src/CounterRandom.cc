@@ -0,0 +1,106 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+#include <cmath>
+
+#include "boost/math/special_functions/gamma.hpp"
+
+#include "lsst/meas/modelfit/CounterRandom.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+namespace {
+
+// Constants for Philox4x32 from Salmon et al. 2011, "Parallel Random Numbers: As Easy as 1, 2, 3".
+std::uint32_t const PHILOX_M0 = 0xD2511F53;
+std::uint32_t const PHILOX_M1 = 0xCD9E8D57;
+std::uint32_t const PHILOX_W0 = 0x9E3779B9;
+std::uint32_t const PHILOX_W1 = 0xBB67AE85;
+int const PHILOX_ROUNDS = 10;
+
+inline void mulhilo(std::uint32_t a, std::uint32_t b, std::uint32_t & hi, std::uint32_t & lo) {
+    std::uint64_t product = static_cast<std::uint64_t>(a) * b;
+    hi = static_cast<std::uint32_t>(product >> 32);
+    lo = static_cast<std::uint32_t>(product);
+}
+
+// Combine two 32-bit integers into a double in the open interval (0, 1) with 53 random bits.
+inline double toUniform(std::uint32_t a, std::uint32_t b) {
+    return ((a >> 5) * 67108864.0 + (b >> 6) + 0.5) / 9007199254740992.0;
+}
+
+} // anonymous
+
+std::array<std::uint32_t,4> CounterRandom::generate(std::uint64_t sample, std::uint32_t block) const {
+    std::array<std::uint32_t,4> ctr = {{
+        block, _sourceId, static_cast<std::uint32_t>(sample), static_cast<std::uint32_t>(sample >> 32)
+    }};
+    std::uint32_t key0 = static_cast<std::uint32_t>(_seed);
+    std::uint32_t key1 = static_cast<std::uint32_t>(_seed >> 32);
+    for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+        std::uint32_t hi0, lo0, hi1, lo1;
+        mulhilo(PHILOX_M0, ctr[0], hi0, lo0);
+        mulhilo(PHILOX_M1, ctr[2], hi1, lo1);
+        ctr = {{hi1 ^ ctr[1] ^ key0, lo1, hi0 ^ ctr[3] ^ key1, lo0}};
+        key0 += PHILOX_W0;
+        key1 += PHILOX_W1;
+    }
+    return ctr;
+}
+
+CounterRandom::Stream::Stream(CounterRandom const & parent, std::uint64_t sample) :
+    _parent(&parent), _sample(sample), _block(0), _nUniforms(0), _hasGaussian(false)
+{}
+
+double CounterRandom::Stream::uniform() {
+    if (_nUniforms == 0) {
+        std::array<std::uint32_t,4> bits = _parent->generate(_sample, _block);
+        ++_block;
+        _uniforms[0] = toUniform(bits[2], bits[3]);
+        _uniforms[1] = toUniform(bits[0], bits[1]);
+        _nUniforms = 2;
+    }
+    return _uniforms[--_nUniforms];
+}
+
+double CounterRandom::Stream::gaussian() {
+    if (_hasGaussian) {
+        _hasGaussian = false;
+        return _gaussian;
+    }
+    // Box-Muller transform; both uniforms are strictly positive, so the log is always finite.
+    double r = std::sqrt(-2.0*std::log(uniform()));
+    double theta = 2.0*M_PI*uniform();
+    _gaussian = r*std::sin(theta);
+    _hasGaussian = true;
+    return r*std::cos(theta);
+}
+
+double CounterRandom::Stream::chisq(double nu) {
+    // Inverting the CDF uses exactly one uniform per variate, which keeps the number of draws per
+    // sample fixed.
+    return 2.0*boost::math::gamma_p_inv(0.5*nu, uniform());
+}
+
+}}} // namespace lsst::meas::modelfit
@@ -0,0 +1,117 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ndarray/eigen.h"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/meas/modelfit/DirectSamplingObjective.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+class DirectSamplingObjective::DirectWorkspace : public SamplingObjective::Workspace {
+public:
+
+    explicit DirectWorkspace(PTR(Likelihood) likelihood_) :
+        Workspace(ndarray::allocate(likelihood_->getDataDim(), likelihood_->getAmplitudeDim())),
+        likelihood(likelihood_),
+        data(likelihood_->getData()),
+        nonlinear(ndarray::allocate(likelihood_->getNonlinearDim())),
+        amplitudes(ndarray::allocate(likelihood_->getAmplitudeDim()))
+    {}
+
+    PTR(Likelihood) likelihood;
+    ndarray::Array<Pixel const,1,1> data;
+    ndarray::Array<Scalar,1,1> nonlinear;
+    ndarray::Array<Scalar,1,1> amplitudes;
+};
+
+DirectSamplingObjective::DirectSamplingObjective(PTR(Likelihood) likelihood, PTR(Prior) prior) :
+    SamplingObjective(likelihood),
+    _factory(),
+    _prior(prior),
+    _workspace(new DirectWorkspace(likelihood))
+{}
+
+DirectSamplingObjective::DirectSamplingObjective(LikelihoodFactory factory, PTR(Prior) prior) :
+    SamplingObjective(factory()),
+    _factory(std::move(factory)),
+    _prior(prior),
+    _workspace(new DirectWorkspace(_likelihood))
+{}
+
+DirectSamplingObjective::~DirectSamplingObjective() {}
+
+int DirectSamplingObjective::getParameterDim() const {
+    return _likelihood->getNonlinearDim() + _likelihood->getAmplitudeDim();
+}
+
+Scalar DirectSamplingObjective::operator()(
+    ndarray::Array<Scalar const,1,1> const & parameters,
+    afw::table::BaseRecord & sample
+) const {
+    return evaluate(parameters, sample, *_workspace);
+}
+
+Scalar DirectSamplingObjective::evaluate(
+    ndarray::Array<Scalar const,1,1> const & parameters,
+    afw::table::BaseRecord & sample,
+    Workspace & workspace_
+) const {
+    DirectWorkspace & workspace = static_cast<DirectWorkspace &>(workspace_);
+    // Copy through raw pointers, as parameters may share an ndarray manager with other threads' samples.
+    Scalar const * begin = parameters.getData();
+    Scalar const * middle = begin + workspace.nonlinear.getSize<0>();
+    std::copy(begin, middle, workspace.nonlinear.getData());
+    std::copy(middle, middle + workspace.amplitudes.getSize<0>(), workspace.amplitudes.getData());
+    workspace.likelihood->computeModelMatrix(workspace.modelMatrix, workspace.nonlinear);
+    Vector residuals = ndarray::asEigenMatrix(workspace.modelMatrix).cast<Scalar>()
+        * ndarray::asEigenMatrix(workspace.amplitudes)
+        - ndarray::asEigenMatrix(workspace.data).cast<Scalar>();
+    Scalar result = 0.5*residuals.squaredNorm();
+    if (_prior) {
+        std::lock_guard<std::mutex> lock(_priorMutex);
+        result -= std::log(_prior->evaluate(workspace.nonlinear, workspace.amplitudes));
+    }
+    return result;
+}
+
+std::unique_ptr<SamplingObjective::Workspace> DirectSamplingObjective::makeWorkspace() const {
+    if (!_factory) {
+        return std::unique_ptr<Workspace>(new DirectWorkspace(_likelihood));
+    }
+    PTR(Likelihood) likelihood = _factory();
+    if (likelihood->getDataDim() != _likelihood->getDataDim()
+        || likelihood->getNonlinearDim() != _likelihood->getNonlinearDim()
+        || likelihood->getAmplitudeDim() != _likelihood->getAmplitudeDim()) {
+        throw LSST_EXCEPT(
+            pex::exceptions::LengthError,
+            "Likelihood factory returned a Likelihood with different dimensions"
+        );
+    }
+    return std::unique_ptr<Workspace>(new DirectWorkspace(likelihood));
+}
+
+}}} // namespace lsst::meas::modelfit
@@ -156,8 +156,12 @@ DoubleShapeletPsfApproxAlgorithm::DoubleShapeletPsfApproxAlgorithm(
     std::string const & name,
     afw::table::Schema & schema
 ) : _ctrl(ctrl),
+    _cache(),
     _centroidExtractor(schema, name)
 {
+    if (ctrl.warmStartMaxDistance > 0.0) {
+        _cache = std::make_shared<PsfFitCache>(ctrl.warmStartMaxDistance);
+    }
     std::vector<int> const orders = { ctrl.innerOrder, ctrl.outerOrder };
     _key = shapelet::MultiShapeletFunctionKey::addFields(
         schema,
@@ -191,6 +195,24 @@ shapelet::MultiShapeletFunction DoubleShapeletPsfApproxAlgorithm::initializeResu
     return result;
 }
 
+shapelet::MultiShapeletFunction DoubleShapeletPsfApproxAlgorithm::initializeResult(
+    Control const & ctrl,
+    shapelet::MultiShapeletFunction const & previous
+) {
+    if (previous.getComponents().size() != 2u
+        || previous.getComponents()[0].getOrder() != ctrl.innerOrder
+        || previous.getComponents()[1].getOrder() != ctrl.outerOrder) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            "Previous fit passed to initializeResult does not match the configured model"
+        );
+    }
+    shapelet::MultiShapeletFunction result(previous);
+    result.normalize();
+    result.transformInPlace(result.evaluate().computeMoments().getGridTransform());
+    return result;
+}
+
 void DoubleShapeletPsfApproxAlgorithm::fitMoments(
     shapelet::MultiShapeletFunction & result,
     Control const & ctrl,
@@ -461,11 +483,18 @@ void DoubleShapeletPsfApproxAlgorithm::measure(
             INVALID_POINT_FOR_PSF.number
         );
     }
-    auto result = initializeResult(_ctrl);
+    PTR(shapelet::MultiShapeletFunction) previous;
+    if (_cache) {
+        previous = _cache->find(psf, position);
+    }
+    auto result = previous ? initializeResult(_ctrl, *previous) : initializeResult(_ctrl);
     fitMoments(result, _ctrl, *psfImage);
     fitProfile(result, _ctrl, *psfImage);
     fitShapelets(result, _ctrl, *psfImage);
     measRecord.set(_key, result);
+    if (_cache) {
+        _cache->insert(psf, position, result);
+    }
 }
 
 
@@ -27,6 +27,8 @@
 #include "lsst/pex/exceptions.h"
 #include "lsst/shapelet/MatrixBuilder.h"
 #include "lsst/shapelet/MultiShapeletBasis.h"
+#include "lsst/shapelet/BasisEvaluator.h"
+#include "lsst/afw/geom/ellipses/GridTransform.h"
 #include "lsst/meas/modelfit/GeneralPsfFitter.h"
 
 namespace lsst { namespace meas { namespace modelfit {
@@ -74,7 +76,27 @@ public:
         NameVector amplitudeNames,
         NameVector fixedNames,
         ComponentVector components
-    ) : Model(basisVector, nonlinearNames, amplitudeNames, fixedNames), _components(components) {}
+    ) : Model(basisVector, nonlinearNames, amplitudeNames, fixedNames), _components(components) {
+        // Record which ellipse parameter each nonlinear parameter is an offset to; this has to be
+        // consistent with the iteration in writeEllipses and readEllipses.
+        for (std::size_t n = 0; n < _components.size(); ++n) {
+            GeneralPsfFitterComponentControl const & ctrl = _components[n].second;
+            if (ctrl.ellipticityPriorSigma > 0.0) {
+                _nonlinearMap.push_back(std::make_pair(n, 0));
+                _nonlinearMap.push_back(std::make_pair(n, 1));
+            }
+            if (ctrl.radiusPriorSigma > 0.0) {
+                _nonlinearMap.push_back(std::make_pair(n, 2));
+            }
+            if (ctrl.positionPriorSigma > 0.0) {
+                _nonlinearMap.push_back(std::make_pair(n, 3));
+                _nonlinearMap.push_back(std::make_pair(n, 4));
+            }
+        }
+    }
+
+    /// Return (component index, ellipse parameter index) pairs for each nonlinear parameter.
+    std::vector<std::pair<int,int>> const & getNonlinearMap() const { return _nonlinearMap; }
 
     virtual PTR(Prior) adaptPrior(PTR(Prior) prior) const {
         if (prior->getTag() != "PSF") {
@@ -222,6 +244,7 @@ public:
 
 private:
     ComponentVector _components;
+    std::vector<std::pair<int,int>> _nonlinearMap;
 };
 
 class GeneralPsfFitterPrior : public Prior {
@@ -599,18 +622,29 @@ public:
         Model::EllipseVector const & ellipses,
         Model::BasisVector const & basisVector,
         Scalar sigma
-    ) : _ellipses(ellipses),
+    ) : _x(x), _y(y),
+        _ellipses(ellipses),
         _builders(),
         _sigma(sigma)
     {
         FactoryVector factories;
         factories.reserve(basisVector.size());
         _builders.reserve(basisVector.size());
+        _evaluators.reserve(basisVector.size());
         int workspaceSize = 0;
+        int maxBasisSize = 0;
         for (Model::BasisVector::const_iterator i = basisVector.begin(); i != basisVector.end(); ++i) {
             factories.push_back(shapelet::MatrixBuilderFactory<Pixel>(x, y, **i));
             workspaceSize = std::max(workspaceSize, factories.back().computeWorkspace());
+            // GeneralPsfFitter bases always have a single unscaled component with an identity matrix,
+            // so we can evaluate their derivatives directly with a BasisEvaluator.
+            int order = (*i)->begin()->getOrder();
+            _evaluators.push_back(shapelet::BasisEvaluator(order, shapelet::HERMITE));
+            maxBasisSize = std::max(maxBasisSize, shapelet::computeSize(order));
         }
+        _basis = ndarray::allocate(maxBasisSize);
+        _dBasisX = ndarray::allocate(maxBasisSize);
+        _dBasisY = ndarray::allocate(maxBasisSize);
         shapelet::MatrixBuilderWorkspace<Pixel> workspace(workspaceSize);
         for (FactoryVector::const_iterator i = factories.begin(); i != factories.end(); ++i) {
             shapelet::MatrixBuilderWorkspace<Pixel> wsCopy(workspace); // share workspace between builders
@@ -636,12 +670,84 @@ public:
         ndarray::asEigenMatrix(modelMatrix) /= _sigma;
     }
 
+    // Each column of the model matrix for a component is D*h_j(u), where u = T(x) is the grid transform
+    // of the component's ellipse applied to the pixel position, D is its determinant, and h_j is a
+    // Hermite basis function.  Contracting with the amplitudes gives f(x) = D*sum_j alpha_j h_j(u), so
+    // for each ellipse parameter p we have
+    //    df/dp = (dD/dp) * (alpha . h) + D * [(alpha . dh/du_x) du_x/dp + (alpha . dh/du_y) du_y/dp]
+    // which requires only one basis evaluation (with gradient) per pixel and component.
+    void differentiateModel(
+        ndarray::Array<Scalar,2,-1> const & modelDerivative,
+        ndarray::Array<Scalar const,1,1> const & nonlinear,
+        ndarray::Array<Scalar const,1,1> const & amplitudes,
+        ndarray::Array<Scalar const,1,1> const & fixed,
+        GeneralPsfFitterModel const & model
+    ) {
+        typedef geom::AffineTransform AT;
+        model.writeEllipses(nonlinear.begin(), fixed.begin(), _ellipses.begin());
+        modelDerivative.deep() = 0.0;
+        std::vector<std::pair<int,int>> const & nonlinearMap = model.getNonlinearMap();
+        int const nPix = _x.getSize<0>();
+        int amplitudeOffset = 0;
+        for (std::size_t i = 0; i < _evaluators.size(); ++i) {
+            int const basisSize = shapelet::computeSize(_evaluators[i].getOrder());
+            int const amplitudeEnd = amplitudeOffset + basisSize;
+            // nonlinear parameters that affect this component
+            std::vector<std::pair<int,int>> active;
+            for (std::size_t k = 0; k < nonlinearMap.size(); ++k) {
+                if (nonlinearMap[k].first == static_cast<int>(i)) {
+                    active.push_back(std::make_pair(k, nonlinearMap[k].second));
+                }
+            }
+            if (active.empty()) {
+                amplitudeOffset = amplitudeEnd;
+                continue;
+            }
+            afw::geom::ellipses::Ellipse::GridTransform gt(_ellipses[i]);
+            AT transform = gt;
+            afw::geom::ellipses::Ellipse::GridTransform::DerivativeMatrix dTransform = gt.d();
+            Scalar det = gt.getDeterminant();
+            Eigen::Matrix<Scalar,1,5> dDet = transform[AT::YY]*dTransform.row(AT::XX)
+                + transform[AT::XX]*dTransform.row(AT::YY)
+                - transform[AT::YX]*dTransform.row(AT::XY)
+                - transform[AT::XY]*dTransform.row(AT::YX);
+            auto alpha = ndarray::asEigenMatrix(amplitudes[ndarray::view(amplitudeOffset, amplitudeEnd)]);
+            ndarray::Array<double,1> h = _basis[ndarray::view(0, basisSize)];
+            ndarray::Array<double,1> hx = _dBasisX[ndarray::view(0, basisSize)];
+            ndarray::Array<double,1> hy = _dBasisY[ndarray::view(0, basisSize)];
+            for (int j = 0; j < nPix; ++j) {
+                geom::Point2D u = transform(geom::Point2D(_x[j], _y[j]));
+                _evaluators[i].fillEvaluation(h, u.getX(), u.getY(), hx, hy);
+                Scalar f = ndarray::asEigenMatrix(h).dot(alpha);
+                Scalar fx = det*ndarray::asEigenMatrix(hx).dot(alpha);
+                Scalar fy = det*ndarray::asEigenMatrix(hy).dot(alpha);
+                for (std::size_t a = 0; a < active.size(); ++a) {
+                    int const p = active[a].second;
+                    Scalar dux = dTransform(AT::XX, p)*_x[j] + dTransform(AT::XY, p)*_y[j]
+                        + dTransform(AT::X, p);
+                    Scalar duy = dTransform(AT::YX, p)*_x[j] + dTransform(AT::YY, p)*_y[j]
+                        + dTransform(AT::Y, p);
+                    modelDerivative[j][active[a].first] = dDet[p]*f + fx*dux + fy*duy;
+                }
+            }
+            amplitudeOffset = amplitudeEnd;
+        }
+        ndarray::asEigenMatrix(modelDerivative) /= _sigma;
+    }
+
 private:
     typedef std::vector< shapelet::MatrixBuilder<Pixel> > BuilderVector;
     typedef std::vector< shapelet::MatrixBuilderFactory<Pixel> > FactoryVector;
+    typedef std::vector< shapelet::BasisEvaluator > EvaluatorVector;
 
+    ndarray::Array<Pixel const,1,1> _x;
+    ndarray::Array<Pixel const,1,1> _y;
     Model::EllipseVector _ellipses;
     BuilderVector _builders;
+    EvaluatorVector _evaluators;
+    ndarray::Array<double,1,1> _basis;
+    ndarray::Array<double,1,1> _dBasisX;
+    ndarray::Array<double,1,1> _dBasisY;
     Scalar _sigma;
 };
 
@@ -681,6 +787,21 @@ void MultiShapeletPsfLikelihood::computeModelMatrix(
     return _impl->computeModelMatrix(modelMatrix, nonlinear, _fixed, *getModel());
 }
 
+bool MultiShapeletPsfLikelihood::differentiateModel(
+    ndarray::Array<Scalar,2,-1> const & modelDerivative,
+    ndarray::Array<Scalar const,1,1> const & nonlinear,
+    ndarray::Array<Scalar const,1,1> const & amplitudes,
+    bool doApplyWeights
+) const {
+    PTR(GeneralPsfFitterModel) model = std::dynamic_pointer_cast<GeneralPsfFitterModel>(getModel());
+    if (!model) {
+        // we only know how to differentiate the models GeneralPsfFitter constructs
+        return false;
+    }
+    _impl->differentiateModel(modelDerivative, nonlinear, amplitudes, _fixed, *model);
+    return true;
+}
+
 MultiShapeletPsfLikelihood::~MultiShapeletPsfLikelihood() {}
 
 }}} // namespace lsst::meas::modelfit
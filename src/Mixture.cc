@@ -21,6 +21,10 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "boost/math/special_functions/gamma.hpp"
 
 #include "ndarray/eigen.h"
@@ -31,6 +35,7 @@
 #include "lsst/afw/table/io/CatalogVector.h"
 #include "lsst/afw/table/io/Persistable.cc"
 #include "lsst/meas/modelfit/Mixture.h"
+#include "lsst/meas/modelfit/detail/parallel.h"
 
 namespace tbl = lsst::afw::table;
 
@@ -48,9 +53,29 @@ template std::shared_ptr<meas::modelfit::Mixture> PersistableFacade<meas::modelf
 namespace meas {
 namespace modelfit {
 
+namespace {
+
+// Number of points evaluated together by the vectorized Mixture evaluation methods.
+int const EVALUATE_BLOCK_SIZE = 128;
+
+// Number of samples processed together in the expectation step of updateEM.
+int const EM_BLOCK_SIZE = 1024;
+
+// Minimum number of samples drawn by each thread when drawing with a CounterRandom.
+int const DRAW_CHUNK_SIZE = 256;
+
+} // anonymous
+
 void MixtureComponent::setSigma(Matrix const & sigma) {
     _sigmaLLT.compute(sigma);
+    _updateSigmaProperties();
+}
+
+void MixtureComponent::_updateSigmaProperties() {
     _sqrtDet = _sigmaLLT.matrixLLT().diagonal().prod();
+    _maxSigmaEigenvalue = Eigen::SelfAdjointEigenSolver<Matrix>(
+        getSigma(), Eigen::EigenvaluesOnly
+    ).eigenvalues().maxCoeff();
 }
 
 MixtureComponent MixtureComponent::project(int dim) const {
@@ -73,7 +98,8 @@ MixtureComponent MixtureComponent::project(int dim1, int dim2) const {
 }
 
 MixtureComponent::MixtureComponent(int dim) :
-    weight(1.0), _sqrtDet(1.0), _mu(Vector::Zero(dim)), _sigmaLLT(Matrix::Identity(dim,dim)) {}
+    weight(1.0), _sqrtDet(1.0), _maxSigmaEigenvalue(1.0),
+    _mu(Vector::Zero(dim)), _sigmaLLT(Matrix::Identity(dim,dim)) {}
 
 
 MixtureComponent::MixtureComponent(Scalar weight_, Vector const & mu, Matrix const & sigma) :
@@ -90,7 +116,7 @@ MixtureComponent::MixtureComponent(Scalar weight_, Vector const & mu, Matrix con
         "Number of columns of sigma matrix (%d) does not match size of mu vector (%d)"
     );
     _sigmaLLT.compute(sigma);
-    _sqrtDet = _sigmaLLT.matrixLLT().diagonal().prod();
+    _updateSigmaProperties();
 }
 
 MixtureComponent & MixtureComponent::operator=(MixtureComponent const & other) {
@@ -101,6 +127,7 @@ MixtureComponent & MixtureComponent::operator=(MixtureComponent const & other) {
     );
     if (&other != this) {
         _sqrtDet = other._sqrtDet;
+        _maxSigmaEigenvalue = other._maxSigmaEigenvalue;
         _mu = other._mu;
         _sigmaLLT = other._sigmaLLT;
     }
@@ -122,7 +149,9 @@ PTR(Mixture) Mixture::project(int dim) const {
     for (const_iterator i = begin(); i != end(); ++i) {
         components.push_back(i->project(dim));
     }
-    return std::make_shared<Mixture>(1, components, _df);
+    auto result = std::make_shared<Mixture>(1, components, _df);
+    result->setEvaluationTolerance(_tolerance);
+    return result;
 }
 
 PTR(Mixture) Mixture::project(int dim1, int dim2) const {
@@ -131,7 +160,9 @@ PTR(Mixture) Mixture::project(int dim1, int dim2) const {
     for (const_iterator i = begin(); i != end(); ++i) {
         components.push_back(i->project(dim1, dim2));
     }
-    return std::make_shared<Mixture>(2, components, _df);
+    auto result = std::make_shared<Mixture>(2, components, _df);
+    result->setEvaluationTolerance(_tolerance);
+    return result;
 }
 
 void Mixture::normalize() {
@@ -176,6 +207,97 @@ void Mixture::setDegreesOfFreedom(Scalar df) {
     }
 }
 
+void Mixture::setEvaluationTolerance(Scalar tolerance) {
+    if (!(tolerance >= 0.0)) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("Evaluation tolerance must be >= 0; got %g") % tolerance).str()
+        );
+    }
+    _tolerance = tolerance;
+}
+
+Scalar Mixture::evaluateWithErrorBound(Eigen::Ref<Vector const> const & x, Scalar & errorBound) const {
+    LSST_THROW_IF_NE(
+        x.size(), _dim,
+        pex::exceptions::LengthError,
+        "Size of x array (%d) does not dimension of mixture (%d)"
+    );
+    std::vector<std::pair<Scalar,int>> order;
+    int nUsed = 0;
+    return _evaluatePruned(x, order, nUsed, errorBound);
+}
+
+Scalar Mixture::_evaluatePruned(
+    Eigen::Ref<Vector const> const & x,
+    std::vector<std::pair<Scalar,int>> & order,
+    int & nUsed,
+    Scalar & errorBound
+) const {
+    int const nComponents = _components.size();
+    // Because L L^T = sigma, |L^{-1} d|^2 >= |d|^2 / lambda_max(sigma), and _evaluate is decreasing in z,
+    // so replacing z with that lower bound gives an upper bound on each component's contribution.
+    order.resize(nComponents);
+    for (int k = 0; k < nComponents; ++k) {
+        Component const & component = _components[k];
+        Scalar zMin = (x - component._mu).squaredNorm() / component._maxSigmaEigenvalue;
+        order[k].first = component.weight * _evaluate(zMin) / component._sqrtDet;
+        order[k].second = k;
+    }
+    std::sort(order.begin(), order.end(), std::greater<std::pair<Scalar,int>>());
+    // remaining[k] is the sum of the bounds of components k and later (in sorted order); we sum from
+    // the smallest bound up to avoid round-off in the tail.
+    std::vector<Scalar> remaining(nComponents + 1, 0.0);
+    for (int k = nComponents - 1; k >= 0; --k) {
+        remaining[k] = remaining[k + 1] + order[k].first;
+    }
+    Scalar p = 0.0;
+    nUsed = 0;
+    while (nUsed < nComponents && remaining[nUsed] > _tolerance*p) {
+        p += evaluate(_components[order[nUsed].second], x);
+        ++nUsed;
+    }
+    errorBound = remaining[nUsed];
+    return p;
+}
+
+template <typename Derived>
+void Mixture::_computeZBlock(
+    Component const & component,
+    Eigen::MatrixBase<Derived> const & x,
+    Matrix & dx,
+    Eigen::ArrayXd & z
+) const {
+    int const size = x.rows();
+    // Solve for the whitened offsets of all points at once, as a single triangular matrix solve.
+    auto dxBlock = dx.leftCols(size);
+    dxBlock = x.transpose();
+    dxBlock.colwise() -= component._mu;
+    component._sigmaLLT.matrixL().solveInPlace(dxBlock);
+    z.head(size) = dxBlock.colwise().squaredNorm().transpose().array();
+}
+
+void Mixture::_evaluateProfile(Eigen::Ref<Eigen::ArrayXd> z) const {
+    if (_isGaussian) {
+        z = (-0.5*z).exp() / _norm;
+    } else {
+        z = (z/_df + 1.0).pow(-0.5*(_df + _dim)) / _norm;
+    }
+}
+
+template <typename Derived>
+void Mixture::_evaluateBlock(
+    Component const & component,
+    Eigen::MatrixBase<Derived> const & x,
+    Matrix & dx,
+    Eigen::ArrayXd & z
+) const {
+    int const size = x.rows();
+    _computeZBlock(component, x, dx, z);
+    _evaluateProfile(z.head(size));
+    z.head(size) *= component.weight / component._sqrtDet;
+}
+
 void Mixture::evaluate(
     ndarray::Array<Scalar const,2,1> const & x,
     ndarray::Array<Scalar,1,0> const & p
@@ -190,10 +312,28 @@ void Mixture::evaluate(
         pex::exceptions::LengthError,
         "Second dimension of x array (%d) does not dimension of mixture (%d)"
     );
-    ndarray::Array<Scalar const,2,1>::Iterator ix = x.begin(), xEnd = x.end();
-    ndarray::Array<Scalar,1,0>::Iterator ip = p.begin();
-    for (; ix != xEnd; ++ix, ++ip) {
-        *ip = evaluate(ndarray::asEigenMatrix(*ix));
+    if (_tolerance > 0.0) {
+        // Pruning selects different components for each point, so we can't block over points.
+        ndarray::Array<Scalar const,2,1>::Iterator ix = x.begin(), xEnd = x.end();
+        ndarray::Array<Scalar,1,0>::Iterator ip = p.begin();
+        for (; ix != xEnd; ++ix, ++ip) {
+            *ip = evaluate(ndarray::asEigenMatrix(*ix));
+        }
+        return;
+    }
+    int const nPoints = x.getSize<0>();
+    auto xEigen = ndarray::asEigenMatrix(x);
+    auto pEigen = ndarray::asEigenArray(p);
+    Matrix dx(_dim, EVALUATE_BLOCK_SIZE);
+    Eigen::ArrayXd z(EVALUATE_BLOCK_SIZE);
+    for (int start = 0; start < nPoints; start += EVALUATE_BLOCK_SIZE) {
+        int const size = std::min(EVALUATE_BLOCK_SIZE, nPoints - start);
+        auto pBlock = pEigen.segment(start, size);
+        pBlock.setZero();
+        for (const_iterator k = begin(); k != end(); ++k) {
+            _evaluateBlock(*k, xEigen.middleRows(start, size), dx, z);
+            pBlock += z.head(size);
+        }
     }
 }
 
@@ -216,12 +356,17 @@ void Mixture::evaluateComponents(
         pex::exceptions::LengthError,
         "Second dimension of p array (%d) does not match number of components (%d)"
     );
-    ndarray::Array<Scalar const,2,1>::Iterator ix = x.begin(), xEnd = x.end();
-    ndarray::Array<Scalar,2,1>::Iterator ip = p.begin();
-    for (; ix != xEnd; ++ix, ++ip) {
-        ndarray::Array<Scalar,2,1>::Reference::Iterator jp = ip->begin();
-        for (const_iterator j = begin(); j != end(); ++j, ++jp) {
-            *jp = evaluate(*j, ndarray::asEigenMatrix(*ix));
+    int const nPoints = x.getSize<0>();
+    int const nComponents = _components.size();
+    auto xEigen = ndarray::asEigenMatrix(x);
+    auto pEigen = ndarray::asEigenMatrix(p);
+    Matrix dx(_dim, EVALUATE_BLOCK_SIZE);
+    Eigen::ArrayXd z(EVALUATE_BLOCK_SIZE);
+    for (int start = 0; start < nPoints; start += EVALUATE_BLOCK_SIZE) {
+        int const size = std::min(EVALUATE_BLOCK_SIZE, nPoints - start);
+        for (int k = 0; k < nComponents; ++k) {
+            _evaluateBlock(_components[k], xEigen.middleRows(start, size), dx, z);
+            pEigen.col(k).segment(start, size) = z.head(size).matrix();
         }
     }
 }
@@ -294,33 +439,40 @@ void Mixture::_evaluateDerivativesImpl(
         hessian->setZero();
     }
     Eigen::MatrixXd sigmaInv(_dim, _dim);
-    for (ComponentList::const_iterator i = _components.begin(); i != _components.end(); ++i) {
-        _workspace = x - i->_mu;
-        i->_sigmaLLT.matrixL().solveInPlace(_workspace);
-        Scalar z = _workspace.squaredNorm();
-        i->_sigmaLLT.matrixL().adjoint().solveInPlace(_workspace);
+    Vector workspace(_dim);
+    std::vector<std::pair<Scalar,int>> order;
+    int nUsed = _components.size();
+    if (_tolerance > 0.0) {
+        Scalar errorBound;
+        _evaluatePruned(x, order, nUsed, errorBound);
+    }
+    for (int n = 0; n < nUsed; ++n) {
+        ComponentList::const_iterator i = _components.begin() + (order.empty() ? n : order[n].second);
+        workspace = x - i->_mu;
+        i->_sigmaLLT.matrixL().solveInPlace(workspace);
+        Scalar z = workspace.squaredNorm();
+        i->_sigmaLLT.matrixL().adjoint().solveInPlace(workspace);
         sigmaInv.setIdentity();
         i->_sigmaLLT.matrixL().solveInPlace(sigmaInv);
         i->_sigmaLLT.matrixL().adjoint().solveInPlace(sigmaInv);
         Scalar f = _evaluate(z) / i->_sqrtDet;
         if (_isGaussian) {
-            gradient += -i->weight * f * _workspace;
+            gradient += -i->weight * f * workspace;
             if (computeHessian) {
-                *hessian += i->weight * f * (_workspace * _workspace.adjoint() - sigmaInv);
+                *hessian += i->weight * f * (workspace * workspace.adjoint() - sigmaInv);
             }
         } else {
             double v = (_dim + _df) / (_df + z);
             double u = v*v*(1.0 + 2.0/(_dim + _df));
-            gradient += -i->weight * f * v * _workspace;
+            gradient += -i->weight * f * v * workspace;
             if (computeHessian) {
-                *hessian += i->weight * f * (u * _workspace * _workspace.adjoint() - v * sigmaInv);
+                *hessian += i->weight * f * (u * workspace * workspace.adjoint() - v * sigmaInv);
             }
         }
     }
 }
 
-void Mixture::draw(afw::math::Random & rng, ndarray::Array<Scalar,2,1> const & x) const {
-    ndarray::Array<Scalar,2,1>::Iterator ix = x.begin(), xEnd = x.end();
+std::vector<Scalar> Mixture::_computeCumulativeWeights() const {
     std::vector<Scalar> cumulative;
     cumulative.reserve(_components.size());
     Scalar sum = 0.0;
@@ -329,90 +481,280 @@ void Mixture::draw(afw::math::Random & rng, ndarray::Array<Scalar,2,1> const & x
         cumulative.push_back(sum);
     }
     cumulative.back() = 1.0;
+    return cumulative;
+}
+
+template <typename Rng>
+void Mixture::_drawOne(
+    Rng & rng,
+    std::vector<Scalar> const & cumulative,
+    Vector & workspace,
+    Scalar * x
+) const {
+    Scalar target = rng.uniform();
+    std::size_t k = std::lower_bound(cumulative.begin(), cumulative.end(), target)
+        - cumulative.begin();
+    assert(k != cumulative.size());
+    Component const & component = _components[k];
+    for (int j = 0; j < _dim; ++j) {
+        workspace[j] = rng.gaussian();
+    }
+    if (!_isGaussian) {
+        workspace *= std::sqrt(_df/rng.chisq(_df));
+    }
+    Eigen::Map<Vector>(x, _dim) = component._mu + (component._sigmaLLT.matrixL() * workspace);
+}
+
+void Mixture::draw(afw::math::Random & rng, ndarray::Array<Scalar,2,1> const & x) const {
+    ndarray::Array<Scalar,2,1>::Iterator ix = x.begin(), xEnd = x.end();
+    std::vector<Scalar> cumulative = _computeCumulativeWeights();
+    Vector workspace(_dim);
     for (; ix != xEnd; ++ix) {
-        Scalar target = rng.uniform();
-        std::size_t k = std::lower_bound(cumulative.begin(), cumulative.end(), target)
-            - cumulative.begin();
-        assert(k != cumulative.size());
-        Component const & component = _components[k];
-        for (int j = 0; j < _dim; ++j) {
-            _workspace[j] = rng.gaussian();
-        }
-        if (!_isGaussian) {
-            _workspace *= std::sqrt(_df/rng.chisq(_df));
+        _drawOne(rng, cumulative, workspace, ix->getData());
+    }
+}
+
+void Mixture::draw(
+    CounterRandom const & rng,
+    ndarray::Array<Scalar,2,1> const & x,
+    std::uint64_t offset,
+    int nThreads
+) const {
+    LSST_THROW_IF_NE(
+        x.getSize<1>(), _dim,
+        pex::exceptions::LengthError,
+        "Second dimension of x array (%d) does not dimension of mixture (%d)"
+    );
+    if (nThreads < 1) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("nThreads must be >= 1; got %d") % nThreads).str()
+        );
+    }
+    std::vector<Scalar> const cumulative = _computeCumulativeWeights();
+    // Use raw pointers in the threads; ndarray views are not safe to copy between threads.
+    Scalar * const data = x.getData();
+    int const stride = x.getStride<0>();
+    detail::parallelFor(
+        x.getSize<0>(), nThreads, DRAW_CHUNK_SIZE,
+        [this, &rng, &cumulative, data, stride, offset](int, int begin, int end) {
+            Vector workspace(_dim);
+            for (int i = begin; i < end; ++i) {
+                CounterRandom::Stream stream = rng.getStream(offset + i);
+                _drawOne(stream, cumulative, workspace, data + i*stride);
+            }
         }
-        ndarray::asEigenMatrix(*ix) = component._mu + (component._sigmaLLT.matrixL() * _workspace);
+    );
+}
+
+MixtureEMStatistics::MixtureEMStatistics(Mixture const & mixture) :
+    _dim(mixture.getDimension()),
+    _weight(Vector::Zero(mixture.size())),
+    _gammaWeight(Vector::Zero(mixture.size()))
+{
+    _center.reserve(mixture.size());
+    _first.reserve(mixture.size());
+    _second.reserve(mixture.size());
+    for (Mixture::const_iterator i = mixture.begin(); i != mixture.end(); ++i) {
+        _center.push_back(i->getMu());
+        _first.push_back(Vector::Zero(_dim));
+        _second.push_back(Matrix::Zero(_dim, _dim));
     }
 }
 
-void Mixture::updateEM(
-    ndarray::Array<Scalar const,2,1> const & x,
-    ndarray::Array<Scalar const,1,0> const & w,
-    UpdateRestriction const & restriction,
-    Scalar tau1, Scalar tau2
-) {
+void MixtureEMStatistics::reset() {
+    _weight.setZero();
+    _gammaWeight.setZero();
+    for (int k = 0; k < getComponentCount(); ++k) {
+        _first[k].setZero();
+        _second[k].setZero();
+    }
+}
+
+void MixtureEMStatistics::scale(Scalar factor) {
+    _weight *= factor;
+    _gammaWeight *= factor;
+    for (int k = 0; k < getComponentCount(); ++k) {
+        _first[k] *= factor;
+        _second[k] *= factor;
+    }
+}
+
+void MixtureEMStatistics::add(MixtureEMStatistics const & other, Scalar factor) {
     LSST_THROW_IF_NE(
-        x.getSize<0>(), w.getSize<0>(),
+        other.getComponentCount(), getComponentCount(),
         pex::exceptions::LengthError,
-        "First dimension of x array (%d) does not match size of w array (%d)"
+        "Number of components in statistics to add (%d) does not match this (%d)"
     );
     LSST_THROW_IF_NE(
-        x.getSize<1>(), _dim,
+        other.getDimension(), getDimension(),
         pex::exceptions::LengthError,
-        "Second dimension of x array (%d) does not dimension of mixture (%d)"
+        "Dimension of statistics to add (%d) does not match this (%d)"
     );
-    int const nSamples = w.getSize<0>();
+    _weight += factor*other._weight;
+    _gammaWeight += factor*other._gammaWeight;
+    for (int k = 0; k < getComponentCount(); ++k) {
+        _first[k] += factor*other._first[k];
+        _second[k] += factor*other._second[k];
+        if (other._center[k] != _center[k]) {
+            // Shift the other moments from its center to ours: with d = c_other - c,
+            // sum r*g*(x - c) = first_other + G*d, and
+            // sum r*g*(x - c)(x - c)^T = second_other + first_other*d^T + d*first_other^T + G*d*d^T.
+            Vector d = other._center[k] - _center[k];
+            Scalar g = factor*other._gammaWeight[k];
+            _first[k] += g*d;
+            _second[k] += factor*(other._first[k]*d.adjoint() + d*other._first[k].adjoint())
+                + g*d*d.adjoint();
+        }
+    }
+}
+
+template <typename X, typename W>
+void Mixture::_accumulateEMRange(
+    X const & x, W const & w, int begin, int end,
+    MixtureEMStatistics & stats
+) const {
     int const nComponents = _components.size();
-    Matrix p(nSamples, nComponents);
-    Matrix gamma(nSamples, nComponents);
-    for (int i = 0; i < nSamples; ++i) {
-        Scalar pSum = 0.0;
+    Matrix dx(_dim, EM_BLOCK_SIZE);
+    Matrix y(EM_BLOCK_SIZE, _dim);
+    Eigen::ArrayXd z(EM_BLOCK_SIZE);
+    Eigen::ArrayXd rowScale(EM_BLOCK_SIZE);
+    Eigen::ArrayXd rg(EM_BLOCK_SIZE);
+    Eigen::ArrayXXd r(EM_BLOCK_SIZE, nComponents);
+    Eigen::ArrayXXd gamma(EM_BLOCK_SIZE, nComponents);
+    for (int start = begin; start < end; start += EM_BLOCK_SIZE) {
+        int const size = std::min(EM_BLOCK_SIZE, end - start);
+        auto xBlock = x.middleRows(start, size);
+        // Compute responsibilities (and Student's T scale factors) for the whole block.
         for (int k = 0; k < nComponents; ++k) {
-            double z = _computeZ(_components[k], ndarray::asEigenMatrix(x[i]));
-            pSum += p(i, k) = _components[k].weight*_evaluate(z)/_components[k]._sqrtDet;
+            Component const & component = _components[k];
+            _computeZBlock(component, xBlock, dx, z);
             if (!_isGaussian) {
-                gamma(i, k) = (_df + _dim) / (_df + z);
+                gamma.col(k).head(size) = (_df + _dim) / (_df + z.head(size));
             }
+            _evaluateProfile(z.head(size));
+            r.col(k).head(size) = z.head(size) * component.weight / component._sqrtDet;
         }
-        p.row(i) *= w[i] / pSum;
-    }
-    if (_isGaussian) {
+        auto rBlock = r.topRows(size);
+        rowScale.head(size) = w.segment(start, size) / rBlock.rowwise().sum();
+        rBlock.colwise() *= rowScale.head(size);
+        // Accumulate moments relative to the statistics' centers, with one matrix product per component.
         for (int k = 0; k < nComponents; ++k) {
-            double weight = _components[k].weight = p.col(k).sum();
-            Vector & mu = _components[k]._mu;
-            Matrix sigma = Matrix::Zero(_dim, _dim);
-            mu = (p.col(k).adjoint() * ndarray::asEigenMatrix(x)) / weight;
-            restriction.restrictMu(mu);
-            Vector dx = Vector::Zero(_dim);
-            for (int i = 0; i < nSamples; ++i) {
-                dx = ndarray::asEigenMatrix(x[i]) - mu;
-                sigma.selfadjointView<Eigen::Lower>().rankUpdate(dx, p(i, k));
+            if (_isGaussian) {
+                rg.head(size) = rBlock.col(k);
+            } else {
+                rg.head(size) = rBlock.col(k) * gamma.col(k).head(size);
             }
-            sigma /= weight;
-            restriction.restrictSigma(sigma);
-            updateDampedSigma(k, sigma, tau1, tau2);
+            stats._weight[k] += rBlock.col(k).sum();
+            stats._gammaWeight[k] += rg.head(size).sum();
+            auto yBlock = y.topRows(size);
+            yBlock = xBlock.rowwise() - stats._center[k].transpose();
+            stats._first[k].noalias() += yBlock.transpose() * rg.head(size).matrix();
+            stats._second[k].noalias()
+                += yBlock.transpose() * (yBlock.array().colwise() * rg.head(size)).matrix();
         }
-    } else {
-        for (int k = 0; k < nComponents; ++k) {
-            double weight = _components[k].weight = p.col(k).sum();
-            Vector & mu = _components[k]._mu;
-            Matrix sigma = Matrix::Zero(_dim, _dim);
-            mu =
-                ((p.col(k).array() * gamma.col(k).array()).matrix().adjoint() * ndarray::asEigenMatrix(x))
-                / p.col(k).dot(gamma.col(k));
-            restriction.restrictMu(mu);
-            Vector dx = Vector::Zero(_dim);
-            for (int i = 0; i < nSamples; ++i) {
-                dx = ndarray::asEigenMatrix(x[i]) - mu;
-                sigma.selfadjointView<Eigen::Lower>().rankUpdate(dx, gamma(i, k) * p(i, k));
-            }
-            sigma /= weight;
-            restriction.restrictSigma(sigma);
-            updateDampedSigma(k, sigma, tau1, tau2);
+    }
+}
+
+void Mixture::accumulateEM(
+    ndarray::Array<Scalar const,2,1> const & x,
+    ndarray::Array<Scalar const,1,0> const & w,
+    MixtureEMStatistics & stats,
+    int nThreads
+) const {
+    LSST_THROW_IF_NE(
+        x.getSize<0>(), w.getSize<0>(),
+        pex::exceptions::LengthError,
+        "First dimension of x array (%d) does not match size of w array (%d)"
+    );
+    LSST_THROW_IF_NE(
+        x.getSize<1>(), _dim,
+        pex::exceptions::LengthError,
+        "Second dimension of x array (%d) does not dimension of mixture (%d)"
+    );
+    LSST_THROW_IF_NE(
+        stats.getDimension(), _dim,
+        pex::exceptions::LengthError,
+        "Dimension of EM statistics (%d) does not match dimension of mixture (%d)"
+    );
+    LSST_THROW_IF_NE(
+        stats.getComponentCount(), static_cast<int>(_components.size()),
+        pex::exceptions::LengthError,
+        "Number of components in EM statistics (%d) does not match number in mixture (%d)"
+    );
+    if (nThreads < 1) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("nThreads must be >= 1; got %d") % nThreads).str()
+        );
+    }
+    int const nSamples = x.getSize<0>();
+    // Work on Eigen views from here on; unlike ndarray views, they're safe to copy between threads.
+    auto xEigen = ndarray::asEigenMatrix(x);
+    auto wEigen = ndarray::asEigenArray(w);
+    nThreads = std::min(nThreads, (nSamples + EM_BLOCK_SIZE - 1) / EM_BLOCK_SIZE);
+    if (nThreads <= 1) {
+        _accumulateEMRange(xEigen, wEigen, 0, nSamples, stats);
+        return;
+    }
+    std::vector<MixtureEMStatistics> partial(nThreads, stats);
+    for (auto & p : partial) {
+        p.reset();
+    }
+    int const nChunks = detail::parallelFor(
+        nSamples, nThreads, EM_BLOCK_SIZE,
+        [this, &xEigen, &wEigen, &partial](int chunk, int begin, int end) {
+            _accumulateEMRange(xEigen, wEigen, begin, end, partial[chunk]);
         }
+    );
+    for (int chunk = 0; chunk < nChunks; ++chunk) {
+        stats.add(partial[chunk]);
     }
 }
 
+void Mixture::updateEM(
+    MixtureEMStatistics const & stats,
+    UpdateRestriction const & restriction,
+    Scalar tau1, Scalar tau2
+) {
+    LSST_THROW_IF_NE(
+        stats.getDimension(), _dim,
+        pex::exceptions::LengthError,
+        "Dimension of EM statistics (%d) does not match dimension of mixture (%d)"
+    );
+    LSST_THROW_IF_NE(
+        stats.getComponentCount(), static_cast<int>(_components.size()),
+        pex::exceptions::LengthError,
+        "Number of components in EM statistics (%d) does not match number in mixture (%d)"
+    );
+    for (int k = 0, nComponents = _components.size(); k < nComponents; ++k) {
+        double weight = _components[k].weight = stats._weight[k];
+        Vector & mu = _components[k]._mu;
+        mu = stats._center[k] + stats._first[k] / stats._gammaWeight[k];
+        restriction.restrictMu(mu);
+        // Shift the second moment from the statistics' center to the (restricted) new mu.
+        Vector d = mu - stats._center[k];
+        Matrix sigma = stats._second[k] - d * stats._first[k].adjoint() - stats._first[k] * d.adjoint()
+            + stats._gammaWeight[k] * d * d.adjoint();
+        sigma /= weight;
+        // The restriction has always been given only the lower triangle of sigma.
+        sigma.triangularView<Eigen::StrictlyUpper>().setZero();
+        restriction.restrictSigma(sigma);
+        updateDampedSigma(k, sigma, tau1, tau2);
+    }
+}
+
+void Mixture::updateEM(
+    ndarray::Array<Scalar const,2,1> const & x,
+    ndarray::Array<Scalar const,1,0> const & w,
+    UpdateRestriction const & restriction,
+    Scalar tau1, Scalar tau2
+) {
+    MixtureEMStatistics stats(*this);
+    accumulateEM(x, w, stats);
+    updateEM(stats, restriction, tau1, tau2);
+}
+
 void Mixture::updateEM(
     ndarray::Array<Scalar const,2,1> const & x,
     ndarray::Array<Scalar const,1,0> const & w,
@@ -436,7 +778,7 @@ PTR(Mixture) Mixture::clone() const {
 }
 
 Mixture::Mixture(int dim, ComponentList & components, Scalar df) :
-    _dim(dim), _df(0.0), _workspace(dim)
+    _dim(dim), _df(0.0), _tolerance(0.0)
 {
     setDegreesOfFreedom(df);
     _components.swap(components);
@@ -454,7 +796,7 @@ void Mixture::updateDampedSigma(int k, Matrix const & sigma, double tau1, double
         _components[k].setSigma(alpha*sigma + (1.0 - alpha)*_components[k].getSigma());
     } else {
         _components[k]._sigmaLLT = sigmaLLT;
-        _components[k]._sqrtDet = sqrtDet;
+        _components[k]._updateSigmaProperties();
     }
 }
 
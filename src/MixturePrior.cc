@@ -66,6 +66,19 @@ Scalar MixturePrior::evaluate(
     }
 }
 
+void MixturePrior::evaluateBatch(
+    ndarray::Array<Scalar const,2,1> const & nonlinear,
+    ndarray::Array<Scalar const,2,1> const & amplitudes,
+    ndarray::Array<Scalar,1,1> const & output
+) const {
+    _checkBatchShapes(nonlinear, amplitudes, output);
+    _mixture->evaluate(nonlinear, output);
+    if (amplitudes.getSize<1>() > 0) {
+        auto out = ndarray::asEigenArray(output);
+        out = (ndarray::asEigenArray(amplitudes) < 0.0).rowwise().any().select(0.0, out);
+    }
+}
+
 void MixturePrior::evaluateDerivatives(
     ndarray::Array<Scalar const,1,1> const & nonlinear,
     ndarray::Array<Scalar const,1,1> const & amplitudes,
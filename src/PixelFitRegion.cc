@@ -21,17 +21,46 @@
  * the GNU General Public License along with this program.  If not,
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
+#include <algorithm>
 #include <cmath>
 
+#include "lsst/pex/exceptions.h"
 #include "lsst/meas/modelfit/PixelFitRegion.h"
 #include "lsst/afw/geom/SpanSet.h"
 #include "lsst/afw/geom/ellipses/Ellipse.h"
+#include "lsst/afw/geom/ellipses/PixelRegion.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
-namespace {
+BadPixelBitmap::BadPixelBitmap(
+    afw::image::Mask<> const & mask,
+    afw::image::MaskPixel badPixelMask,
+    geom::Box2I const & bbox
+) : _bbox(bbox.isEmpty() ? mask.getBBox(afw::image::PARENT) : bbox),
+    _badPixelMask(badPixelMask),
+    _maskData(mask.getArray().getData()),
+    _maskStrides(mask.getArray().getStrides()),
+    _wordsPerRow((_bbox.getWidth() + 63) / 64),
+    _bits(_wordsPerRow*_bbox.getHeight(), 0)
+{
+    if (!mask.getBBox(afw::image::PARENT).contains(_bbox)) {
+        throw LSST_EXCEPT(
+            pex::exceptions::LengthError,
+            "BadPixelBitmap bounding box is not contained by the mask"
+        );
+    }
+    geom::Extent2I offset = _bbox.getMin() - mask.getXY0();
+    ndarray::Array<afw::image::MaskPixel const,2,1> array = mask.getArray();
+    for (int y = 0; y < _bbox.getHeight(); ++y) {
+        afw::image::MaskPixel const * pixel = array[y + offset.getY()].begin() + offset.getX();
+        std::uint64_t * words = _bits.data() + y*_wordsPerRow;
+        for (int x = 0; x < _bbox.getWidth(); ++x, ++pixel) {
+            words[x >> 6] |= std::uint64_t((*pixel & badPixelMask) != 0) << (x & 63);
+        }
+    }
+}
 
-afw::image::MaskPixel initBadPixelMask(std::vector<std::string> const & planes) {
+afw::image::MaskPixel BadPixelBitmap::getPlaneBitMask(std::vector<std::string> const & planes) {
     afw::image::MaskPixel badPixelMask = 0x0;
     for (std::vector<std::string>::const_iterator iter = planes.begin(); iter != planes.end(); ++iter) {
         badPixelMask |= afw::image::Mask<>::getPlaneBitMask(*iter);
@@ -39,8 +68,61 @@ afw::image::MaskPixel initBadPixelMask(std::vector<std::string> const & planes)
     return badPixelMask;
 }
 
-} // anonymous
+bool BadPixelBitmap::isSnapshotOf(afw::image::Mask<> const & mask) const {
+    ndarray::Array<afw::image::MaskPixel const,2,1> array = mask.getArray();
+    return mask.getBBox(afw::image::PARENT) == _bbox && array.getData() == _maskData
+        && array.getStrides() == _maskStrides;
+}
+
+int BadPixelBitmap::_find(std::uint64_t const * row, int begin, int end, bool bad) const {
+    if (begin >= end) {
+        return end;
+    }
+    std::uint64_t const flip = bad ? 0x0 : ~std::uint64_t(0);
+    int w = begin >> 6;
+    // Bits at or after begin in the first word that have the state we're looking for.
+    std::uint64_t word = ((row[w] ^ flip) >> (begin & 63)) << (begin & 63);
+    int const wEnd = (end + 63) >> 6;
+    while (word == 0) {
+        if (++w >= wEnd) {
+            return end;
+        }
+        word = row[w] ^ flip;
+    }
+    return std::min(end, (w << 6) + __builtin_ctzll(word));
+}
 
+std::shared_ptr<afw::geom::SpanSet> BadPixelBitmap::rasterize(
+    afw::geom::ellipses::Ellipse const & ellipse,
+    int & nTotal,
+    int & nGood
+) const {
+    nTotal = 0;
+    nGood = 0;
+    std::vector<afw::geom::Span> spans;
+    afw::geom::ellipses::PixelRegion region(ellipse);
+    for (afw::geom::Span const & span : region) {
+        int const y = span.getY();
+        if (y < _bbox.getMinY() || y > _bbox.getMaxY()) {
+            continue;
+        }
+        int x0 = std::max(span.getMinX(), _bbox.getMinX()) - _bbox.getMinX();
+        int x1 = std::min(span.getMaxX(), _bbox.getMaxX()) - _bbox.getMinX() + 1;  // one past the end
+        if (x1 <= x0) {
+            continue;
+        }
+        nTotal += x1 - x0;
+        std::uint64_t const * row = _row(y);
+        int x = _find(row, x0, x1, false);
+        while (x < x1) {
+            int xEnd = _find(row, x, x1, true);
+            spans.emplace_back(y, x + _bbox.getMinX(), xEnd - 1 + _bbox.getMinX());
+            nGood += xEnd - x;
+            x = _find(row, xEnd, x1, false);
+        }
+    }
+    return std::make_shared<afw::geom::SpanSet>(std::move(spans));
+}
 
 PixelFitRegion::PixelFitRegion(
     PixelFitRegionControl const & ctrl,
@@ -55,8 +137,8 @@ PixelFitRegion::PixelFitRegion(
     maxBadPixelFraction(false),
     usedMinEllipse(false),
     usedMaxEllipse(false),
-    _ctrl(ctrl),
-    _badPixelMask(initBadPixelMask(ctrl.badMaskPlanes))
+    usedInformationTrim(false),
+    _ctrl(ctrl)
 {
     // Try setting ellipse to a multiple of the Kron ellipse, fall back
     // to Footprint area circle and then scaled PSF moments if necessary.
@@ -101,8 +183,8 @@ PixelFitRegion::PixelFitRegion(
     maxBadPixelFraction(false),
     usedMinEllipse(false),
     usedMaxEllipse(false),
-    _ctrl(ctrl),
-    _badPixelMask(initBadPixelMask(ctrl.badMaskPlanes))
+    usedInformationTrim(false),
+    _ctrl(ctrl)
 {
     if (ellipse.getArea() > _ctrl.maxArea) {
         maxArea = true;
@@ -112,7 +194,8 @@ PixelFitRegion::PixelFitRegion(
 
 bool PixelFitRegion::applyEllipse(
     afw::geom::ellipses::Quadrupole const & deconvolved,
-    afw::geom::ellipses::Quadrupole const & psfMoments
+    afw::geom::ellipses::Quadrupole const & psfMoments,
+    Scalar signalToNoise
 ) {
     bool constrained = false;
 
@@ -155,31 +238,53 @@ bool PixelFitRegion::applyEllipse(
     ellipse.scale(alpha);
     ellipse.convolve(ePsfGrow).inPlace();
 
+    // For faint sources, trim the region to where the model contributes most of the information.
+    if (signalToNoise > 0.0 && signalToNoise < _ctrl.maxTrimSignalToNoise) {
+        afw::geom::ellipses::Quadrupole informationEllipse(deconvolved);
+        informationEllipse.convolve(psfMoments).inPlace();
+        informationEllipse.scale(std::sqrt(-std::log1p(-_ctrl.informationFraction)));
+        if (informationEllipse.getArea() < ellipse.getArea()) {
+            ellipse = informationEllipse;
+            usedInformationTrim = true;
+            constrained = true;
+        }
+    }
+
     return constrained;
 }
 
 void PixelFitRegion::applyMask(afw::image::Mask<> const & mask, geom::Point2D const & center) {
+    // Only unpack the part of the mask we might need.
+    afw::geom::ellipses::Ellipse fullEllipse(ellipse, center);
+    geom::Box2I bbox = afw::geom::ellipses::PixelRegion(fullEllipse).getBBox();
+    bbox.clip(mask.getBBox(afw::image::PARENT));
+    if (bbox.isEmpty()) {
+        maxBadPixelFraction = true;
+        footprint.reset();
+        return;
+    }
+    applyMask(BadPixelBitmap(mask, BadPixelBitmap::getPlaneBitMask(_ctrl.badMaskPlanes), bbox), center);
+    if (footprint) {
+        footprint->setRegion(mask.getBBox(afw::image::PARENT));
+    }
+}
+
+void PixelFitRegion::applyMask(BadPixelBitmap const & bitmap, geom::Point2D const & center) {
     Scalar originalArea = ellipse.getArea();
-    footprint = std::make_shared<afw::detection::Footprint>(
-        afw::geom::SpanSet::fromShape(afw::geom::ellipses::Ellipse(ellipse, center)),
-        mask.getBBox(lsst::afw::image::PARENT)
-    );
-    footprint->clipTo(mask.getBBox(afw::image::PARENT));
-    if (footprint->getArea() == 0) {
+    int nTotal = 0;
+    int nGood = 0;
+    auto spans = bitmap.rasterize(afw::geom::ellipses::Ellipse(ellipse, center), nTotal, nGood);
+    if (nTotal == 0) {
         maxBadPixelFraction = true;
         footprint.reset();
         return;
     }
-    auto spans = footprint->getSpans()->intersectNot(mask, _badPixelMask);
-    footprint->setSpans(spans);
-    if (originalArea - spans->getArea() > originalArea*_ctrl.maxBadPixelFraction) {
+    if (originalArea - nGood > originalArea*_ctrl.maxBadPixelFraction) {
         maxBadPixelFraction = true;
         footprint.reset();
         return;
     }
+    footprint = std::make_shared<afw::detection::Footprint>(spans, bitmap.getBBox());
 }
 
-
-
-
 }}} // lsst::meas::modelfit
@@ -0,0 +1,59 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "ndarray.h"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/meas/modelfit/Prior.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+void Prior::evaluateBatch(
+    ndarray::Array<Scalar const,2,1> const & nonlinear,
+    ndarray::Array<Scalar const,2,1> const & amplitudes,
+    ndarray::Array<Scalar,1,1> const & output
+) const {
+    _checkBatchShapes(nonlinear, amplitudes, output);
+    for (int i = 0, n = output.getSize<0>(); i < n; ++i) {
+        output[i] = evaluate(nonlinear[i], amplitudes[i]);
+    }
+}
+
+void Prior::_checkBatchShapes(
+    ndarray::Array<Scalar const,2,1> const & nonlinear,
+    ndarray::Array<Scalar const,2,1> const & amplitudes,
+    ndarray::Array<Scalar,1,1> const & output
+) {
+    LSST_THROW_IF_NE(
+        nonlinear.getSize<0>(), output.getSize<0>(),
+        pex::exceptions::LengthError,
+        "Number of nonlinear parameter points (%d) does not match size of output array (%d)"
+    );
+    LSST_THROW_IF_NE(
+        amplitudes.getSize<0>(), output.getSize<0>(),
+        pex::exceptions::LengthError,
+        "Number of amplitude parameter points (%d) does not match size of output array (%d)"
+    );
+}
+
+}}} // namespace lsst::meas::modelfit
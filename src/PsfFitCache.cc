@@ -0,0 +1,85 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/meas/modelfit/PsfFitCache.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+PsfFitCache::PsfFitCache(Scalar maxDistance, int maxSize) :
+    _maxDistance(maxDistance), _maxSize(maxSize)
+{
+    if (maxSize < 1) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("PsfFitCache maxSize must be positive (got %d)") % maxSize).str()
+        );
+    }
+}
+
+int PsfFitCache::getSize() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+PTR(shapelet::MultiShapeletFunction) PsfFitCache::find(
+    PTR(afw::detection::Psf const) psf,
+    geom::Point2D const & position
+) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!psf || _psf.lock() != psf) {
+        return PTR(shapelet::MultiShapeletFunction)();
+    }
+    Scalar const maxDistanceSquared = _maxDistance*_maxDistance;
+    // Entries are ordered oldest-first, so search backwards to find the most recent match.
+    for (auto iter = _entries.rbegin(); iter != _entries.rend(); ++iter) {
+        if ((iter->position - position).computeSquaredNorm() <= maxDistanceSquared) {
+            return std::make_shared<shapelet::MultiShapeletFunction>(iter->fit);
+        }
+    }
+    return PTR(shapelet::MultiShapeletFunction)();
+}
+
+void PsfFitCache::insert(
+    PTR(afw::detection::Psf const) psf,
+    geom::Point2D const & position,
+    shapelet::MultiShapeletFunction const & fit
+) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_psf.lock() != psf) {
+        _entries.clear();
+        _psf = psf;
+    }
+    _entries.push_back(Entry{position, fit});
+    while (static_cast<int>(_entries.size()) > _maxSize) {
+        _entries.pop_front();
+    }
+}
+
+void PsfFitCache::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _psf.reset();
+}
+
+}}} // namespace lsst::meas::modelfit
@@ -29,7 +29,23 @@ namespace lsst { namespace meas { namespace modelfit {
 
 SamplingObjective::SamplingObjective(PTR(Likelihood) likelihood) :
     _likelihood(likelihood),
-    _modelMatrix(ndarray::allocate(likelihood->getDataDim(), likelihood->getAmplitudeDim()))
+    _modelMatrix(makeModelMatrix())
 {}
 
+Scalar SamplingObjective::evaluate(
+    ndarray::Array<Scalar const,1,1> const & parameters,
+    afw::table::BaseRecord & sample,
+    Workspace & workspace
+) const {
+    return (*this)(parameters, sample);
+}
+
+std::unique_ptr<SamplingObjective::Workspace> SamplingObjective::makeWorkspace() const {
+    return std::unique_ptr<Workspace>(new Workspace(makeModelMatrix()));
+}
+
+ndarray::Array<Pixel,2,-1> SamplingObjective::makeModelMatrix() const {
+    return ndarray::allocate(_likelihood->getDataDim(), _likelihood->getAmplitudeDim());
+}
+
 }}} // namespace lsst::meas::modelfit
@@ -21,6 +21,7 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
 #include <limits>
 
 #include "ndarray/eigen.h"
@@ -37,6 +38,67 @@ namespace lsst { namespace meas { namespace modelfit {
 
 namespace {
 
+// Build a QuinticHermiteTable for a function object with p, d1, and d2 methods on [x0, x1].  We double
+// the number of segments until the error at the quarter-points of every segment, relative to the
+// maximum absolute value of the same quantity, is below the tolerance for all of p, d1, and d2.
+template <typename F>
+std::shared_ptr<detail::QuinticHermiteTable const> makeTable(
+    F const & f, Scalar x0, Scalar x1, Scalar tolerance, Scalar & error
+) {
+    static int const MIN_SEGMENTS = 16;
+    static int const MAX_SEGMENTS = 1 << 16;
+    for (int n = MIN_SEGMENTS; n <= MAX_SEGMENTS; n *= 2) {
+        Scalar h = (x1 - x0)/n;
+        Eigen::VectorXd v(n + 1), d1(n + 1), d2(n + 1);
+        for (int i = 0; i <= n; ++i) {
+            Scalar x = x0 + i*h;
+            v[i] = f.p(x);
+            d1[i] = f.d1(x);
+            d2[i] = f.d2(x);
+        }
+        auto table = std::make_shared<detail::QuinticHermiteTable const>(x0, x1, v, d1, d2);
+        Eigen::Array3d maxAbs(
+            v.lpNorm<Eigen::Infinity>(), d1.lpNorm<Eigen::Infinity>(), d2.lpNorm<Eigen::Infinity>()
+        );
+        Eigen::Array3d maxErr = Eigen::Array3d::Zero();
+        for (int i = 0; i < n; ++i) {
+            for (Scalar t : {0.25, 0.5, 0.75}) {
+                Scalar x = x0 + (i + t)*h;
+                maxErr[0] = std::max(maxErr[0], std::abs(table->p(x) - f.p(x)));
+                maxErr[1] = std::max(maxErr[1], std::abs(table->d1(x) - f.d1(x)));
+                maxErr[2] = std::max(maxErr[2], std::abs(table->d2(x) - f.d2(x)));
+            }
+        }
+        error = (maxErr / maxAbs.max(std::numeric_limits<Scalar>::min())).maxCoeff();
+        if (error < tolerance) {
+            return table;
+        }
+    }
+    throw LSST_EXCEPT(
+        pex::exceptions::InvalidParameterError,
+        (boost::format("Could not tabulate SemiEmpiricalPrior to tolerance %g; best was %g")
+         % tolerance % error).str()
+    );
+}
+
+// Decaying exponential a*exp(-z/s), used as the (optionally tabulated) radial profile of
+// SoftenedExponential.
+class ExponentialProfile {
+public:
+
+    ExponentialProfile(Scalar a, Scalar sigma) : _a(a), _sigma(sigma) {}
+
+    Scalar p(Scalar z) const { return _a*std::exp(-z/_sigma); }
+
+    Scalar d1(Scalar z) const { return -p(z)/_sigma; }
+
+    Scalar d2(Scalar z) const { return p(z)/(_sigma*_sigma); }
+
+private:
+    Scalar _a;
+    Scalar _sigma;
+};
+
 // Exponential distribution in polar coordinates with a softened core:
 // f(x) = A x exp(-sqrt(x^2 + t^2)/s) / s
 // with A chosen to integrate to 1 over R2
@@ -51,23 +113,54 @@ public:
 
     Scalar p(Scalar x) const {
         Scalar z = std::sqrt(x*x+_tau*_tau);
-        return _a*std::exp(-z/_sigma);
+        return _profile(z);
+    }
+
+    Eigen::ArrayXd p(Eigen::ArrayXd const & x) const {
+        return _profile((x.square() + _tau*_tau).sqrt());
     }
 
     Scalar d1(Scalar x) const {
         Scalar z = std::sqrt(x*x+_tau*_tau);
-        return -_a*std::exp(-z/_sigma)*x/(_sigma*z);
+        return -_profile(z)*x/(_sigma*z);
     }
 
     Scalar d2(Scalar x) const {
         Scalar z = std::sqrt(x*x+_tau*_tau);
-        return _a*exp(-z/_sigma)*(x*x*z - _sigma*_tau*_tau)/(_sigma*_sigma*z*z*z);
+        return _profile(z)*(x*x*z - _sigma*_tau*_tau)/(_sigma*_sigma*z*z*z);
+    }
+
+    // Replace exp(-z/sigma) with a table lookup for z within 40 sigma of the core; return the error.
+    Scalar tabulate(Scalar tolerance) {
+        Scalar error = 0.0;
+        _table = makeTable(ExponentialProfile(_a, _sigma), _tau, _tau + 40*_sigma, tolerance, error);
+        return error;
     }
 
 private:
+
+    Scalar _profile(Scalar z) const {
+        if (_table && _table->contains(z)) {
+            return _table->p(z);
+        }
+        return _a*std::exp(-z/_sigma);
+    }
+
+    Eigen::ArrayXd _profile(Eigen::ArrayXd const & z) const {
+        if (!_table) {
+            return _a*(-z/_sigma).exp();
+        }
+        Eigen::Array<bool,Eigen::Dynamic,1> inside = z >= _table->getMin() && z <= _table->getMax();
+        if (inside.all()) {
+            return _table->p(z);
+        }
+        return inside.select(_table->p(z), _a*(-z/_sigma).exp());
+    }
+
     Scalar _sigma;
     Scalar _tau;
     Scalar _a;
+    std::shared_ptr<detail::QuinticHermiteTable const> _table;
 };
 
 // Ellipticity factor in the (separable) prior; this just translates a prior defined
@@ -83,6 +176,10 @@ public:
         return _m.p(std::sqrt(eta1*eta1 + eta2*eta2))/(2*geom::PI);
     }
 
+    Eigen::ArrayXd p(Eigen::ArrayXd const & eta1, Eigen::ArrayXd const & eta2) const {
+        return _m.p((eta1.square() + eta2.square()).sqrt())/(2*geom::PI);
+    }
+
     Eigen::Vector2d d1(Scalar eta1, Scalar eta2) const {
         Scalar eta = std::sqrt(eta1*eta1 + eta2*eta2);
         Eigen::Vector2d r = Eigen::Vector2d::Zero();
@@ -109,6 +206,8 @@ public:
         return r;
     }
 
+    Scalar tabulate(Scalar tolerance) { return _m.tabulate(tolerance); }
+
 private:
     SoftenedExponential _m;
 };
@@ -123,6 +222,13 @@ public:
         return detail::Vandermonde<4>::eval(x).dot(_coeffs);
     }
 
+    // Sum the monomials pairwise, as the scalar overload's dot product does; the ramp's coefficients are
+    // large and cancel, so its values near the break points depend on the order of summation.
+    Eigen::ArrayXd p(Eigen::ArrayXd const & x) const {
+        Eigen::ArrayXd x2 = x.square();
+        return (_coeffs[0] + _coeffs[2]*x2) + (_coeffs[1]*x + _coeffs[3]*x2*x);
+    }
+
     Scalar d1(Scalar x) const {
         return detail::Vandermonde<4>::differentiate1(x).dot(_coeffs);
     }
@@ -149,6 +255,10 @@ public:
         return _v;
     }
 
+    Eigen::ArrayXd p(Eigen::ArrayXd const & x) const {
+        return Eigen::ArrayXd::Constant(x.size(), _v);
+    }
+
     Scalar d1(Scalar x) const {
         return 0.0;
     }
@@ -172,23 +282,51 @@ public:
     explicit StudentsT(Scalar mu, Scalar sigma, Scalar nu) : _mu(mu), _sigma(sigma), _nu(nu) {}
 
     Scalar p(Scalar x) const {
+        if (_table && _table->contains(x)) {
+            return _table->p(x);
+        }
         Scalar z = (x - _mu)/_sigma;
         Scalar a = 1.0 + z*z/_nu;
         return std::pow(a, -0.5*(_nu + 1.0));
     }
 
+    Eigen::ArrayXd p(Eigen::ArrayXd const & x) const {
+        if (!_table) {
+            return _direct(x);
+        }
+        Eigen::Array<bool,Eigen::Dynamic,1> inside = x >= _table->getMin() && x <= _table->getMax();
+        if (inside.all()) {
+            return _table->p(x);
+        }
+        return inside.select(_table->p(x), _direct(x));
+    }
+
     Scalar d1(Scalar x) const {
+        if (_table && _table->contains(x)) {
+            return _table->d1(x);
+        }
         Scalar z = (x - _mu)/_sigma;
         Scalar a = 1.0 + z*z/_nu;
         return -z*((_nu + 1.0)/_nu)*std::pow(a, -0.5*(_nu + 3.0))/_sigma;
     }
 
     Scalar d2(Scalar x) const {
+        if (_table && _table->contains(x)) {
+            return _table->d2(x);
+        }
         Scalar z = (x - _mu)/_sigma;
         Scalar a = 1.0 + z*z/_nu;
         return std::pow(a, -0.5*(_nu + 5.0))*(_nu + 1.0)*(a*(_nu + 2.0) - (_nu + 3.0)) / (_nu*_sigma*_sigma);
     }
 
+    // Replace direct evaluation with table lookups within 20 sigma of the mean (we only ever evaluate
+    // the upper half of the distribution); return the error.
+    Scalar tabulate(Scalar tolerance) {
+        Scalar error = 0.0;
+        _table = makeTable(*this, _mu, _mu + 20*_sigma, tolerance, error);
+        return error;
+    }
+
     Scalar integrate(Scalar x0, Scalar x1) const {
         if (x0 == _mu && x1 == std::numeric_limits<Scalar>::infinity()) {
             return 0.5*std::sqrt(geom::PI*_nu)*boost::math::tgamma_delta_ratio(0.5*_nu, 0.5)*_sigma;
@@ -199,9 +337,15 @@ public:
     }
 
 private:
+
+    Eigen::ArrayXd _direct(Eigen::ArrayXd const & x) const {
+        return (1.0 + ((x - _mu)/_sigma).square()/_nu).pow(-0.5*(_nu + 1.0));
+    }
+
     Scalar _mu;
     Scalar _sigma;
     Scalar _nu;
+    std::shared_ptr<detail::QuinticHermiteTable const> _table;
 };
 
 
@@ -241,6 +385,17 @@ struct LogRadiusDist {
         }
     }
 
+    // Evaluate every piece at every point and select, mirroring the branches in the scalar overload.  The
+    // tail is only used above _break2, so evaluate it there (where it may be tabulated) for all points.
+    Eigen::ArrayXd p(Eigen::ArrayXd const & x) const {
+        Eigen::ArrayXd tailX = (x > _break2).select(x, _break2);
+        Eigen::ArrayXd r = (x > _break1).select(
+            (x < _break2).select(_flat.p(x), _tail.p(tailX)),
+            (x < _break0).select(0.0, _ramp.p(x))
+        );
+        return r/_norm;
+    }
+
     Scalar d1(Scalar x) const {
         if (x > _break1) {
             if (x < _break2) {
@@ -273,6 +428,8 @@ struct LogRadiusDist {
         }
     }
 
+    Scalar tabulate(Scalar tolerance) { return _tail.tabulate(tolerance); }
+
 private:
 
     Cubic _ramp;
@@ -333,10 +490,18 @@ void SemiEmpiricalPriorControl::validate() const {
 
 struct SemiEmpiricalPrior::Impl {
 
-    explicit Impl(SemiEmpiricalPriorControl const & ctrl) : eta(ctrl), lnR(ctrl) {}
+    explicit Impl(SemiEmpiricalPriorControl const & ctrl) : eta(ctrl), lnR(ctrl), tabulationError(0.0) {
+        if (ctrl.tabulationTolerance > 0.0) {
+            tabulationError = std::max(
+                eta.tabulate(ctrl.tabulationTolerance),
+                lnR.tabulate(ctrl.tabulationTolerance)
+            );
+        }
+    }
 
     EtaDist eta;
     LogRadiusDist lnR;
+    Scalar tabulationError;
 };
 
 
@@ -346,6 +511,10 @@ SemiEmpiricalPrior::SemiEmpiricalPrior(Control const & ctrl) {
 }
 
 
+Scalar SemiEmpiricalPrior::getTabulationError() const {
+    return _impl->tabulationError;
+}
+
 Scalar SemiEmpiricalPrior::evaluate(
     ndarray::Array<Scalar const,1,1> const & nonlinear,
     ndarray::Array<Scalar const,1,1> const & amplitudes
@@ -357,6 +526,21 @@ Scalar SemiEmpiricalPrior::evaluate(
     }
 }
 
+void SemiEmpiricalPrior::evaluateBatch(
+    ndarray::Array<Scalar const,2,1> const & nonlinear,
+    ndarray::Array<Scalar const,2,1> const & amplitudes,
+    ndarray::Array<Scalar,1,1> const & output
+) const {
+    _checkBatchShapes(nonlinear, amplitudes, output);
+    // This is a vectorized equivalent of evaluate; each factor is computed for all points at once.
+    auto nl = ndarray::asEigenArray(nonlinear);
+    auto out = ndarray::asEigenArray(output);
+    out = _impl->eta.p(nl.col(0), nl.col(1)) * _impl->lnR.p(nl.col(2));
+    if (amplitudes.getSize<1>() > 0) {
+        out = (ndarray::asEigenArray(amplitudes) < 0.0).rowwise().any().select(0.0, out);
+    }
+}
+
 void SemiEmpiricalPrior::evaluateDerivatives(
     ndarray::Array<Scalar const,1,1> const & nonlinear,
     ndarray::Array<Scalar const,1,1> const & amplitudes,
@@ -402,7 +586,7 @@ void SemiEmpiricalPrior::evaluateDerivatives(
     nonlinearHessian(1,1) = eta2(1,1)*lnR0;
     nonlinearHessian(1,2) = eta1[1]*lnR1;
     nonlinearHessian(2,0) = eta1[0]*lnR1;
-    nonlinearHessian(2,1) = eta1[0]*lnR1;
+    nonlinearHessian(2,1) = eta1[1]*lnR1;
     nonlinearHessian(2,2) = eta0*lnR2;
 }
 
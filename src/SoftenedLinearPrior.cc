@@ -144,6 +144,42 @@ Scalar SoftenedLinearPrior::evaluate(
     }
 }
 
+namespace {
+
+// Evaluate a cubic polynomial with the given coefficients (in increasing order) at all points in x.
+template <typename Derived>
+Eigen::ArrayXd evaluateCubic(Eigen::Matrix<double,4,1,Eigen::DontAlign> const & c,
+                             Eigen::ArrayBase<Derived> const & x) {
+    return c[0] + x*(c[1] + x*(c[2] + x*c[3]));
+}
+
+} // anonymous
+
+void SoftenedLinearPrior::evaluateBatch(
+    ndarray::Array<Scalar const,2,1> const & nonlinear,
+    ndarray::Array<Scalar const,2,1> const & amplitudes,
+    ndarray::Array<Scalar,1,1> const & output
+) const {
+    _checkBatchShapes(nonlinear, amplitudes, output);
+    // This is a vectorized equivalent of _evaluate; we compute the value of every piece at every
+    // point and select the right one, which is much cheaper than branching on each point.
+    auto nl = ndarray::asEigenArray(nonlinear);
+    auto out = ndarray::asEigenArray(output);
+    Eigen::ArrayXd logRadius = nl.col(2);
+    Eigen::ArrayXd ellipticity = (nl.col(0).square() + nl.col(1).square()).sqrt();
+    out = _logRadiusP1 + (logRadius - _ctrl.logRadiusMinInner) * _logRadiusSlope;
+    out = (logRadius < _ctrl.logRadiusMinInner).select(evaluateCubic(_logRadiusPoly1, logRadius), out);
+    out = (logRadius > _ctrl.logRadiusMaxInner).select(evaluateCubic(_logRadiusPoly2, logRadius), out);
+    out *= (ellipticity > _ctrl.ellipticityMaxInner).select(
+        evaluateCubic(_ellipticityPoly, ellipticity), 1.0
+    );
+    out = (logRadius <= _ctrl.logRadiusMinOuter || logRadius >= _ctrl.logRadiusMaxOuter
+           || ellipticity >= _ctrl.ellipticityMaxOuter).select(0.0, out);
+    if (amplitudes.getSize<1>() > 0) {
+        out = (ndarray::asEigenArray(amplitudes) < 0.0).rowwise().any().select(0.0, out);
+    }
+}
+
 void SoftenedLinearPrior::evaluateDerivatives(
     ndarray::Array<Scalar const,1,1> const & nonlinear,
     ndarray::Array<Scalar const,1,1> const & amplitudes,
@@ -32,7 +32,11 @@
 //
 
 #include "boost/math/special_functions/erf.hpp"
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <numeric>
+#include <vector>
 #include "Eigen/Eigenvalues"
 #include "Eigen/LU"
 
@@ -41,6 +45,8 @@
 #include "lsst/pex/exceptions.h"
 #include "lsst/meas/modelfit/integrals.h"
 #include "lsst/meas/modelfit/TruncatedGaussian.h"
+#include "lsst/meas/modelfit/detail/arena.h"
+#include "lsst/meas/modelfit/detail/parallel.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
@@ -49,6 +55,37 @@ namespace {
 static double const THRESHOLD = 1E-15;
 static double const SLN_THRESHOLD = 1E-5;
 
+// Minimum number of samples drawn by each thread when sampling with a CounterRandom.
+static int const SAMPLE_CHUNK_SIZE = 256;
+
+// Maximize a 2-d TruncatedGaussian with H = v s v^T by enumerating the active sets in closed form.
+Eigen::Vector2d maximize2d(Eigen::Vector2d const & mu, Eigen::Vector2d const & s, Eigen::Matrix2d const & v) {
+    if ((mu.array() >= 0.0).all()) {
+        return mu;
+    }
+    Eigen::Matrix2d h = v * s.asDiagonal() * v.adjoint();
+    Eigen::Vector2d best;
+    Scalar bestObjective = std::numeric_limits<Scalar>::infinity();
+    // Try fixing the negative component of mu at zero first, so that when clamping it is optimal the
+    // result is identical to the solution of the reduced system.  The origin is included in each
+    // candidate (when the free component is clamped too), and the unconstrained maximum is infeasible.
+    int const first = (mu[0] < 0.0) ? 0 : 1;
+    for (int n = 0; n < 2; ++n) {
+        int const i = (first + n) % 2;  // component held at zero
+        int const j = 1 - i;            // free component
+        Eigen::Vector2d alpha = Eigen::Vector2d::Zero();
+        alpha[j] = (h(j,j) > 0.0) ? mu[j] + h(j,i)*mu[i]/h(j,j) : mu[j];
+        alpha[j] = std::max(alpha[j], 0.0);
+        Eigen::Vector2d delta = alpha - mu;
+        Scalar objective = delta.dot(h*delta);
+        if (objective < bestObjective) {
+            best = alpha;
+            bestObjective = objective;
+        }
+    }
+    return best;
+}
+
 } // anonymous
 
 // -------- Main TruncatedGaussian class --------------------------------------------------------------------
@@ -56,17 +93,23 @@ static double const SLN_THRESHOLD = 1E-5;
 class TruncatedGaussian::Impl {
 public:
 
+    // mu, s, and v share a single workspace allocation (from the active arena, if there is one).
     explicit Impl(int n) :
         untruncatedFraction(1.0), logPeakAmplitude(1.0), logIntegral(1.0),
-        mu(n), s(n), v(n,n)
+        storage(detail::allocateWorkspace<Scalar>(n*(n + 2))),
+        mu(storage.getData(), n), s(storage.getData() + n, n), v(storage.getData() + 2*n, n, n)
         {}
 
+    Impl(Impl const &) = delete;
+    Impl & operator=(Impl const &) = delete;
+
     Scalar untruncatedFraction;
     Scalar logPeakAmplitude;
     Scalar logIntegral;
-    Vector mu;
-    Vector s;  // H = Sigma^{-1} = V S V^T
-    Matrix v;
+    ndarray::Array<Scalar,1,1> storage;
+    Eigen::Map<Vector> mu;
+    Eigen::Map<Vector> s;  // H = Sigma^{-1} = V S V^T
+    Eigen::Map<Matrix> v;
 };
 
 TruncatedGaussian TruncatedGaussian::fromSeriesParameters(
@@ -254,38 +297,147 @@ int TruncatedGaussian::getDim() const {
 }
 
 Vector TruncatedGaussian::maximize() const {
-    Vector result(_impl->mu);
     int const n = _impl->mu.size();
-    int k = 0;
-    for (int i = 0; i < n; ++i) {
-        if (result[i] < 0.0) {
-            ++k;
+    if (n == 1) {
+        return _impl->mu.cwiseMax(0.0);
+    }
+    if (n == 2) {
+        return maximize2d(_impl->mu.head<2>(), _impl->s.head<2>(), _impl->v.topLeftCorner<2,2>());
+    }
+    Matrix hessian = _impl->v * _impl->s.asDiagonal() * _impl->v.adjoint();
+    Vector gradient = -hessian * _impl->mu;
+    return maximizeSeries(gradient, hessian, _impl->mu);
+}
+
+namespace {
+
+// Solve H_PP x_P = -g_P for the unconstrained ("passive") parameters P, setting the rest of x to zero.
+void solvePassive(
+    Vector const & gradient, Matrix const & hessian, std::vector<int> const & passive,
+    Matrix & hessianPP, Vector & gradientP, Vector & x
+) {
+    int const p = passive.size();
+    hessianPP.resize(p, p);
+    gradientP.resize(p);
+    for (int a = 0; a < p; ++a) {
+        gradientP[a] = gradient[passive[a]];
+        for (int b = 0; b < p; ++b) {
+            hessianPP(a, b) = hessian(passive[a], passive[b]);
         }
     }
-    if (n == k) {
-        result.setZero();
-    } else if (k > 0) {
-        Eigen::VectorXi indices(n);
-        for (int i = 0, j1 = 0, j2 = n - k; i < n; ++i) {
-            if (result[i] < 0.0) {
-                indices[i] = j2;
-                ++j2;
-            } else {
-                indices[i] = j1;
-                ++j1;
+    x.setZero();
+    if (p > 0) {
+        Vector xP = -hessianPP.ldlt().solve(gradientP);
+        for (int a = 0; a < p; ++a) {
+            x[passive[a]] = xP[a];
+        }
+    }
+}
+
+} // anonymous
+
+Vector TruncatedGaussian::maximizeSeries(
+    Vector const & gradient,
+    Matrix const & hessian,
+    Vector const & initial
+) {
+    int const n = gradient.size();
+    if (hessian.rows() != n || hessian.cols() != n) {
+        throw LSST_EXCEPT(
+            pex::exceptions::LengthError,
+            (boost::format("Mismatch between grad size (%d) and hessian dimensions (%d, %d)")
+             % n % hessian.rows() % hessian.cols()).str()
+        );
+    }
+    if (initial.size() != 0 && initial.size() != n) {
+        throw LSST_EXCEPT(
+            pex::exceptions::LengthError,
+            (boost::format("Size of initial point (%d) does not match grad size (%d)")
+             % initial.size() % n).str()
+        );
+    }
+    Scalar const tolerance = 10.0 * n * std::numeric_limits<Scalar>::epsilon()
+        * std::max(gradient.cwiseAbs().maxCoeff(), hessian.cwiseAbs().maxCoeff());
+    int const maxIterations = 5*(n + 1);
+    Vector x = Vector::Zero(n);
+    std::vector<bool> isPassive(n, false);
+    if (initial.size() == n) {
+        for (int i = 0; i < n; ++i) {
+            if (initial[i] > 0.0) {
+                x[i] = initial[i];
+                isPassive[i] = true;
             }
         }
-        Eigen::PermutationMatrix<Eigen::Dynamic> p(indices);
-        // beta, G, nu: permuted versions of alpha, H, mu
-        Matrix pv = p * _impl->v;
-        Matrix G = pv * _impl->s.asDiagonal() * pv.adjoint();
-        Vector nu = p * _impl->mu;
-        Vector beta = Vector::Zero(n);
-        Eigen::FullPivLU<Matrix> solver(G.topLeftCorner(n - k, n - k));
-        beta.head(n - k) = solver.solve(G.topRightCorner(n - k, k) * nu.tail(k)) + nu.head(n - k);
-        result = p.transpose() * beta;
-    }
-    return result;
+    }
+    std::vector<int> passive;
+    passive.reserve(n);
+    Matrix hessianPP;
+    Vector gradientP;
+    Vector z(n);
+    // Parameters that were just freed but would immediately have been driven back to zero; as in
+    // Lawson & Hanson, they are not freed again until x changes, which prevents the active-set loop
+    // from cycling when round-off makes a parameter's derivative slightly negative at the optimum.
+    std::vector<bool> isExcluded(n, false);
+    int justFreed = -1;
+    // The inner loop is run first on the warm-start set (if any), and again after each parameter is
+    // freed; it steps back along the segment from x to the reduced solution z whenever z is infeasible.
+    bool freed = std::find(isPassive.begin(), isPassive.end(), true) != isPassive.end();
+    int iteration = 0;
+    while (true) {
+        while (freed) {
+            passive.clear();
+            for (int i = 0; i < n; ++i) {
+                if (isPassive[i]) passive.push_back(i);
+            }
+            solvePassive(gradient, hessian, passive, hessianPP, gradientP, z);
+            if (justFreed >= 0 && z[justFreed] <= tolerance) {
+                isPassive[justFreed] = false;
+                isExcluded[justFreed] = true;
+                justFreed = -1;
+                break;
+            }
+            justFreed = -1;
+            if (++iteration > maxIterations) {
+                throw LSST_EXCEPT(
+                    pex::exceptions::RuntimeError,
+                    (boost::format("Active-set iteration limit (%d) reached in maximizeSeries")
+                     % maxIterations).str()
+                );
+            }
+            std::fill(isExcluded.begin(), isExcluded.end(), false);
+            Scalar step = 1.0;
+            for (int i : passive) {
+                if (z[i] < 0.0) {
+                    step = std::min(step, x[i] / (x[i] - z[i]));
+                }
+            }
+            if (step >= 1.0) {
+                x = z;
+                break;
+            }
+            x += step * (z - x);
+            for (int i : passive) {
+                if (x[i] <= tolerance) {
+                    x[i] = 0.0;
+                    isPassive[i] = false;
+                }
+            }
+        }
+        // Free the constrained parameter with the most negative derivative, if any.
+        Vector w = -(hessian * x + gradient);
+        int best = -1;
+        for (int i = 0; i < n; ++i) {
+            if (!isPassive[i] && !isExcluded[i] && w[i] > tolerance && (best < 0 || w[i] > w[best])) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            return x;
+        }
+        isPassive[best] = true;
+        justFreed = best;
+        freed = true;
+    }
 }
 
 Scalar TruncatedGaussian::getUntruncatedFraction() const {
@@ -305,7 +457,7 @@ TruncatedGaussian::~TruncatedGaussian() {}
 // -------- LogEvaluator class ------------------------------------------------------------------------------
 
 TruncatedGaussianLogEvaluator::TruncatedGaussianLogEvaluator(TruncatedGaussian const & parent) :
-    _norm(parent._impl->logPeakAmplitude), _mu(parent._impl->mu), _workspace(_mu.size()),
+    _norm(parent._impl->logPeakAmplitude), _mu(parent._impl->mu),
     _rootH(parent._impl->s.array().sqrt().matrix().asDiagonal() * parent._impl->v.adjoint())
 {}
 
@@ -352,72 +504,192 @@ void TruncatedGaussianEvaluator::operator()(
 class TruncatedGaussianSampler::Impl {
 public:
 
-    virtual Scalar apply(afw::math::Random & rng, ndarray::Array<Scalar,1,1> const & alpha) = 0;
+    // Draw a single sample into alpha (dim contiguous elements) and return its weight; nCandidates is
+    // incremented by the number of candidate samples drawn.
+    virtual Scalar apply(afw::math::Random & rng, Scalar * alpha, std::int64_t & nCandidates) const = 0;
+
+    virtual Scalar apply(CounterRandom::Stream & rng, Scalar * alpha, std::int64_t & nCandidates) const = 0;
+
+    // Draw n samples into the rows of alpha (with the given row stride), filling or multiplying the
+    // weights array, and return the number of candidate samples drawn.
+    virtual std::int64_t applyBatch(
+        afw::math::Random & rng, Scalar * alpha, int stride,
+        Scalar * weights, bool multiplyWeights, int n
+    ) const = 0;
 
     virtual ~Impl() {}
 };
 
 namespace {
 
-class SamplerImplDWR1 : public TruncatedGaussianSampler::Impl {
+// Forwards both random number generator types to a single templated applyImpl in the derived class,
+// so each sampling algorithm is only written once.
+template <typename Derived>
+class SamplerImplBase : public TruncatedGaussianSampler::Impl {
 public:
 
-    SamplerImplDWR1(TruncatedGaussian const & parent, Vector const & mu, Matrix const & v, Vector const & s) :
+    virtual Scalar apply(afw::math::Random & rng, Scalar * alpha, std::int64_t & nCandidates) const {
+        return static_cast<Derived const &>(*this).applyImpl(rng, alpha, nCandidates);
+    }
+
+    virtual Scalar apply(CounterRandom::Stream & rng, Scalar * alpha, std::int64_t & nCandidates) const {
+        return static_cast<Derived const &>(*this).applyImpl(rng, alpha, nCandidates);
+    }
+
+    virtual std::int64_t applyBatch(
+        afw::math::Random & rng, Scalar * alpha, int stride,
+        Scalar * weights, bool multiplyWeights, int n
+    ) const {
+        std::int64_t nCandidates = 0;
+        for (int i = 0; i < n; ++i) {
+            Scalar w = static_cast<Derived const &>(*this).applyImpl(rng, alpha + i*stride, nCandidates);
+            if (multiplyWeights) {
+                weights[i] *= w;
+            } else {
+                weights[i] = w;
+            }
+        }
+        return nCandidates;
+    }
+
+};
+
+// Batched rejection sampling shared by the DWR samplers: candidates are drawn (in the same order as
+// one-at-a-time sampling would draw them) for all the samples still needed, transformed together, and
+// the accepted ones compacted into the output, repeating until all samples are filled.  Because each
+// round draws no more candidates than there are samples left, this consumes exactly the same random
+// numbers as the one-at-a-time loop.
+template <typename Transform>
+std::int64_t applyRejectionBatch(
+    afw::math::Random & rng, int dim, Transform const & transform,
+    Scalar * alpha, int stride, Scalar * weights, bool multiplyWeights, int n
+) {
+    // Per-thread scratch space, so drawing is thread-safe without allocating on every call.
+    static thread_local Matrix deviates;
+    static thread_local Matrix candidates;
+    deviates.resize(dim, n);
+    candidates.resize(dim, n);
+    std::int64_t nCandidates = 0;
+    int filled = 0;
+    while (filled < n) {
+        int const batch = n - filled;
+        for (int c = 0; c < batch; ++c) {
+            for (int j = 0; j < dim; ++j) {
+                deviates(j, c) = rng.gaussian();
+            }
+        }
+        transform(deviates.leftCols(batch), candidates.leftCols(batch));
+        nCandidates += batch;
+        for (int c = 0; c < batch; ++c) {
+            if ((candidates.col(c).array() >= 0.0).all()) {
+                Eigen::Map<Vector>(alpha + filled*stride, dim) = candidates.col(c);
+                ++filled;
+            }
+        }
+    }
+    if (!multiplyWeights) {
+        std::fill(weights, weights + n, 1.0);
+    }
+    return nCandidates;
+}
+
+class SamplerImplDWR1 : public SamplerImplBase<SamplerImplDWR1> {
+public:
+
+    SamplerImplDWR1(
+        TruncatedGaussian const & parent, Eigen::Ref<Vector const> const & mu,
+        Eigen::Ref<Matrix const> const & v, Eigen::Ref<Vector const> const & s
+    ) :
         _mu(mu[0]), _rootSigma(std::sqrt(1.0/s[0]) * v(0,0))
         {}
 
-    virtual Scalar apply(afw::math::Random & rng, ndarray::Array<Scalar,1,1> const & alpha) {
+    template <typename Rng>
+    Scalar applyImpl(Rng & rng, Scalar * alpha, std::int64_t & nCandidates) const {
         do {
             alpha[0] = _rootSigma * rng.gaussian() + _mu;
+            ++nCandidates;
         } while (alpha[0] < 0.0);
         return 1.0;
     }
 
+    virtual std::int64_t applyBatch(
+        afw::math::Random & rng, Scalar * alpha, int stride,
+        Scalar * weights, bool multiplyWeights, int n
+    ) const {
+        auto transform = [this](Eigen::Ref<Matrix const> const & deviates, Eigen::Ref<Matrix> candidates) {
+            candidates.array() = _rootSigma * deviates.array() + _mu;
+        };
+        return applyRejectionBatch(rng, 1, transform, alpha, stride, weights, multiplyWeights, n);
+    }
+
 private:
     Scalar _mu;
     Scalar _rootSigma;
 };
 
-class SamplerImplDWR : public TruncatedGaussianSampler::Impl {
+class SamplerImplDWR : public SamplerImplBase<SamplerImplDWR> {
 public:
 
-    SamplerImplDWR(TruncatedGaussian const & parent, Vector const & mu, Matrix const & v, Vector const & s) :
-        _mu(mu), _workspace(mu.size()),
+    SamplerImplDWR(
+        TruncatedGaussian const & parent, Eigen::Ref<Vector const> const & mu,
+        Eigen::Ref<Matrix const> const & v, Eigen::Ref<Vector const> const & s
+    ) :
+        _mu(mu),
         _rootSigma(v * s.array().inverse().sqrt().matrix().asDiagonal() * v.adjoint())
         {}
 
-    virtual Scalar apply(afw::math::Random & rng, ndarray::Array<Scalar,1,1> const & alpha) {
+    template <typename Rng>
+    Scalar applyImpl(Rng & rng, Scalar * alpha, std::int64_t & nCandidates) const {
+        // Per-thread scratch space, so drawing is thread-safe without allocating on every call.
+        static thread_local Vector workspace;
+        workspace.resize(_mu.size());
+        Eigen::Map<Vector> a(alpha, _mu.size());
         do {
-            for (int j = 0; j < _workspace.size(); ++j) {
-                _workspace[j] = rng.gaussian();
+            for (int j = 0; j < workspace.size(); ++j) {
+                workspace[j] = rng.gaussian();
             }
-            ndarray::asEigenMatrix(alpha) = _rootSigma * _workspace + _mu;
-        } while ((ndarray::asEigenArray(alpha) < 0.0).any());
+            a = _rootSigma * workspace + _mu;
+            ++nCandidates;
+        } while ((a.array() < 0.0).any());
         return 1.0;
     }
 
+    virtual std::int64_t applyBatch(
+        afw::math::Random & rng, Scalar * alpha, int stride,
+        Scalar * weights, bool multiplyWeights, int n
+    ) const {
+        auto transform = [this](Eigen::Ref<Matrix const> const & deviates, Eigen::Ref<Matrix> candidates) {
+            candidates.noalias() = _rootSigma * deviates;
+            candidates.colwise() += _mu;
+        };
+        return applyRejectionBatch(rng, _mu.size(), transform, alpha, stride, weights, multiplyWeights, n);
+    }
+
 private:
     Vector _mu;
-    Vector _workspace;
     Matrix _rootSigma;
 };
 
-Scalar draw1d(afw::math::Random & rng, Scalar Ap) {
+template <typename Rng>
+Scalar draw1d(Rng & rng, Scalar Ap) {
     return -boost::math::erfc_inv(2.0*(1.0 - rng.uniform()*Ap)) * M_SQRT2;
 }
 
-class SamplerImplAAW1 : public TruncatedGaussianSampler::Impl {
+class SamplerImplAAW1 : public SamplerImplBase<SamplerImplAAW1> {
 public:
 
     SamplerImplAAW1(
-        TruncatedGaussian const & parent, Vector const & mu, Matrix const & v, Vector const & s
+        TruncatedGaussian const & parent, Eigen::Ref<Vector const> const & mu,
+        Eigen::Ref<Matrix const> const & v, Eigen::Ref<Vector const> const & s
     ) :
         _mu(mu[0]), _rootD(std::sqrt(1.0/s[0])),
         _A(0.5*boost::math::erfc(-_mu/(M_SQRT2*_rootD)))
         {}
 
-    virtual Scalar apply(afw::math::Random & rng, ndarray::Array<Scalar,1,1> const & alpha) {
+    template <typename Rng>
+    Scalar applyImpl(Rng & rng, Scalar * alpha, std::int64_t & nCandidates) const {
         alpha[0] = draw1d(rng, _A) * _rootD + _mu;
+        ++nCandidates;
         return 1.0;
     }
 
@@ -428,13 +700,14 @@ private:
 };
 
 // We inherit from TruncatedGaussianSampler not just because we want to evaluate the function
-// repeatedly, but also because we want to reuse some of its data members (mu, workspace) for
+// repeatedly, but also because we want to reuse some of its data members (mu) for
 // our own purposes, and we can only do that via inheritance rather than containment.
-class SamplerImplAAW : public TruncatedGaussianSampler::Impl, private TruncatedGaussianLogEvaluator {
+class SamplerImplAAW : public SamplerImplBase<SamplerImplAAW>, private TruncatedGaussianLogEvaluator {
 public:
 
     SamplerImplAAW(
-        TruncatedGaussian const & parent, Vector const & mu, Matrix const & v, Vector const & s
+        TruncatedGaussian const & parent, Eigen::Ref<Vector const> const & mu,
+        Eigen::Ref<Matrix const> const & v, Eigen::Ref<Vector const> const & s
     ) :
         TruncatedGaussianLogEvaluator(parent),
         _pNorm(1.0),
@@ -464,18 +737,21 @@ public:
             }
         }
 
-    virtual Scalar apply(afw::math::Random & rng, ndarray::Array<Scalar,1,1> const & alpha) {
-        for (int j = 0; j < _workspace.size(); ++j) {
+    template <typename Rng>
+    Scalar applyImpl(Rng & rng, Scalar * alpha, std::int64_t & nCandidates) const {
+        Eigen::Map<Vector> a(alpha, _mu.size());
+        ++nCandidates;
+        for (int j = 0; j < _mu.size(); ++j) {
             // Start by drawing truncated normal deviates without scaling and shifting by rootD, mu
             // because we'd have to undo that shift and scale to evaluate the proposal.
-            alpha[j] = draw1d(rng, _Ap[j]);
+            a[j] = draw1d(rng, _Ap[j]);
         }
-        Scalar logProposal = 0.5*ndarray::asEigenMatrix(alpha).squaredNorm() + _pNorm;
+        Scalar logProposal = 0.5*a.squaredNorm() + _pNorm;
         // Now that we've evaluated the proposal, we apply the scaling and shifting
-        ndarray::asEigenArray(alpha) *= _rootD.array();
-        ndarray::asEigenMatrix(alpha) += _mu;
+        a.array() *= _rootD.array();
+        a += _mu;
         // Call private Evaluator base class, divide by integral (in log space)
-        Scalar logActual = (*this)(ndarray::asEigenMatrix(alpha)) - _lnAf;
+        Scalar logActual = (*this)(a) - _lnAf;
         return std::exp(logProposal - logActual);
     }
 
@@ -491,7 +767,7 @@ private:
 TruncatedGaussianSampler::TruncatedGaussianSampler(
     TruncatedGaussian const & parent,
     TruncatedGaussian::SampleStrategy strategy
-) {
+) : _dim(parent.getDim()) {
     LOG_LOGGER trace4Logger = LOG_GET("TRACE4.meas.modelfit.TruncatedGaussian");
     if (parent.getDim() == 1) {
         switch (strategy) {
@@ -535,10 +811,18 @@ TruncatedGaussianSampler::TruncatedGaussianSampler(
 Scalar TruncatedGaussianSampler::operator()(
     afw::math::Random & rng, ndarray::Array<Scalar,1,1> const & alpha
 ) const {
-    return _impl->apply(rng, alpha);
+    std::int64_t nCandidates = 0;
+    return _impl->apply(rng, alpha.getData(), nCandidates);
 }
 
-void TruncatedGaussianSampler::operator()(
+Scalar TruncatedGaussianSampler::operator()(
+    CounterRandom::Stream & rng, ndarray::Array<Scalar,1,1> const & alpha
+) const {
+    std::int64_t nCandidates = 0;
+    return _impl->apply(rng, alpha.getData(), nCandidates);
+}
+
+Scalar TruncatedGaussianSampler::operator()(
     afw::math::Random & rng,
     ndarray::Array<Scalar,2,1> const & alpha,
     ndarray::Array<Scalar,1,1> const & weights,
@@ -549,15 +833,74 @@ void TruncatedGaussianSampler::operator()(
         pex::exceptions::LengthError,
         "First dimension of alpha array (%d) does not match size of weights array (%d)"
     );
-    if (multiplyWeights) {
-        for (int i = 0, n = alpha.getSize<0>(); i < n; ++i) {
-            weights[i] *= _impl->apply(rng, alpha[i]);
-        }
-    } else {
-        for (int i = 0, n = alpha.getSize<0>(); i < n; ++i) {
-            weights[i] = _impl->apply(rng, alpha[i]);
-        }
+    LSST_THROW_IF_NE(
+        alpha.getSize<1>(), _dim,
+        pex::exceptions::LengthError,
+        "Second dimension of alpha array (%d) does not match dimension of distribution (%d)"
+    );
+    int const n = alpha.getSize<0>();
+    if (n == 0) {
+        return 0.0;
     }
+    std::int64_t nCandidates = _impl->applyBatch(
+        rng, alpha.getData(), alpha.getStride<0>(), weights.getData(), multiplyWeights, n
+    );
+    return static_cast<Scalar>(nCandidates) / n;
+}
+
+Scalar TruncatedGaussianSampler::operator()(
+    CounterRandom const & rng,
+    ndarray::Array<Scalar,2,1> const & alpha,
+    ndarray::Array<Scalar,1,1> const & weights,
+    bool multiplyWeights,
+    std::uint64_t offset,
+    int nThreads
+) const {
+    LSST_THROW_IF_NE(
+        alpha.getSize<0>(), weights.getSize<0>(),
+        pex::exceptions::LengthError,
+        "First dimension of alpha array (%d) does not match size of weights array (%d)"
+    );
+    LSST_THROW_IF_NE(
+        alpha.getSize<1>(), _dim,
+        pex::exceptions::LengthError,
+        "Second dimension of alpha array (%d) does not match dimension of distribution (%d)"
+    );
+    if (nThreads < 1) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("nThreads must be >= 1; got %d") % nThreads).str()
+        );
+    }
+    int const n = alpha.getSize<0>();
+    if (n == 0) {
+        return 0.0;
+    }
+    // Use raw pointers in the threads; ndarray views are not safe to copy between threads.
+    Impl const * impl = _impl.get();
+    Scalar * const alphaData = alpha.getData();
+    int const alphaStride = alpha.getStride<0>();
+    Scalar * const weightData = weights.getData();
+    std::vector<std::int64_t> nCandidates(nThreads, 0);
+    detail::parallelFor(
+        n, nThreads, SAMPLE_CHUNK_SIZE,
+        [impl, &rng, &nCandidates, alphaData, alphaStride, weightData, multiplyWeights, offset](
+            int chunk, int begin, int end
+        ) {
+            std::int64_t count = 0;
+            for (int i = begin; i < end; ++i) {
+                CounterRandom::Stream stream = rng.getStream(offset + i);
+                Scalar w = impl->apply(stream, alphaData + i*alphaStride, count);
+                if (multiplyWeights) {
+                    weightData[i] *= w;
+                } else {
+                    weightData[i] = w;
+                }
+            }
+            nCandidates[chunk] = count;
+        }
+    );
+    return static_cast<Scalar>(std::accumulate(nCandidates.begin(), nCandidates.end(), std::int64_t(0))) / n;
 }
 
 TruncatedGaussianSampler::~TruncatedGaussianSampler() {} // defined in .cc so it can see Impl's dtor
@@ -28,6 +28,7 @@
 
 #include "lsst/afw/geom/transformFactory.h"
 #include "lsst/meas/modelfit/UnitSystem.h"
+#include "lsst/meas/modelfit/WcsLinearizationCache.h"
 
 namespace lsst {
 namespace meas {
@@ -72,6 +73,49 @@ LocalUnitTransform::LocalUnitTransform(geom::Point2D const& sourcePixel, UnitSys
                source.photoCalib->getInstFluxAtZeroMagnitude()),
           sb(flux / geometric.getLinear().computeDeterminant()) {}
 
+LocalUnitTransform LocalUnitTransform::fromStandard(geom::Point2D const& destinationPixel, double flux,
+                                                    UnitSystem const& destination) {
+    return _fromStandard(
+            destinationPixel, flux, destination,
+            WcsLinearizationCache::computePixelToTangent(*destination.wcs, destinationPixel));
+}
+
+LocalUnitTransform LocalUnitTransform::fromStandard(geom::Point2D const& destinationPixel, double flux,
+                                                    UnitSystem const& destination,
+                                                    WcsLinearizationCache const& cache) {
+    return _fromStandard(destinationPixel, flux, destination, cache.getPixelToTangent(destinationPixel));
+}
+
+LocalUnitTransform LocalUnitTransform::_fromStandard(geom::Point2D const& destinationPixel, double flux,
+                                                     UnitSystem const& destination,
+                                                     geom::LinearTransform const& destinationToTangent) {
+    // At its tangent point, the standard TAN system (1 arcsecond pixels, no rotation, east to the left)
+    // maps pixels to (east, north) offsets on the tangent plane of (-x, y) arcseconds.
+    double scale = (1.0 * lsst::geom::arcseconds).asRadians();
+    geom::LinearTransform standardToTangent(geom::LinearTransform::makeScaling(-scale, scale));
+    // The standard system's photometric zero point is chosen such that the given flux is unit flux;
+    // we compute it the same way the full UnitSystem constructor does to keep the results identical.
+    std::shared_ptr<afw::image::PhotoCalib const> photoCalib = destination.photoCalib;
+    Scalar mag = photoCalib->instFluxToMagnitude(flux);
+    return LocalUnitTransform(
+            geom::AffineTransform(destinationToTangent.inverted() * standardToTangent,
+                                  geom::Extent2D(destinationPixel)),
+            photoCalib->getInstFluxAtZeroMagnitude() / std::pow(10.0, mag / 2.5));
+}
+
+LocalUnitTransform LocalUnitTransform::fromJacobians(geom::Point2D const& sourcePixel,
+                                                     geom::LinearTransform const& sourceToTangent,
+                                                     UnitSystem const& source,
+                                                     geom::Point2D const& destinationPixel,
+                                                     geom::LinearTransform const& destinationToTangent,
+                                                     UnitSystem const& destination) {
+    geom::LinearTransform linear = destinationToTangent.inverted() * sourceToTangent;
+    return LocalUnitTransform(
+            geom::AffineTransform(linear, destinationPixel - linear(sourcePixel)),
+            destination.photoCalib->getInstFluxAtZeroMagnitude() /
+                    source.photoCalib->getInstFluxAtZeroMagnitude());
+}
+
 }  // namespace modelfit
 }  // namespace meas
 }  // namespace lsst
@@ -31,6 +31,7 @@
 #include "lsst/afw/image/PhotoCalib.h"
 #include "lsst/shapelet/MatrixBuilder.h"
 #include "lsst/meas/modelfit/UnitTransformedLikelihood.h"
+#include "lsst/meas/modelfit/detail/arena.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
@@ -64,8 +65,8 @@ BuilderVector makeMatrixBuilders(
     FactoryVector factories;
     builders.reserve(basisVector.size());
     factories.reserve(basisVector.size());
-    ndarray::Array<Pixel,1,1> x = ndarray::allocate(footprint.getArea());
-    ndarray::Array<Pixel,1,1> y = ndarray::allocate(footprint.getArea());
+    ndarray::Array<Pixel,1,1> x = detail::allocateWorkspace<Pixel>(footprint.getArea());
+    ndarray::Array<Pixel,1,1> y = detail::allocateWorkspace<Pixel>(footprint.getArea());
     int n = 0;
     for (
         auto i = footprint.getSpans()->begin();
@@ -135,11 +136,13 @@ void setupArrays(
 EpochFootprint::EpochFootprint(
     afw::detection::Footprint const &footprint_,
     afw::image::Exposure<Pixel> const &exposure_,
-    shapelet::MultiShapeletFunction const & psf_
+    shapelet::MultiShapeletFunction const & psf_,
+    PTR(WcsLinearizationCache const) wcsCache_
 ) :
     footprint(footprint_),
     exposure(afw::image::Exposure<Pixel>(exposure_, false)),
-    psf(psf_)
+    psf(psf_),
+    wcsCache(wcsCache_)
 {}
 
 class UnitTransformedLikelihood::Impl {
@@ -173,14 +176,16 @@ UnitTransformedLikelihood::UnitTransformedLikelihood(
 ) : Likelihood(model, fixed), _impl(new Impl()) {
     int totPixels = std::accumulate(epochFootprintList.begin(), epochFootprintList.end(),
                                     0, componentPixelSum);
-    _data = ndarray::allocate(totPixels);
-    _variance = ndarray::allocate(totPixels);
-    _weights = ndarray::allocate(totPixels);
-    _unweightedData = ndarray::allocate(totPixels);
+    _data = detail::allocateWorkspace<Pixel>(totPixels);
+    _variance = detail::allocateWorkspace<Pixel>(totPixels);
+    _weights = detail::allocateWorkspace<Pixel>(totPixels);
+    _unweightedData = detail::allocateWorkspace<Pixel>(totPixels);
     _impl->epochs.reserve(epochFootprintList.size());
     _impl->ellipses = model->makeEllipseVector();
     int dataOffset = 0;
     geom::Point2D fitPixel = fitSys.wcs->skyToPixel(position);
+    geom::LinearTransform fitToTangent;  // only computed if some epoch has a linearization cache
+    bool haveFitToTangent = false;
     for (
         std::vector<PTR(EpochFootprint)>::const_iterator imPtrIter = epochFootprintList.begin();
         imPtrIter != epochFootprintList.end();
@@ -188,9 +193,26 @@ UnitTransformedLikelihood::UnitTransformedLikelihood(
     ) {
         int nPix = (**imPtrIter).footprint.getArea();
         int dataEnd = dataOffset + nPix;
+        LocalUnitTransform transform;
+        if ((**imPtrIter).wcsCache) {
+            // Linearize the fit system once, and look up the linearization of the exposure's Wcs
+            // rather than building and linearizing a Wcs pair transform for each epoch.
+            if (!haveFitToTangent) {
+                fitToTangent = WcsLinearizationCache::computePixelToTangent(*fitSys.wcs, fitPixel);
+                haveFitToTangent = true;
+            }
+            UnitSystem epochSys((**imPtrIter).exposure);
+            geom::Point2D epochPixel = epochSys.wcs->skyToPixel(position);
+            transform = LocalUnitTransform::fromJacobians(
+                fitPixel, fitToTangent, fitSys,
+                epochPixel, (**imPtrIter).wcsCache->getPixelToTangent(epochPixel), epochSys
+            );
+        } else {
+            transform = LocalUnitTransform(fitPixel, fitSys, (**imPtrIter).exposure);
+        }
         _impl->epochs.push_back(
             Impl::Epoch(
-                nPix, LocalUnitTransform(fitPixel, fitSys, (**imPtrIter).exposure),
+                nPix, transform,
                 makeMatrixBuilders(model->getBasisVector(), (**imPtrIter).psf, (**imPtrIter).footprint)
             )
         );
@@ -216,17 +238,30 @@ UnitTransformedLikelihood::UnitTransformedLikelihood(
     afw::detection::Footprint const & footprint,
     shapelet::MultiShapeletFunction const & psf,
     UnitTransformedLikelihoodControl const & ctrl
+) : UnitTransformedLikelihood(
+        model, fixed, LocalUnitTransform(fitSys.wcs->skyToPixel(position), fitSys, exposure),
+        exposure, footprint, psf, ctrl
+    )
+{}
+
+UnitTransformedLikelihood::UnitTransformedLikelihood(
+    PTR(Model) model,
+    ndarray::Array<Scalar const,1,1> const & fixed,
+    LocalUnitTransform const & fitSysToMeasSys,
+    afw::image::Exposure<Pixel> const & exposure,
+    afw::detection::Footprint const & footprint,
+    shapelet::MultiShapeletFunction const & psf,
+    UnitTransformedLikelihoodControl const & ctrl
 ) : Likelihood(model, fixed), _impl(new Impl()) {
     int totPixels = footprint.getArea();
-    _data = ndarray::allocate(totPixels);
-    _variance = ndarray::allocate(totPixels);
-    _weights = ndarray::allocate(totPixels);
-    _unweightedData = ndarray::allocate(totPixels);
+    _data = detail::allocateWorkspace<Pixel>(totPixels);
+    _variance = detail::allocateWorkspace<Pixel>(totPixels);
+    _weights = detail::allocateWorkspace<Pixel>(totPixels);
+    _unweightedData = detail::allocateWorkspace<Pixel>(totPixels);
     _impl->ellipses = model->makeEllipseVector();
-    geom::Point2D fitPixel = fitSys.wcs->skyToPixel(position);
     _impl->epochs.push_back(
         Impl::Epoch(
-            totPixels, LocalUnitTransform(fitPixel, fitSys, exposure),
+            totPixels, fitSysToMeasSys,
             makeMatrixBuilders(model->getBasisVector(), psf, footprint)
         )
     );
@@ -0,0 +1,248 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <mutex>
+
+#include "boost/format.hpp"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/meas/modelfit/WcsLinearizationCache.h"
+
+namespace lsst { namespace meas { namespace modelfit {
+
+namespace {
+
+// Largest grid (in each dimension) we'll build before giving up and computing Jacobians exactly.
+int const MAX_GRID_SIZE = 65;
+
+// Number of caches retained by WcsLinearizationCache::get.
+std::size_t const MAX_SHARED_CACHES = 8;
+
+// Factor by which the second derivatives of the Jacobian estimated from second differences on the grid
+// are inflated before being used to bound the interpolation error, to allow for their variation
+// within a cell.
+Scalar const DERIVATIVE_SAFETY_FACTOR = 2.0;
+
+Scalar computeRelativeError(Eigen::Matrix2d const & approx, Eigen::Matrix2d const & exact) {
+    return (approx - exact).cwiseAbs().maxCoeff() / exact.cwiseAbs().maxCoeff();
+}
+
+} // anonymous
+
+WcsLinearizationCache::WcsLinearizationCache(
+    std::shared_ptr<afw::geom::SkyWcs const> wcs,
+    geom::Box2I const & bbox,
+    Scalar tolerance,
+    int initialSpacing
+) : _wcs(wcs), _bbox(bbox), _region(bbox), _tolerance(tolerance), _nx(0), _ny(0), _dx(0.0), _dy(0.0) {
+    if (!_wcs) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            "WcsLinearizationCache requires a Wcs"
+        );
+    }
+    if (!(tolerance > 0.0)) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("WcsLinearizationCache tolerance must be positive (got %g)") % tolerance).str()
+        );
+    }
+    if (initialSpacing < 1) {
+        throw LSST_EXCEPT(
+            pex::exceptions::InvalidParameterError,
+            (boost::format("WcsLinearizationCache initialSpacing must be positive (got %d)")
+             % initialSpacing).str()
+        );
+    }
+    if (_bbox.isEmpty()) {
+        return;
+    }
+    for (Scalar spacing = initialSpacing; ; spacing *= 0.5) {
+        // At least three points in each dimension, so every cell has second differences to use.
+        int nx = std::max(3, int(std::ceil(_region.getWidth() / spacing)) + 1);
+        int ny = std::max(3, int(std::ceil(_region.getHeight() / spacing)) + 1);
+        if (nx > MAX_GRID_SIZE || ny > MAX_GRID_SIZE) {
+            // Can't meet the tolerance with a grid; fall back to exact Jacobians.
+            _values.clear();
+            _nx = _ny = 0;
+            return;
+        }
+        _fillGrid(nx, ny);
+        if (_checkGrid()) {
+            return;
+        }
+    }
+}
+
+bool WcsLinearizationCache::_checkGrid() const {
+    // Second differences of each Jacobian element at grid points, scaled to the error they imply:
+    // (dx^2/8)|J_xx| = |J(i+1,j) - 2J(i,j) + J(i-1,j)|/8, and similarly for y (zero where undefined).
+    std::vector<Scalar> errX(_values.size(), 0.0);
+    std::vector<Scalar> errY(_values.size(), 0.0);
+    for (int j = 0; j < _ny; ++j) {
+        for (int i = 0; i < _nx; ++i) {
+            int const p = 4*(j*_nx + i);
+            for (int k = 0; k < 4; ++k) {
+                if (i > 0 && i < _nx - 1) {
+                    errX[p + k] = std::abs(_values[p + 4 + k] - 2.0*_values[p + k] + _values[p - 4 + k]) / 8;
+                }
+                if (j > 0 && j < _ny - 1) {
+                    errY[p + k] = std::abs(_values[p + 4*_nx + k] - 2.0*_values[p + k]
+                                           + _values[p - 4*_nx + k]) / 8;
+                }
+            }
+        }
+    }
+    for (int j = 0; j < _ny - 1; ++j) {
+        for (int i = 0; i < _nx - 1; ++i) {
+            // The error of bilinear interpolation within a cell is bounded by (dx^2/8) max|J_xx| +
+            // (dy^2/8) max|J_yy| over the cell; we estimate these maxima from the largest second
+            // differences at the cell's corners.
+            int const corners[4] = {
+                4*(j*_nx + i), 4*(j*_nx + i + 1), 4*((j + 1)*_nx + i), 4*((j + 1)*_nx + i + 1)
+            };
+            Scalar bound = 0.0;
+            Scalar scale = std::numeric_limits<Scalar>::infinity();
+            for (int c : corners) {
+                Scalar cornerScale = 0.0;
+                for (int k = 0; k < 4; ++k) {
+                    cornerScale = std::max(cornerScale, std::abs(_values[c + k]));
+                }
+                scale = std::min(scale, cornerScale);
+            }
+            for (int k = 0; k < 4; ++k) {
+                Scalar maxX = 0.0;
+                Scalar maxY = 0.0;
+                for (int c : corners) {
+                    maxX = std::max(maxX, errX[c + k]);
+                    maxY = std::max(maxY, errY[c + k]);
+                }
+                bound = std::max(bound, DERIVATIVE_SAFETY_FACTOR*(maxX + maxY));
+            }
+            if (!(bound <= _tolerance*scale)) {
+                return false;
+            }
+            // Also check the exact error where it is usually largest, to catch Wcss whose second
+            // derivatives vary too much within a cell for the differences above to be representative.
+            geom::Point2D center(_region.getMinX() + (i + 0.5)*_dx, _region.getMinY() + (j + 0.5)*_dy);
+            Eigen::Matrix2d exact = computePixelToTangent(*_wcs, center).getMatrix();
+            if (!(computeRelativeError(_interpolate(i + 0.5, j + 0.5), exact) <= _tolerance)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<WcsLinearizationCache const> WcsLinearizationCache::get(
+    std::shared_ptr<afw::geom::SkyWcs const> const & wcs,
+    geom::Box2I const & bbox,
+    Scalar tolerance
+) {
+    static std::mutex mutex;
+    static std::deque<std::shared_ptr<WcsLinearizationCache const>> caches;  // most recent last
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto iter = caches.begin(); iter != caches.end(); ++iter) {
+            if ((**iter).getWcs() == wcs && (**iter).getBBox() == bbox
+                && (**iter).getTolerance() == tolerance) {
+                std::shared_ptr<WcsLinearizationCache const> result = *iter;
+                caches.erase(iter);
+                caches.push_back(result);
+                return result;
+            }
+        }
+    }
+    // Build the new cache without holding the lock; if another thread builds the same one at the same
+    // time we'll just end up with a redundant (but equivalent) entry.
+    auto result = std::make_shared<WcsLinearizationCache const>(wcs, bbox, tolerance);
+    std::lock_guard<std::mutex> lock(mutex);
+    caches.push_back(result);
+    while (caches.size() > MAX_SHARED_CACHES) {
+        caches.pop_front();
+    }
+    return result;
+}
+
+geom::LinearTransform WcsLinearizationCache::computePixelToTangent(
+    afw::geom::SkyWcs const & wcs,
+    geom::Point2D const & pixel
+) {
+    geom::AffineTransform pixelToSky = wcs.linearizePixelToSky(pixel, lsst::geom::radians);
+    Scalar dec = pixelToSky(pixel).getY();
+    // On the tangent plane, d(east) = cos(dec) d(ra) and d(north) = d(dec).
+    Eigen::Matrix2d matrix = pixelToSky.getLinear().getMatrix();
+    matrix.row(0) *= std::cos(dec);
+    return geom::LinearTransform(matrix);
+}
+
+geom::LinearTransform WcsLinearizationCache::getPixelToTangent(geom::Point2D const & pixel) const {
+    if (!isInterpolated() || !_region.contains(pixel)) {
+        return computePixelToTangent(*_wcs, pixel);
+    }
+    return geom::LinearTransform(
+        _interpolate((pixel.getX() - _region.getMinX()) / _dx, (pixel.getY() - _region.getMinY()) / _dy)
+    );
+}
+
+void WcsLinearizationCache::_fillGrid(int nx, int ny) {
+    _nx = nx;
+    _ny = ny;
+    _dx = _region.getWidth() / (nx - 1);
+    _dy = _region.getHeight() / (ny - 1);
+    _values.resize(4*nx*ny);
+    auto iter = _values.begin();
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            geom::Point2D point(_region.getMinX() + i*_dx, _region.getMinY() + j*_dy);
+            Eigen::Matrix2d matrix = computePixelToTangent(*_wcs, point).getMatrix();
+            *(iter++) = matrix(0, 0);
+            *(iter++) = matrix(0, 1);
+            *(iter++) = matrix(1, 0);
+            *(iter++) = matrix(1, 1);
+        }
+    }
+}
+
+Eigen::Matrix2d WcsLinearizationCache::_interpolate(Scalar fx, Scalar fy) const {
+    int i = std::min(std::max(int(fx), 0), _nx - 2);
+    int j = std::min(std::max(int(fy), 0), _ny - 2);
+    Scalar tx = fx - i;
+    Scalar ty = fy - j;
+    Scalar const * p00 = &_values[4*(j*_nx + i)];
+    Scalar const * p10 = p00 + 4;
+    Scalar const * p01 = p00 + 4*_nx;
+    Scalar const * p11 = p01 + 4;
+    Eigen::Matrix2d result;
+    for (int k = 0; k < 4; ++k) {
+        result(k / 2, k % 2) =
+            (1.0 - ty)*((1.0 - tx)*p00[k] + tx*p10[k]) + ty*((1.0 - tx)*p01[k] + tx*p11[k]);
+    }
+    return result;
+}
+
+}}} // namespace lsst::meas::modelfit
@@ -0,0 +1,122 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+#include "lsst/meas/modelfit/detail/arena.h"
+
+namespace lsst { namespace meas { namespace modelfit { namespace detail {
+
+namespace {
+
+// Alignment of all allocations; a cache line, which also satisfies any vectorized Eigen access.
+std::size_t const ALIGNMENT = 64;
+
+std::shared_ptr<char> makeBlock(std::size_t size) {
+    return std::shared_ptr<char>(new char[size], std::default_delete<char[]>());
+}
+
+struct ThreadArena {
+    Arena arena;
+    int depth = 0;
+};
+
+ThreadArena & getThreadArena() {
+    static thread_local ThreadArena instance;
+    return instance;
+}
+
+} // anonymous
+
+std::size_t const Arena::DEFAULT_BLOCK_SIZE;
+std::size_t const Arena::MAX_RETAINED_BLOCK_SIZE;
+
+Arena::Arena(std::size_t blockSize) :
+    _blockSize(blockSize), _allocated(0), _offset(0), _capacity(0), _spareSize(0)
+{}
+
+void * Arena::allocate(std::size_t bytes, std::shared_ptr<char> & owner) {
+    if (_blocks.empty()) {
+        _addBlock(bytes + ALIGNMENT);
+    }
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(_blocks.back().get());
+    std::size_t begin = ((base + _offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1)) - base;
+    if (begin + bytes > _capacity) {
+        _addBlock(bytes + ALIGNMENT);
+        base = reinterpret_cast<std::uintptr_t>(_blocks.back().get());
+        begin = ((base + ALIGNMENT - 1) & ~(ALIGNMENT - 1)) - base;
+    }
+    _allocated += begin + bytes - _offset;
+    _offset = begin + bytes;
+    owner = _blocks.back();
+    return _blocks.back().get() + begin;
+}
+
+void Arena::reset() {
+    if (_blocks.size() > 1) {
+        // Everything from this generation didn't fit in one block; make the next block big enough.
+        _blockSize = std::max(_blockSize, std::min(_allocated, MAX_RETAINED_BLOCK_SIZE));
+    }
+    // Keep the current block for reuse only if no array still refers to it.
+    if (!_blocks.empty() && _blocks.back().use_count() == 1 && _capacity <= MAX_RETAINED_BLOCK_SIZE
+        && _capacity >= _blockSize) {
+        _spare = std::move(_blocks.back());
+        _spareSize = _capacity;
+    }
+    _blocks.clear();
+    _allocated = 0;
+    _offset = 0;
+    _capacity = 0;
+}
+
+void Arena::_addBlock(std::size_t minSize) {
+    _allocated += _capacity - _offset;
+    if (_spare && _spareSize >= minSize) {
+        _blocks.push_back(std::move(_spare));
+        _capacity = _spareSize;
+        _spareSize = 0;
+    } else {
+        _capacity = std::max(minSize, _blockSize);
+        _blocks.push_back(makeBlock(_capacity));
+    }
+    _offset = 0;
+}
+
+ArenaScope::ArenaScope() {
+    ++getThreadArena().depth;
+}
+
+ArenaScope::~ArenaScope() {
+    ThreadArena & thread = getThreadArena();
+    if (--thread.depth == 0) {
+        thread.arena.reset();
+    }
+}
+
+Arena * ArenaScope::getActive() {
+    ThreadArena & thread = getThreadArena();
+    return thread.depth > 0 ? &thread.arena : nullptr;
+}
+
+}}}} // namespace lsst::meas::modelfit::detail
@@ -21,6 +21,9 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
+#include <cassert>
+
 #include "Eigen/LU"
 
 #include "lsst/meas/modelfit/detail/polynomials.h"
@@ -94,4 +97,70 @@ Eigen::Vector4d solveRampPoly(double v0, double v1, double x0, double x1, double
 
 template class Vandermonde<4>;
 
+QuinticHermiteTable::QuinticHermiteTable(
+    double x0, double x1,
+    Eigen::VectorXd const & v, Eigen::VectorXd const & d1, Eigen::VectorXd const & d2
+) : _x0(x0), _x1(x1), _h((x1 - x0)/(v.size() - 1)), _coeffs(v.size() - 1, 6)
+{
+    assert(v.size() >= 2);
+    assert(d1.size() == v.size() && d2.size() == v.size());
+    // Monomial coefficients of the quintic Hermite basis functions on [0, 1]; rows correspond to
+    // p(0), p'(0), p''(0), p''(1), p'(1), p(1).
+    Eigen::Matrix<double,6,6> basis;
+    basis <<
+        1.0, 0.0, 0.0, -10.0,  15.0, -6.0,
+        0.0, 1.0, 0.0,  -6.0,   8.0, -3.0,
+        0.0, 0.0, 0.5,  -1.5,   1.5, -0.5,
+        0.0, 0.0, 0.0,   0.5,  -1.0,  0.5,
+        0.0, 0.0, 0.0,  -4.0,   7.0, -3.0,
+        0.0, 0.0, 0.0,  10.0, -15.0,  6.0;
+    double const h2 = _h*_h;
+    Eigen::Matrix<double,1,6> data;
+    for (int i = 0; i < _coeffs.rows(); ++i) {
+        data << v[i], _h*d1[i], h2*d2[i], h2*d2[i+1], _h*d1[i+1], v[i+1];
+        _coeffs.row(i) = data * basis;
+    }
+}
+
+int QuinticHermiteTable::_findSegment(double x, double & t) const {
+    double u = (x - _x0)/_h;
+    int i = std::min(static_cast<int>(u), static_cast<int>(_coeffs.rows()) - 1);
+    t = u - i;
+    return i;
+}
+
+double QuinticHermiteTable::p(double x) const {
+    double t;
+    auto c = _coeffs.row(_findSegment(x, t));
+    return c[0] + t*(c[1] + t*(c[2] + t*(c[3] + t*(c[4] + t*c[5]))));
+}
+
+Eigen::ArrayXd QuinticHermiteTable::p(Eigen::ArrayXd const & x) const {
+    double const uMax = _coeffs.rows();
+    Eigen::ArrayXd u = (x - _x0)/_h;
+    // Clamp to the table (sending NaNs to its start) so the segment indices below are always valid.
+    u = (u >= 0.0).select(u, 0.0);
+    u = (u <= uMax).select(u, uMax);
+    Eigen::ArrayXi i = u.cast<int>().min(static_cast<int>(_coeffs.rows()) - 1);
+    Eigen::ArrayXd t = u - i.cast<double>();
+    // Gather each segment's coefficients so the Horner loop below runs on whole arrays.
+    Eigen::Array<double,Eigen::Dynamic,6> c(x.size(), 6);
+    for (int j = 0; j < x.size(); ++j) {
+        c.row(j) = _coeffs.row(i[j]);
+    }
+    return c.col(0) + t*(c.col(1) + t*(c.col(2) + t*(c.col(3) + t*(c.col(4) + t*c.col(5)))));
+}
+
+double QuinticHermiteTable::d1(double x) const {
+    double t;
+    auto c = _coeffs.row(_findSegment(x, t));
+    return (c[1] + t*(2.0*c[2] + t*(3.0*c[3] + t*(4.0*c[4] + t*5.0*c[5]))))/_h;
+}
+
+double QuinticHermiteTable::d2(double x) const {
+    double t;
+    auto c = _coeffs.row(_findSegment(x, t));
+    return (2.0*c[2] + t*(6.0*c[3] + t*(12.0*c[4] + t*20.0*c[5])))/(_h*_h);
+}
+
 }}}} // namespace lsst::meas::modelfit::detail
@@ -21,9 +21,10 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
-#include "boost/math/special_functions/erf.hpp"
+#include <cmath>
+#include <limits>
+#include <vector>
 
-#include "lsst/log/Log.h"
 #include "lsst/pex/exceptions.h"
 #include "lsst/meas/modelfit/integrals.h"
 
@@ -32,121 +33,258 @@ namespace lsst { namespace meas { namespace modelfit { namespace detail {
 // translation of matlab 'bvn.m' routines by Alan Genz:
 // http://www.math.wsu.edu/faculty/genz/homepage
 
-double phid(double z) {
-    return 0.5*boost::math::erfc(-z / M_SQRT2);
-}
+namespace {
 
-double bvnu(double h, double k, double rho) {
-    LOG_LOGGER trace4Logger = LOG_GET("TRACE4.meas.modelfit.integrals");
-    LOGL_DEBUG(trace4Logger, "Starting bvnu: h=%g, k=%g, rho=%g", h, k, rho);
-    if (h == std::numeric_limits<double>::infinity() || h == std::numeric_limits<double>::infinity()) {
-        return 0.0;
+// Gauss-Legendre quadrature points and weights for the three |rho| regimes, already reflected about
+// x=1 (i.e. w = [w0, w0], x = [1 - x0, 1 + x0] in Genz's notation) so they can be used directly.
+struct GaussLegendre6 {
+    static constexpr int SIZE = 6;
+    static constexpr double w[SIZE] = {
+        0.1713244923791705, 0.3607615730481384, 0.4679139345726904,
+        0.1713244923791705, 0.3607615730481384, 0.4679139345726904
+    };
+    static constexpr double x[SIZE] = {
+        1.0 - 0.9324695142031522, 1.0 - 0.6612093864662647, 1.0 - 0.2386191860831970,
+        1.0 + 0.9324695142031522, 1.0 + 0.6612093864662647, 1.0 + 0.2386191860831970
+    };
+};
+
+struct GaussLegendre12 {
+    static constexpr int SIZE = 12;
+    static constexpr double w[SIZE] = {
+        0.04717533638651177, 0.1069393259953183, 0.1600783285433464,
+        0.2031674267230659, 0.2334925365383547, 0.2491470458134029,
+        0.04717533638651177, 0.1069393259953183, 0.1600783285433464,
+        0.2031674267230659, 0.2334925365383547, 0.2491470458134029
+    };
+    static constexpr double x[SIZE] = {
+        1.0 - 0.9815606342467191, 1.0 - 0.9041172563704750, 1.0 - 0.7699026741943050,
+        1.0 - 0.5873179542866171, 1.0 - 0.3678314989981802, 1.0 - 0.1252334085114692,
+        1.0 + 0.9815606342467191, 1.0 + 0.9041172563704750, 1.0 + 0.7699026741943050,
+        1.0 + 0.5873179542866171, 1.0 + 0.3678314989981802, 1.0 + 0.1252334085114692
+    };
+};
+
+struct GaussLegendre20 {
+    static constexpr int SIZE = 20;
+    static constexpr double w[SIZE] = {
+        .01761400713915212, 0.04060142980038694, 0.06267204833410906,
+        .08327674157670475, 0.1019301198172404, 0.1181945319615184,
+        0.1316886384491766, 0.1420961093183821, 0.1491729864726037,
+        0.1527533871307259,
+        .01761400713915212, 0.04060142980038694, 0.06267204833410906,
+        .08327674157670475, 0.1019301198172404, 0.1181945319615184,
+        0.1316886384491766, 0.1420961093183821, 0.1491729864726037,
+        0.1527533871307259
+    };
+    static constexpr double x[SIZE] = {
+        1.0 - 0.9931285991850949, 1.0 - 0.9639719272779138, 1.0 - 0.9122344282513259,
+        1.0 - 0.8391169718222188, 1.0 - 0.7463319064601508, 1.0 - 0.6360536807265150,
+        1.0 - 0.5108670019508271, 1.0 - 0.3737060887154196, 1.0 - 0.2277858511416451,
+        1.0 - 0.07652652113349733,
+        1.0 + 0.9931285991850949, 1.0 + 0.9639719272779138, 1.0 + 0.9122344282513259,
+        1.0 + 0.8391169718222188, 1.0 + 0.7463319064601508, 1.0 + 0.6360536807265150,
+        1.0 + 0.5108670019508271, 1.0 + 0.3737060887154196, 1.0 + 0.2277858511416451,
+        1.0 + 0.07652652113349733
+    };
+};
+
+constexpr double GaussLegendre6::w[];
+constexpr double GaussLegendre6::x[];
+constexpr double GaussLegendre12::w[];
+constexpr double GaussLegendre12::x[];
+constexpr double GaussLegendre20::w[];
+constexpr double GaussLegendre20::x[];
+
+// Special cases that don't need quadrature; returns true (and sets result) if (h, k, rho) is one.
+bool bvnuSpecialCase(double h, double k, double rho, double & result) {
+    if (h == std::numeric_limits<double>::infinity() || k == std::numeric_limits<double>::infinity()) {
+        result = 0.0;
     } else if (h == -std::numeric_limits<double>::infinity()) {
         if (k == -std::numeric_limits<double>::infinity()) {
-            return 1.0;
+            result = 1.0;
         } else {
-            return phid(-k);
+            result = phid(-k);
         }
     } else if (k == -std::numeric_limits<double>::infinity()) {
-        return phid(-h);
+        result = phid(-h);
     } else if (rho == 0.0) {
-        return phid(-h) * phid(-k);
-    }
-    Eigen::ArrayXd w0;
-    Eigen::ArrayXd x0;
-    Eigen::ArrayXd w;
-    Eigen::ArrayXd x;
-    // setup Gauss-Legendre quadrature points and weights
-    if (std::abs(rho) < 0.3) {
-        w0.resize(3);
-        x0.resize(3);
-        w.resize(6);
-        x.resize(6);
-        w0 << 0.1713244923791705, 0.3607615730481384, 0.4679139345726904;
-        x0 << 0.9324695142031522, 0.6612093864662647, 0.2386191860831970;
-    } else if (std::abs(rho) < 0.75) {
-        w0.resize(6);
-        x0.resize(6);
-        w.resize(12);
-        x.resize(12);
-        w0 << 0.04717533638651177, 0.1069393259953183, 0.1600783285433464,
-            0.2031674267230659, 0.2334925365383547, 0.2491470458134029;
-        x0 << 0.9815606342467191, 0.9041172563704750, 0.7699026741943050,
-            0.5873179542866171, 0.3678314989981802, 0.1252334085114692;
+        result = phid(-h) * phid(-k);
     } else {
-        w0.resize(10);
-        x0.resize(10);
-        w.resize(20);
-        x.resize(20);
-        w0 << .01761400713915212, 0.04060142980038694, 0.06267204833410906,
-            .08327674157670475, 0.1019301198172404, 0.1181945319615184,
-            0.1316886384491766, 0.1420961093183821, 0.1491729864726037,
-            0.1527533871307259;
-        x0 << 0.9931285991850949, 0.9639719272779138, 0.9122344282513259,
-            0.8391169718222188, 0.7463319064601508, 0.6360536807265150,
-            0.5108670019508271, 0.3737060887154196, 0.2277858511416451,
-            0.07652652113349733;
+        return false;
     }
-    w << w0, w0;
-    x << 1.0 - x0, 1.0 + x0;
+    return true;
+}
+
+// Quadrature over asin(rho), used for |rho| < 0.925.
+template <typename Table>
+double bvnuAsin(double h, double k, double rho) {
     double hk = h*k;
+    double hs = 0.5*(h*h + k*k);
+    double asr = 0.5*std::asin(rho);
     double bvn = 0.0;
-    if (std::abs(rho) < 0.925) {
-        double hs = 0.5*(h*h + k*k);
-        double asr = 0.5*std::asin(rho);
-        Eigen::ArrayXd sn = (asr*x).sin();
-        bvn = w.matrix().dot(((sn*hk - hs)/(1.0 - sn.square())).exp().matrix());
-        bvn = 0.5*bvn*asr/M_PI + phid(-h)*phid(-k);
-    } else {
-        if (rho < 0) {
-            k = -k;
-            hk = -hk;
+    for (int i = 0; i < Table::SIZE; ++i) {
+        double sn = std::sin(asr*Table::x[i]);
+        bvn += Table::w[i]*std::exp((sn*hk - hs)/(1.0 - sn*sn));
+    }
+    return 0.5*bvn*asr/M_PI + phid(-h)*phid(-k);
+}
+
+// Vectorized version of bvnuAsin for arrays of inputs that are all in the same |rho| regime.
+template <typename Table>
+void bvnuAsin(
+    Eigen::ArrayXd const & h, Eigen::ArrayXd const & k, Eigen::ArrayXd const & rho,
+    Eigen::ArrayXd & out
+) {
+    Eigen::ArrayXd hk = h*k;
+    Eigen::ArrayXd hs = 0.5*(h.square() + k.square());
+    Eigen::ArrayXd asr = 0.5*rho.asin();
+    Eigen::ArrayXd sn(h.size());
+    out.setZero(h.size());
+    for (int i = 0; i < Table::SIZE; ++i) {
+        sn = (asr*Table::x[i]).sin();
+        out += Table::w[i]*((sn*hk - hs)/(1.0 - sn.square())).exp();
+    }
+    out = 0.5*out*asr/M_PI + h.unaryExpr([](double z) { return phid(-z); })
+        * k.unaryExpr([](double z) { return phid(-z); });
+}
+
+// Drezner & Wesolowsky's expansion for |rho| >= 0.925.
+double bvnuHighRho(double h, double k, double rho) {
+    typedef GaussLegendre20 Table;
+    double hk = h*k;
+    double bvn = 0.0;
+    if (rho < 0) {
+        k = -k;
+        hk = -hk;
+    }
+    if (std::abs(rho) < 1) {
+        double as = 1 - rho*rho;
+        double a = std::sqrt(as);
+        double bs = (h - k)*(h - k);
+        double asr = -0.5*(bs/as + hk);
+        double c = (4.0 - hk)/8.0;
+        double d = (12.0 - hk)/80.0;
+        if (asr > -100.0) {
+            bvn = a*std::exp(asr)*(1.0 - c*(bs - as)*(1.0 - d*bs)/3.0 + c*d*as*as);
         }
-        if (std::abs(rho) < 1) {
-            double as = 1 - rho*rho;
-            double a = std::sqrt(as);
-            double bs = (h - k)*(h - k);
-            double asr = -0.5*(bs/as + hk);
-            double c = (4.0 - hk)/8.0;
-            double d = (12.0 - hk)/80.0;
-            if (asr > -100.0) {
-                bvn = a*std::exp(asr)*(1.0 - c*(bs - as)*(1.0 - d*bs)/3.0 + c*d*as*as);
-            }
-            if (hk > -100.0) {
-                double b = std::sqrt(bs);
-                double sp = std::sqrt(2.0*M_PI)*phid(-b/a);
-                bvn = bvn - std::exp(-0.5*hk)*sp*b*(1.0 - c*bs*(1.0 - d*bs)/3.0);
-            }
-            a = 0.5*a;
-            Eigen::ArrayXd xs1 = (a*x).square();
-            Eigen::ArrayXd asr1 = -(bs/xs1 + hk)/2;
-            Eigen::Array<bool,Eigen::Dynamic,1> xi = asr1 > -100;
-            Eigen::ArrayXd asr2 = Eigen::ArrayXd::Zero(xi.cast<int>().sum());
-            Eigen::ArrayXd xs2 = Eigen::ArrayXd::Zero(asr2.size());
-            Eigen::ArrayXd w2 = Eigen::ArrayXd::Zero(asr2.size());
-            for (int i = 0, j = 0; i < x.size(); ++i) {
-                if (xi[i]) {
-                    asr2[j] = asr1[i];
-                    xs2[j] = xs1[i];
-                    w2[j] = w[i];
-                    ++j;
-                }
+        if (hk > -100.0) {
+            double b = std::sqrt(bs);
+            double sp = std::sqrt(2.0*M_PI)*phid(-b/a);
+            bvn = bvn - std::exp(-0.5*hk)*sp*b*(1.0 - c*bs*(1.0 - d*bs)/3.0);
+        }
+        a = 0.5*a;
+        double sum = 0.0;
+        for (int i = 0; i < Table::SIZE; ++i) {
+            double xs = (a*Table::x[i])*(a*Table::x[i]);
+            double asr1 = -(bs/xs + hk)/2;
+            if (asr1 > -100) {
+                double sp1 = 1.0 + c*xs*(1.0 + 5.0*d*xs);
+                double rs = std::sqrt(1.0 - xs);
+                double ep = std::exp(-0.5*hk*xs/((1.0 + rs)*(1.0 + rs)))/rs;
+                sum += Table::w[i]*(std::exp(asr1)*(sp1 - ep));
             }
-            Eigen::ArrayXd sp = 1.0 + c*xs2*(1.0 + 5.0*d*xs2);
-            Eigen::ArrayXd rs = (1.0 - xs2).sqrt();
-            Eigen::ArrayXd ep = (-0.5*hk*xs2/(1.0 + rs).square()).exp()/rs;
-            bvn = (a*(w2.matrix().dot((asr2.exp()*(sp - ep)).matrix())) - bvn)/(2.0*M_PI);
         }
-        if (rho > 0.0) {
-            bvn = bvn + phid(-std::max(h, k));
-        } else if (h >= k) {
-            bvn = -bvn;
+        bvn = (a*sum - bvn)/(2.0*M_PI);
+    }
+    if (rho > 0.0) {
+        bvn = bvn + phid(-std::max(h, k));
+    } else if (h >= k) {
+        bvn = -bvn;
+    } else {
+        double l = (h < 0) ? (phid(k) - phid(h)) : (phid(-h) - phid(-k));
+        bvn = l - bvn;
+    }
+    return bvn;
+}
+
+} // anonymous
+
+double phid(double z) {
+    return 0.5*std::erfc(-z / M_SQRT2);
+}
+
+double bvnu(double h, double k, double rho) {
+    double bvn = 0.0;
+    if (bvnuSpecialCase(h, k, rho, bvn)) {
+        return bvn;
+    }
+    if (std::abs(rho) < 0.3) {
+        bvn = bvnuAsin<GaussLegendre6>(h, k, rho);
+    } else if (std::abs(rho) < 0.75) {
+        bvn = bvnuAsin<GaussLegendre12>(h, k, rho);
+    } else if (std::abs(rho) < 0.925) {
+        bvn = bvnuAsin<GaussLegendre20>(h, k, rho);
+    } else {
+        bvn = bvnuHighRho(h, k, rho);
+    }
+    return std::max(0.0, std::min(1.0, bvn));
+}
+
+void bvnu(
+    ndarray::Array<double const,1,0> const & h,
+    ndarray::Array<double const,1,0> const & k,
+    ndarray::Array<double const,1,0> const & rho,
+    ndarray::Array<double,1,0> const & out
+) {
+    LSST_THROW_IF_NE(
+        h.getSize<0>(), k.getSize<0>(),
+        pex::exceptions::LengthError,
+        "Size of h array (%d) does not match size of k array (%d)"
+    );
+    LSST_THROW_IF_NE(
+        h.getSize<0>(), rho.getSize<0>(),
+        pex::exceptions::LengthError,
+        "Size of h array (%d) does not match size of rho array (%d)"
+    );
+    LSST_THROW_IF_NE(
+        h.getSize<0>(), out.getSize<0>(),
+        pex::exceptions::LengthError,
+        "Size of h array (%d) does not match size of out array (%d)"
+    );
+    // Sort the inputs into the quadrature regimes, handling special cases and |rho| >= 0.925 directly.
+    std::vector<int> groups[3];
+    for (int i = 0, n = h.getSize<0>(); i < n; ++i) {
+        double absRho = std::abs(rho[i]);
+        if (bvnuSpecialCase(h[i], k[i], rho[i], out[i])) {
+            continue;
+        } else if (absRho < 0.3) {
+            groups[0].push_back(i);
+        } else if (absRho < 0.75) {
+            groups[1].push_back(i);
+        } else if (absRho < 0.925) {
+            groups[2].push_back(i);
         } else {
-            double l = (h < 0) ? (phid(k) - phid(h)) : (phid(-h) - phid(-k));
-            bvn = l - bvn;
+            out[i] = std::max(0.0, std::min(1.0, bvnuHighRho(h[i], k[i], rho[i])));
+        }
+    }
+    Eigen::ArrayXd hGroup, kGroup, rhoGroup, outGroup;
+    for (int g = 0; g < 3; ++g) {
+        int const size = groups[g].size();
+        if (size == 0) continue;
+        hGroup.resize(size);
+        kGroup.resize(size);
+        rhoGroup.resize(size);
+        for (int j = 0; j < size; ++j) {
+            hGroup[j] = h[groups[g][j]];
+            kGroup[j] = k[groups[g][j]];
+            rhoGroup[j] = rho[groups[g][j]];
+        }
+        switch (g) {
+        case 0:
+            bvnuAsin<GaussLegendre6>(hGroup, kGroup, rhoGroup, outGroup);
+            break;
+        case 1:
+            bvnuAsin<GaussLegendre12>(hGroup, kGroup, rhoGroup, outGroup);
+            break;
+        default:
+            bvnuAsin<GaussLegendre20>(hGroup, kGroup, rhoGroup, outGroup);
+            break;
+        }
+        for (int j = 0; j < size; ++j) {
+            out[groups[g][j]] = std::max(0.0, std::min(1.0, outGroup[j]));
         }
     }
-    return std::max(0.0, std::min(1.0, bvn));
 }
 
 }}}} // namespace lsst::meas::modelfit::detail
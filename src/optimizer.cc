@@ -34,6 +34,7 @@
 #include "lsst/meas/modelfit/optimizer.h"
 #include "lsst/meas/modelfit/Likelihood.h"
 #include "lsst/meas/modelfit/Prior.h"
+#include "lsst/meas/modelfit/detail/arena.h"
 
 namespace lsst { namespace meas { namespace modelfit {
 
@@ -43,13 +44,17 @@ void OptimizerObjective::fillObjectiveValueGrid(
     ndarray::Array<Scalar const,2,1> const & grid,
     ndarray::Array<Scalar,1,1> const & output
 ) const {
-    ndarray::Array<Scalar,1,1> residuals = ndarray::allocate(dataSize);
+    ndarray::Array<Scalar,1,1> residuals = detail::allocateWorkspace<Scalar>(dataSize);
+    ndarray::Array<Scalar,1,1> prior;
+    if (hasPrior()) {
+        prior = detail::allocateWorkspace<Scalar>(output.getSize<0>());
+        computePriorBatch(grid, prior);
+    }
     for (int i = 0, n = output.getSize<0>(); i < n; ++i) {
         computeResiduals(grid[i], residuals);
         output[i] = 0.5*ndarray::asEigenMatrix(residuals).squaredNorm();
         if (hasPrior()) {
-            Scalar prior = computePrior(grid[i]);
-            output[i] -= std::log(prior);
+            output[i] -= std::log(prior[i]);
             if (std::isnan(output[i])) {
                 output[i] = std::numeric_limits<Scalar>::infinity();
             }
@@ -57,6 +62,15 @@ void OptimizerObjective::fillObjectiveValueGrid(
     }
 }
 
+void OptimizerObjective::computePriorBatch(
+    ndarray::Array<Scalar const,2,1> const & parameters,
+    ndarray::Array<Scalar,1,1> const & output
+) const {
+    for (int i = 0, n = output.getSize<0>(); i < n; ++i) {
+        output[i] = computePrior(parameters[i]);
+    }
+}
+
 namespace {
 
 class LikelihoodOptimizerObjective : public OptimizerObjective {
@@ -67,7 +81,10 @@ public:
             likelihood->getDataDim(), likelihood->getNonlinearDim() + likelihood->getAmplitudeDim()
         ),
         _likelihood(likelihood), _prior(prior),
-        _modelMatrix(ndarray::allocate(likelihood->getDataDim(), likelihood->getAmplitudeDim()))
+        _modelMatrix(
+            detail::allocateWorkspace<Pixel>(likelihood->getAmplitudeDim(), likelihood->getDataDim())
+                .transpose()
+        )
     {}
 
     void computeResiduals(
@@ -83,6 +100,24 @@ public:
         ndarray::asEigenMatrix(residuals) -= ndarray::asEigenMatrix(likelihoodData).cast<Scalar>();
     }
 
+    bool differentiateResiduals(
+        ndarray::Array<Scalar const,1,1> const & parameters,
+        ndarray::Array<Scalar,2,-2> const & derivatives
+    ) const override {
+        int nlDim = _likelihood->getNonlinearDim();
+        int ampDim = _likelihood->getAmplitudeDim();
+        if (!_likelihood->differentiateModel(derivatives[ndarray::view()(0, nlDim)],
+                                             parameters[ndarray::view(0, nlDim)],
+                                             parameters[ndarray::view(nlDim, nlDim+ampDim)])) {
+            return false;
+        }
+        // derivatives of the residuals with respect to the amplitudes are just the model matrix
+        _likelihood->computeModelMatrix(_modelMatrix, parameters[ndarray::view(0, nlDim)]);
+        ndarray::asEigenMatrix(derivatives[ndarray::view()(nlDim, nlDim+ampDim)])
+            = ndarray::asEigenMatrix(_modelMatrix).cast<Scalar>();
+        return true;
+    }
+
     bool hasPrior() const override { return static_cast<bool>(_prior); }
 
     Scalar computePrior(ndarray::Array<Scalar const,1,1> const & parameters) const override {
@@ -92,6 +127,17 @@ public:
                                 parameters[ndarray::view(nlDim, nlDim+ampDim)]);
     }
 
+    void computePriorBatch(
+        ndarray::Array<Scalar const,2,1> const & parameters,
+        ndarray::Array<Scalar,1,1> const & output
+    ) const override {
+        int nlDim = _likelihood->getNonlinearDim();
+        int ampDim = _likelihood->getAmplitudeDim();
+        _prior->evaluateBatch(parameters[ndarray::view()(0, nlDim)],
+                              parameters[ndarray::view()(nlDim, nlDim+ampDim)],
+                              output);
+    }
+
     void differentiatePrior(
         ndarray::Array<Scalar const,1,1> const & parameters,
         ndarray::Array<Scalar,1,1> const & gradient,
@@ -130,8 +176,8 @@ PTR(OptimizerObjective) OptimizerObjective::makeFromLikelihood(
 
 Optimizer::IterationData::IterationData(int dataSize, int parameterSize) :
     objectiveValue(0.0), priorValue(0.0),
-    parameters(ndarray::allocate(parameterSize)),
-    residuals(ndarray::allocate(dataSize))
+    parameters(detail::allocateWorkspace<Scalar>(parameterSize)),
+    residuals(detail::allocateWorkspace<Scalar>(dataSize))
 {}
 
 void Optimizer::IterationData::swap(IterationData & other) {
@@ -334,10 +380,13 @@ Optimizer::Optimizer(
     _trustRadius(ctrl.trustRegionInitialSize),
     _current(objective->dataSize, objective->parameterSize),
     _next(objective->dataSize, objective->parameterSize),
-    _step(ndarray::allocate(objective->parameterSize)),
-    _gradient(ndarray::allocate(objective->parameterSize)),
-    _hessian(ndarray::allocate(objective->parameterSize, objective->parameterSize)),
-    _residualDerivative(ndarray::allocate(objective->dataSize, objective->parameterSize)),
+    _step(detail::allocateWorkspace<Scalar>(objective->parameterSize)),
+    _gradient(detail::allocateWorkspace<Scalar>(objective->parameterSize)),
+    _hessian(detail::allocateWorkspace<Scalar>(objective->parameterSize, objective->parameterSize)),
+    // column-major, so allocate the transpose
+    _residualDerivative(
+        detail::allocateWorkspace<Scalar>(objective->parameterSize, objective->dataSize).transpose()
+    ),
     _sr1b(objective->parameterSize, objective->parameterSize),
     _sr1v(objective->parameterSize),
     _sr1jtr(objective->parameterSize)
@@ -0,0 +1,151 @@
+// -*- lsst-c++ -*-
+/*
+ * LSST Data Management System
+ * Copyright 2008-2013 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE arena
+
+#include <cstdint>
+#include <vector>
+
+#include "boost/test/unit_test.hpp"
+
+#include "lsst/meas/modelfit/detail/arena.h"
+
+using lsst::meas::modelfit::detail::Arena;
+using lsst::meas::modelfit::detail::ArenaScope;
+using lsst::meas::modelfit::detail::allocateWorkspace;
+
+namespace {
+
+bool isAligned(void const * p) {
+    return reinterpret_cast<std::uintptr_t>(p) % 64 == 0;
+}
+
+} // anonymous
+
+// Allocations of assorted sizes that overflow several small blocks should all be aligned, sized as
+// requested, and disjoint; after a reset the block size should grow to hold them all at once.
+BOOST_AUTO_TEST_CASE(AlignmentAndGrowth) {
+    Arena arena(1024);
+    std::vector<ndarray::Array<double,1,1>> arrays;
+    std::size_t total = 0;
+    for (int i = 0; i < 40; ++i) {
+        std::size_t n = 1 + (i*37) % 300;
+        arrays.push_back(arena.allocate<double>(n));
+        BOOST_CHECK(isAligned(arrays.back().getData()));
+        BOOST_CHECK_EQUAL(arrays.back().getSize<0>(), n);
+        arrays.back().deep() = i;
+        total += n*sizeof(double);
+    }
+    ndarray::Array<float,2,2> matrix = arena.allocate<float>(7, 5);
+    BOOST_CHECK(isAligned(matrix.getData()));
+    BOOST_CHECK_EQUAL(matrix.getSize<0>(), 7);
+    BOOST_CHECK_EQUAL(matrix.getSize<1>(), 5);
+    BOOST_CHECK_EQUAL(matrix.getStride<0>(), 5);
+    total += 35*sizeof(float);
+    BOOST_CHECK_GE(arena.getBytesAllocated(), total);
+    // no allocation was overwritten by a later one
+    for (int i = 0; i < 40; ++i) {
+        for (std::size_t j = 0; j < arrays[i].getSize<0>(); ++j) {
+            BOOST_REQUIRE_EQUAL(arrays[i][j], i);
+        }
+    }
+    std::size_t allocated = arena.getBytesAllocated();
+    arrays.clear();
+    matrix = ndarray::Array<float,2,2>();
+    arena.reset();
+    BOOST_CHECK_EQUAL(arena.getBytesAllocated(), 0u);
+    BOOST_CHECK_GE(arena.getBlockSize(), allocated);
+    // the same sequence now fits in a single block
+    char const * first = nullptr;
+    for (int i = 0; i < 40; ++i) {
+        std::size_t n = 1 + (i*37) % 300;
+        arrays.push_back(arena.allocate<double>(n));
+        BOOST_CHECK(isAligned(arrays.back().getData()));
+        char const * p = reinterpret_cast<char const *>(arrays.back().getData());
+        if (!first) first = p;
+        BOOST_CHECK(p >= first && p + n*sizeof(double) <= first + arena.getBlockSize());
+    }
+}
+
+// With nothing outstanding, a reset should make the same memory available again.
+BOOST_AUTO_TEST_CASE(ResetReuse) {
+    Arena arena(4096);
+    double const * data;
+    {
+        ndarray::Array<double,1,1> a = arena.allocate<double>(100);
+        data = a.getData();
+    }
+    arena.reset();
+    for (int i = 0; i < 3; ++i) {
+        ndarray::Array<double,1,1> b = arena.allocate<double>(100);
+        BOOST_CHECK_EQUAL(b.getData(), data);
+        b.deep() = 0.0;
+        b = ndarray::Array<double,1,1>();
+        arena.reset();
+    }
+}
+
+// An array that outlives a reset must stay valid, and its memory must not be handed out again.
+BOOST_AUTO_TEST_CASE(OutlivedReset) {
+    Arena arena(4096);
+    ndarray::Array<double,1,1> kept = arena.allocate<double>(100);
+    kept.deep() = 3.0;
+    arena.reset();
+    ndarray::Array<double,1,1> other = arena.allocate<double>(100);
+    other.deep() = -1.0;
+    BOOST_CHECK(other.getData() + 100 <= kept.getData() || kept.getData() + 100 <= other.getData());
+    for (int j = 0; j < 100; ++j) {
+        BOOST_REQUIRE_EQUAL(kept[j], 3.0);
+    }
+    // the block that was free at the last reset is the one that is recycled
+    double const * otherData = other.getData();
+    other = ndarray::Array<double,1,1>();
+    arena.reset();
+    ndarray::Array<double,1,1> next = arena.allocate<double>(100);
+    BOOST_CHECK_EQUAL(next.getData(), otherData);
+    for (int j = 0; j < 100; ++j) {
+        BOOST_REQUIRE_EQUAL(kept[j], 3.0);
+    }
+}
+
+// allocateWorkspace should use the thread's arena only while a scope is active.
+BOOST_AUTO_TEST_CASE(Scope) {
+    BOOST_CHECK(ArenaScope::getActive() == nullptr);
+    ndarray::Array<double,1,1> heap = allocateWorkspace<double>(10);
+    BOOST_CHECK_EQUAL(heap.getSize<0>(), 10);
+    {
+        ArenaScope outer;
+        Arena * arena = ArenaScope::getActive();
+        BOOST_REQUIRE(arena != nullptr);
+        {
+            ArenaScope inner;
+            BOOST_CHECK_EQUAL(ArenaScope::getActive(), arena);
+            ndarray::Array<double,2,2> a = allocateWorkspace<double>(4, 3);
+            BOOST_CHECK(isAligned(a.getData()));
+        }
+        // the inner scope must not reset the arena
+        BOOST_CHECK_GT(arena->getBytesAllocated(), 0u);
+    }
+    BOOST_CHECK(ArenaScope::getActive() == nullptr);
+}
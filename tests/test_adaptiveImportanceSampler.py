@@ -0,0 +1,145 @@
+#
+# LSST Data Management System
+#
+# Copyright 2008-2016  AURA/LSST.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <https://www.lsstcorp.org/LegalNotices/>.
+#
+import unittest
+import numpy
+
+import lsst.utils.tests
+import lsst.geom
+import lsst.afw.geom
+import lsst.afw.geom.ellipses
+import lsst.afw.detection
+import lsst.afw.image
+import lsst.afw.math
+import lsst.afw.table
+import lsst.shapelet
+import lsst.meas.modelfit
+
+
+def makeGaussianFunction(ellipse, flux=1.0):
+    """Create a single-Gaussian MultiShapeletFunction
+    """
+    s = lsst.shapelet.ShapeletFunction(0, lsst.shapelet.HERMITE, ellipse)
+    s.getCoefficients()[0] = 1.0
+    s.normalize()
+    s.getCoefficients()[0] *= flux
+    msf = lsst.shapelet.MultiShapeletFunction()
+    msf.addComponent(s)
+    return msf
+
+
+class AdaptiveImportanceSamplerTestCase(lsst.utils.tests.TestCase):
+
+    def setUp(self):
+        rng = numpy.random.RandomState(500)
+        self.model = lsst.meas.modelfit.Model.makeGaussian(lsst.meas.modelfit.Model.FIXED_CENTER)
+        ellipse = lsst.afw.geom.ellipses.Ellipse(lsst.afw.geom.ellipses.Axes(4.0, 3.0, 0.3))
+        flux = 200.0
+        ev = self.model.makeEllipseVector()
+        ev[0].setCore(ellipse.getCore())
+        ev[0].setCenter(ellipse.getCenter())
+        self.nonlinear = numpy.zeros(self.model.getNonlinearDim(), dtype=lsst.meas.modelfit.Scalar)
+        self.fixed = numpy.zeros(self.model.getFixedDim(), dtype=lsst.meas.modelfit.Scalar)
+        self.model.readEllipses(ev, self.nonlinear, self.fixed)
+        self.psf = makeGaussianFunction(1.5)
+        bbox = lsst.geom.Box2I(lsst.geom.Point2I(-20, -20), lsst.geom.Point2I(20, 20))
+        self.footprint = lsst.afw.detection.Footprint(lsst.afw.geom.SpanSet(bbox))
+        self.exposure = lsst.afw.image.ExposureF(bbox)
+        image = lsst.afw.image.ImageD(bbox)
+        makeGaussianFunction(ellipse, flux).convolve(self.psf).evaluate().addToImage(image)
+        self.exposure.getMaskedImage().getImage().getArray()[:, :] = \
+            image.getArray() + rng.randn(bbox.getHeight(), bbox.getWidth())
+        self.exposure.getMaskedImage().getVariance().set(1.0)
+        self.ctrl = lsst.meas.modelfit.UnitTransformedLikelihoodControl(usePixelWeights=True)
+        mu = numpy.concatenate([self.nonlinear, [flux]])
+        sigma = numpy.diag([0.01, 0.01, 0.01, 25.0])
+        self.components = lsst.meas.modelfit.Mixture.ComponentList()
+        self.components.append(lsst.meas.modelfit.Mixture.Component(1.0, mu, sigma))
+
+    def tearDown(self):
+        del self.model
+        del self.exposure
+        del self.footprint
+        del self.psf
+
+    def makeLikelihood(self):
+        return lsst.meas.modelfit.UnitTransformedLikelihood(
+            self.model, self.fixed.copy(), lsst.meas.modelfit.LocalUnitTransform(),
+            self.exposure, self.footprint, self.psf, self.ctrl
+        )
+
+    def runSampler(self, objective, nThreads):
+        ctrl = lsst.meas.modelfit.ImportanceSamplerControl()
+        ctrl.nSamples = 500
+        ctrl.maxRepeat = 1
+        schema = lsst.afw.table.Schema()
+        schema.addField("weight", type=float, doc="normalized importance weight")
+        schema.addField("parameters", type="ArrayD", size=4, doc="nonlinear and amplitude parameters")
+        sampler = lsst.meas.modelfit.AdaptiveImportanceSampler(
+            schema, lsst.afw.math.Random("MT19937", 5), {0: ctrl}, nThreads=nThreads
+        )
+        samples = lsst.afw.table.BaseCatalog(schema)
+        proposal = lsst.meas.modelfit.Mixture(4, self.components)
+        sampler.run(objective, proposal, samples)
+        return samples
+
+    def testObjective(self):
+        """Test that DirectSamplingObjective evaluates 0.5*chi^2 with and without a factory.
+        """
+        likelihood = self.makeLikelihood()
+        parameters = numpy.concatenate([self.nonlinear, [150.0]])
+        modelMatrix = numpy.zeros((likelihood.getDataDim(), 1), dtype=lsst.meas.modelfit.Pixel)
+        likelihood.computeModelMatrix(modelMatrix, self.nonlinear)
+        expected = 0.5*((modelMatrix[:, 0]*150.0 - likelihood.getData())**2).sum()
+        record = lsst.afw.table.BaseCatalog(lsst.afw.table.Schema()).addNew()
+        serial = lsst.meas.modelfit.DirectSamplingObjective(likelihood)
+        self.assertFalse(serial.isThreadSafe())
+        self.assertFloatsAlmostEqual(serial(parameters, record), expected, rtol=1E-6)
+        threaded = lsst.meas.modelfit.DirectSamplingObjective(self.makeLikelihood)
+        self.assertTrue(threaded.isThreadSafe())
+        self.assertFloatsAlmostEqual(threaded(parameters, record), expected, rtol=1E-6)
+        workspace = threaded.makeWorkspace()
+        self.assertFloatsAlmostEqual(threaded.evaluate(parameters, record, workspace), expected, rtol=1E-6)
+
+    def testThreads(self):
+        """Test that the samples don't depend on the number of threads.
+        """
+        objective = lsst.meas.modelfit.DirectSamplingObjective(self.makeLikelihood)
+        serial = self.runSampler(objective, 1)
+        threaded = self.runSampler(objective, 4)
+        self.assertEqual(len(serial), len(threaded))
+        self.assertGreater(len(serial), 0)
+        for name in ("parameters", "objective", "proposal", "weight"):
+            self.assertFloatsEqual(serial[name], threaded[name])
+
+
+class TestMemory(lsst.utils.tests.MemoryTestCase):
+    pass
+
+
+def setup_module(module):
+    lsst.utils.tests.init()
+
+
+if __name__ == "__main__":
+    lsst.utils.tests.init()
+    unittest.main()
@@ -145,6 +145,264 @@ class CModelTestCase(lsst.utils.tests.TestCase):
             self.assertFloatsAlmostEqual(psfFlux, cmodel.instFlux, rtol=0.1/fluxFactor**0.5)
             self.assertFloatsAlmostEqual(psfFluxErr, cmodel.instFluxErr, rtol=0.1/fluxFactor**0.5)
 
+    def testPointSource(self):
+        """Test that the point-source path is taken for an unresolved source when enabled, and that it
+        produces fluxes comparable to PsfFlux.
+        """
+        # Use a variance far from unity, so the chi^2 cut only works if it's weighted correctly.
+        sigma = 30.0
+        rng = numpy.random.RandomState(5)
+        exposure = self.exposure.Factory(self.exposure, True)
+        exposure.getMaskedImage().getImage().getArray()[:] *= 100.0*sigma
+        exposure.getMaskedImage().getVariance().getArray()[:] = sigma**2
+        exposure.getMaskedImage().getImage().getArray()[:] += \
+            sigma*rng.randn(exposure.getHeight(), exposure.getWidth())
+        psfFlux, psfFluxErr = computePsfFlux(self.xyPosition, exposure)
+        for pointSourceMaxRadiusRatio in (0.0, 0.5):
+            ctrl = lsst.meas.modelfit.CModelControl()
+            ctrl.pointSourceMaxRadiusRatio = pointSourceMaxRadiusRatio
+            algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+            cmodel = algorithm.apply(
+                exposure, makeMultiShapeletCircularGaussian(self.psfSigma),
+                self.xyPosition, self.exposure.getPsf().computeShape()
+            )
+            self.assertEqual(cmodel.flags[cmodel.POINT_SOURCE], pointSourceMaxRadiusRatio > 0.0)
+            self.assertFalse(cmodel.flags[cmodel.FAILED])
+            self.assertFloatsAlmostEqual(psfFlux, cmodel.instFlux, rtol=0.01)
+            self.assertFloatsAlmostEqual(psfFluxErr, cmodel.instFluxErr, rtol=0.01)
+
+    def testTruncatedPsf(self):
+        """Test that truncating the PSF approximation in the initial stage barely affects the final
+        exp, dev, and CModel fluxes.
+        """
+        psfModel = lsst.shapelet.MultiShapeletFunction()
+        component = lsst.shapelet.ShapeletFunction(2, lsst.shapelet.HERMITE, self.psfSigma)
+        component.getCoefficients()[:] = [1.0, 0.0, 0.0, 0.05, 0.0, 0.05]
+        component.getCoefficients()[:] /= lsst.shapelet.ShapeletFunction.FLUX_FACTOR
+        psfModel.addComponent(component)
+        self.exposure.getMaskedImage().getVariance().getArray()[:, :] = 1.0
+        results = []
+        for maxPsfOrder in (-1, 0):
+            ctrl = lsst.meas.modelfit.CModelControl()
+            ctrl.initial.maxPsfOrder = maxPsfOrder
+            algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+            result = algorithm.apply(self.exposure, psfModel, self.xyPosition,
+                                     self.exposure.getPsf().computeShape())
+            self.assertFalse(result.flags[result.FAILED])
+            results.append(result)
+        full, truncated = results
+        self.assertFloatsAlmostEqual(full.instFlux, truncated.instFlux, rtol=0.02)
+        self.assertFloatsAlmostEqual(full.exp.instFlux, truncated.exp.instFlux, rtol=0.02)
+        self.assertFloatsAlmostEqual(full.dev.instFlux, truncated.dev.instFlux, rtol=0.02)
+        self.assertFloatsAlmostEqual(full.initial.instFlux, truncated.initial.instFlux, rtol=0.1)
+
+    def testTruncatedPsfDefault(self):
+        """Test that PSF truncation is opt-in, so default outputs are unchanged.
+        """
+        ctrl = lsst.meas.modelfit.CModelControl()
+        for stage in (ctrl.initial, ctrl.exp, ctrl.dev):
+            self.assertLess(stage.maxPsfOrder, 0)
+
+    def testBinnedStages(self):
+        """Test that starting each stage on binned pixels converges to the same fit.
+        """
+        self.exposure.getMaskedImage().getVariance().getArray()[:, :] = 1.0
+        results = []
+        for binFactor in (1, 2):
+            ctrl = lsst.meas.modelfit.CModelControl()
+            for stage in (ctrl.initial, ctrl.exp, ctrl.dev):
+                stage.binFactor = binFactor
+                stage.minBinnedArea = 16
+            algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+            result = algorithm.apply(self.exposure, makeMultiShapeletCircularGaussian(self.psfSigma),
+                                     self.xyPosition, self.exposure.getPsf().computeShape())
+            self.assertFalse(result.flags[result.FAILED])
+            results.append(result)
+        self.assertFloatsAlmostEqual(results[0].instFlux, results[1].instFlux, rtol=0.01)
+        self.assertFloatsAlmostEqual(results[0].exp.instFlux, results[1].exp.instFlux, rtol=0.01)
+        self.assertFloatsAlmostEqual(results[0].dev.instFlux, results[1].dev.instFlux, rtol=0.01)
+
+    def testAdaptiveComponents(self):
+        """Test that an unresolved source is fit with fewer Gaussians without changing its flux much.
+        """
+        self.exposure.getMaskedImage().getVariance().getArray()[:, :] = 1.0
+        results = []
+        for tolerance in (0.0, 1E-3):
+            ctrl = lsst.meas.modelfit.CModelControl()
+            ctrl.exp.adaptiveFluxTolerance = tolerance
+            ctrl.dev.adaptiveFluxTolerance = tolerance
+            algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+            result = algorithm.apply(self.exposure, makeMultiShapeletCircularGaussian(self.psfSigma),
+                                     self.xyPosition, self.exposure.getPsf().computeShape())
+            self.assertFalse(result.flags[result.FAILED])
+            results.append(result)
+        full, adaptive = results
+        for stage in ("exp", "dev"):
+            fullCount = getattr(full, stage).model.getBasisVector()[0].getComponentCount()
+            adaptiveCount = getattr(adaptive, stage).model.getBasisVector()[0].getComponentCount()
+            self.assertLess(adaptiveCount, fullCount)
+            self.assertFloatsAlmostEqual(getattr(full, stage).instFlux, getattr(adaptive, stage).instFlux,
+                                         rtol=0.01)
+        self.assertFloatsAlmostEqual(full.instFlux, adaptive.instFlux, rtol=0.01)
+
+    def testAdaptiveComponentsForced(self):
+        """Test that forced mode uses the same reduced models as the reference fit.
+        """
+        self.exposure.getMaskedImage().getVariance().getArray()[:, :] = 1.0
+        psfModel = makeMultiShapeletCircularGaussian(self.psfSigma)
+        ctrl = lsst.meas.modelfit.CModelControl()
+        ctrl.exp.adaptiveFluxTolerance = 1E-3
+        ctrl.dev.adaptiveFluxTolerance = 1E-3
+        algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+        result = algorithm.apply(self.exposure, psfModel, self.xyPosition,
+                                 self.exposure.getPsf().computeShape())
+        self.assertFalse(result.flags[result.FAILED])
+        # The forced algorithm doesn't need adaptiveFluxTolerance itself to reproduce the reference.
+        forcedAlgorithm = lsst.meas.modelfit.CModelAlgorithm(lsst.meas.modelfit.CModelControl())
+        forced = forcedAlgorithm.applyForced(self.exposure, psfModel, self.xyPosition, result)
+        self.assertFalse(forced.flags[forced.FAILED])
+        for stage in ("exp", "dev"):
+            self.assertEqual(getattr(forced, stage).model.getBasisVector()[0].getComponentCount(),
+                             getattr(result, stage).model.getBasisVector()[0].getComponentCount())
+            self.assertFloatsAlmostEqual(getattr(forced, stage).instFlux, getattr(result, stage).instFlux,
+                                         rtol=0.01)
+        self.assertFloatsAlmostEqual(forced.instFlux, result.instFlux, rtol=0.01)
+
+    def testReleaseFitState(self):
+        """Test that disabling doKeepFitState drops likelihoods and objectives without changing outputs.
+        """
+        self.exposure.getMaskedImage().getVariance().getArray()[:, :] = 1.0
+        results = []
+        for doKeepFitState in (True, False):
+            ctrl = lsst.meas.modelfit.CModelControl()
+            ctrl.doKeepFitState = doKeepFitState
+            algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+            results.append(algorithm.apply(
+                self.exposure, makeMultiShapeletCircularGaussian(self.psfSigma),
+                self.xyPosition, self.exposure.getPsf().computeShape()
+            ))
+        kept, released = results
+        self.assertEqual(kept.instFlux, released.instFlux)
+        self.assertEqual(kept.instFluxErr, released.instFluxErr)
+        for stage in ("initial", "exp", "dev"):
+            self.assertIsNotNone(getattr(kept, stage).likelihood)
+            self.assertIsNotNone(getattr(kept, stage).objfunc)
+            self.assertIsNone(getattr(released, stage).likelihood)
+            self.assertIsNone(getattr(released, stage).objfunc)
+            self.assertFloatsEqual(getattr(kept, stage).nonlinear, getattr(released, stage).nonlinear)
+            self.assertFloatsEqual(getattr(kept, stage).amplitudes, getattr(released, stage).amplitudes)
+
+    def testWcsLinearizationCache(self):
+        """Test that CModel results are the same whether or not Wcs linearizations are interpolated
+        from a WcsLinearizationCache, in both regular and forced mode.
+        """
+        # Move the reference pixel far from the source, so the cache has to interpolate.
+        cdMatrix = lsst.afw.geom.makeCdMatrix(scale=0.2*lsst.geom.arcseconds, flipX=True,
+                                              orientation=35*lsst.geom.degrees)
+        self.exposure.setWcs(lsst.afw.geom.makeSkyWcs(crpix=lsst.geom.Point2D(-2000.0, 1500.0),
+                                                      crval=lsst.geom.SpherePoint(45.0, 45.0,
+                                                                                  lsst.geom.degrees),
+                                                      cdMatrix=cdMatrix))
+        self.exposure.getMaskedImage().getVariance().getArray()[:, :] = 1.0
+        psfModel = makeMultiShapeletCircularGaussian(self.psfSigma)
+        psfMoments = self.exposure.getPsf().computeShape()
+        results = []
+        for doCache in (False, True):
+            ctrl = lsst.meas.modelfit.CModelControl()
+            ctrl.doCacheWcsLinearization = doCache
+            algorithm = lsst.meas.modelfit.CModelAlgorithm(ctrl)
+            result = algorithm.apply(self.exposure, psfModel, self.xyPosition, psfMoments)
+            self.assertFalse(result.flags[result.FAILED])
+            forced = algorithm.applyForced(self.exposure, psfModel, self.xyPosition, result)
+            self.assertFalse(forced.flags[forced.FAILED])
+            results.append((result, forced))
+        for exact, cached in zip(*results):
+            self.assertFloatsAlmostEqual(exact.fitSysToMeasSys.geometric.getParameterVector(),
+                                         cached.fitSysToMeasSys.geometric.getParameterVector(),
+                                         rtol=1E-5, atol=1E-8)
+            # The linearizations differ by ~1E-6, so the fits may take slightly different paths to
+            # convergence; the (nearly unresolved) ellipses are less well-constrained than the fluxes.
+            self.assertFloatsAlmostEqual(exact.instFlux, cached.instFlux, rtol=1E-4)
+            for stage in ("initial", "exp", "dev"):
+                self.assertFloatsAlmostEqual(getattr(exact, stage).instFlux, getattr(cached, stage).instFlux,
+                                             rtol=1E-4)
+                self.assertFloatsAlmostEqual(getattr(exact, stage).ellipse.getParameterVector(),
+                                             getattr(cached, stage).ellipse.getParameterVector(),
+                                             rtol=1E-3, atol=1E-3)
+
+    def testBadPixelBitmap(self):
+        """Test that PixelFitRegion's bitmap-based masking agrees with SpanSet operations on the mask.
+        """
+        mask = self.exposure.getMaskedImage().getMask()
+        badBits = mask.getPlaneBitMask(["BAD", "SAT"])
+        rng = numpy.random.RandomState(5)
+        mask.getArray()[:, :] = numpy.where(rng.uniform(size=mask.getArray().shape) < 0.02,
+                                            mask.getPlaneBitMask("BAD"), 0)
+        mask.getArray()[:, 120:135] |= mask.getPlaneBitMask("SAT")
+        ctrl = lsst.meas.modelfit.PixelFitRegionControl()
+        ctrl.badMaskPlanes = ["BAD", "SAT"]
+        ctrl.maxBadPixelFraction = 1.0
+        bitmap = lsst.meas.modelfit.BadPixelBitmap(mask, badBits)
+        self.assertTrue(bitmap.isSnapshotOf(mask))
+        for center in (self.xyPosition, lsst.geom.Point2D(95.5, -90.2)):
+            quadrupole = lsst.afw.geom.ellipses.Quadrupole(150.0, 60.0, 40.0)
+            spans = lsst.afw.geom.SpanSet.fromShape(lsst.afw.geom.ellipses.Ellipse(quadrupole, center))
+            spans = spans.clippedTo(mask.getBBox()).intersectNot(mask, badBits)
+            region1 = lsst.meas.modelfit.PixelFitRegion(ctrl, quadrupole)
+            region1.applyMask(mask, center)
+            region2 = lsst.meas.modelfit.PixelFitRegion(ctrl, quadrupole)
+            region2.applyMask(bitmap, center)
+            self.assertEqual(region1.footprint.getSpans(), spans)
+            self.assertEqual(region2.footprint.getSpans(), spans)
+        # A copy of the mask is a different mask; editing the mask in place is not detected.
+        self.assertFalse(bitmap.isSnapshotOf(lsst.afw.image.Mask(mask, True)))
+        mask.getArray()[10, 20] ^= mask.getPlaneBitMask("BAD")
+        self.assertTrue(bitmap.isSnapshotOf(mask))
+        x, y = mask.getX0() + 20, mask.getY0() + 10
+        self.assertNotEqual(bitmap.isBad(x, y), lsst.meas.modelfit.BadPixelBitmap(mask, badBits).isBad(x, y))
+
+    def testBadPixelBitmapCache(self):
+        """Test that CModel reuses its bad pixel bitmap for the same mask until the cache is reset.
+        """
+        self.exposure.getMaskedImage().getVariance().getArray()[:, :] = 1.0
+        algorithm = lsst.meas.modelfit.CModelAlgorithm(lsst.meas.modelfit.CModelControl())
+        psfModel = makeMultiShapeletCircularGaussian(self.psfSigma)
+        psfMoments = self.exposure.getPsf().computeShape()
+        result = algorithm.apply(self.exposure, psfModel, self.xyPosition, psfMoments)
+        self.assertFalse(result.flags[result.FAILED])
+        mask = self.exposure.getMaskedImage().getMask()
+        mask.getArray()[:, :] |= mask.getPlaneBitMask("BAD")
+        # in-place edits are not seen until the cache is reset
+        result = algorithm.apply(self.exposure, psfModel, self.xyPosition, psfMoments)
+        self.assertFalse(result.flags[result.REGION_MAX_BAD_PIXEL_FRACTION])
+        algorithm.resetBadPixelCache()
+        result = algorithm.apply(self.exposure, psfModel, self.xyPosition, psfMoments)
+        self.assertTrue(result.flags[result.FAILED])
+        self.assertTrue(result.flags[result.REGION_MAX_BAD_PIXEL_FRACTION])
+
+    def testInformationTrim(self):
+        """Test that PixelFitRegion only trims the fit regions of faint sources, and that the trimmed
+        region contains the requested fraction of the flux information.
+        """
+        ctrl = lsst.meas.modelfit.PixelFitRegionControl()
+        ctrl.maxTrimSignalToNoise = 20.0
+        ctrl.informationFraction = 0.95
+        psfMoments = lsst.afw.geom.ellipses.Quadrupole(4.0, 4.0, 0.0)
+        deconvolved = lsst.afw.geom.ellipses.Quadrupole(3.0, 2.0, 0.5)
+        initial = lsst.afw.geom.ellipses.Quadrupole(200.0, 150.0, 20.0)
+        expected = lsst.afw.geom.ellipses.Quadrupole(deconvolved)
+        expected.convolve(psfMoments).inPlace()
+        expected.scale(-numpy.log(1.0 - ctrl.informationFraction)**0.5)
+        for signalToNoise, trimmed in [(-1.0, False), (5.0, True), (50.0, False)]:
+            region = lsst.meas.modelfit.PixelFitRegion(ctrl, initial)
+            region.applyEllipse(deconvolved, psfMoments, signalToNoise)
+            self.assertEqual(region.usedInformationTrim, trimmed)
+            if trimmed:
+                self.assertFloatsAlmostEqual(region.ellipse.getParameterVector(),
+                                             expected.getParameterVector(), rtol=1E-12)
+            else:
+                self.assertGreater(region.ellipse.getArea(), expected.getArea())
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
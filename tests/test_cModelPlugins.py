@@ -109,6 +109,33 @@ class CModelTestCase(lsst.meas.base.tests.AlgorithmTestCase, lsst.utils.tests.Te
         forcedTask.run(measCat, exposure2, refCat, refWcs)
         self.checkOutputs(measCat, catalog2)
 
+    def testAdaptiveComponents(self):
+        """Test that the component counts chosen by adaptiveFluxTolerance are recorded, and that
+        forced measurement on those references works."""
+        plugin = "modelfit_CModel"
+        dependencies = ("modelfit_DoubleShapeletPsfApprox", "base_PsfFlux")
+        config = self.makeSingleFrameMeasurementConfig(plugin, dependencies=dependencies)
+        config.plugins[plugin].exp.adaptiveFluxTolerance = 1E-3
+        config.plugins[plugin].dev.adaptiveFluxTolerance = 1E-3
+        sfmTask = self.makeSingleFrameMeasurementTask(config=config)
+        forcedTask = self.makeForcedMeasurementTask(plugin, dependencies=dependencies,
+                                                    refSchema=sfmTask.schema)
+        exposure, catalog = self.dataset.realize(10.0, sfmTask.schema, randomSeed=0)
+        sfmTask.run(catalog, exposure)
+        self.checkOutputs(catalog)
+        for record in catalog:
+            self.assertGreater(record.get("modelfit_CModel_exp_nComponents"), 0)
+            self.assertGreater(record.get("modelfit_CModel_dev_nComponents"), 0)
+        measCat = forcedTask.generateMeasCat(exposure, catalog, exposure.getWcs())
+        forcedTask.attachTransformedFootprints(measCat, catalog, exposure, exposure.getWcs())
+        forcedTask.run(measCat, exposure, catalog, exposure.getWcs())
+        self.checkOutputs(measCat, catalog)
+        for measRecord, refRecord in zip(measCat, catalog):
+            for stage in ("exp", "dev"):
+                self.assertFloatsAlmostEqual(measRecord.get("modelfit_CModel_%s_instFlux" % stage),
+                                             refRecord.get("modelfit_CModel_%s_instFlux" % stage),
+                                             rtol=0.01)
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
@@ -355,6 +355,52 @@ class DoubleShapeletPsfApproxTestMixin:
                 self.assertLessEqual(bestChiSq, computeChiSq(msf))
                 component.getCoefficients()[i] = original
 
+    def testWarmStart(self):
+        """Test that starting from a previous fit via initializeResult(ctrl, previous) gives a
+        unit-flux, unit-circle MultiShapeletFunction and a fit as good as a cold start.
+        """
+        image = self.psf.computeKernelImage()
+        previous = self.Algorithm.initializeResult(self.ctrl)
+        self.Algorithm.fitMoments(previous, self.ctrl, image)
+        self.Algorithm.fitProfile(previous, self.ctrl, image)
+        self.Algorithm.fitShapelets(previous, self.ctrl, image)
+        msf = self.Algorithm.initializeResult(self.ctrl, previous)
+        self.assertFloatsAlmostEqual(msf.evaluate().integrate(), 1.0)
+        moments = msf.evaluate().computeMoments()
+        axes = lsst.afw.geom.ellipses.Axes(moments.getCore())
+        self.assertFloatsAlmostEqual(axes.getA(), 1.0)
+        self.assertFloatsAlmostEqual(axes.getB(), 1.0)
+        self.Algorithm.fitMoments(msf, self.ctrl, image)
+        self.Algorithm.fitProfile(msf, self.ctrl, image)
+        self.Algorithm.fitShapelets(msf, self.ctrl, image)
+        self.checkBounds(msf)
+        self.checkFitQuality(msf)
+
+    def testPsfFitCache(self):
+        """Test that PsfFitCache returns the most recent fit within the maximum distance, and only
+        for the Psf it was populated with.
+        """
+        cache = lsst.meas.modelfit.PsfFitCache(5.0, 2)
+        msf1 = self.Algorithm.initializeResult(self.ctrl)
+        msf2 = self.Algorithm.initializeResult(self.ctrl)
+        msf2.getComponents()[0].getCoefficients()[0] *= 2.0
+        self.assertIsNone(cache.find(self.psf, lsst.geom.Point2D(0.0, 0.0)))
+        cache.insert(self.psf, lsst.geom.Point2D(0.0, 0.0), msf1)
+        cache.insert(self.psf, lsst.geom.Point2D(3.0, 0.0), msf2)
+        self.assertEqual(cache.getSize(), 2)
+        found = cache.find(self.psf, lsst.geom.Point2D(1.0, 0.0))
+        self.assertFloatsAlmostEqual(found.getComponents()[0].getCoefficients(),
+                                     msf2.getComponents()[0].getCoefficients())
+        found = cache.find(self.psf, lsst.geom.Point2D(-4.0, 0.0))
+        self.assertFloatsAlmostEqual(found.getComponents()[0].getCoefficients(),
+                                     msf1.getComponents()[0].getCoefficients())
+        self.assertIsNone(cache.find(self.psf, lsst.geom.Point2D(10.0, 0.0)))
+        otherPsf = lsst.afw.detection.GaussianPsf(25, 25, 3.0)
+        self.assertIsNone(cache.find(otherPsf, lsst.geom.Point2D(0.0, 0.0)))
+        cache.insert(otherPsf, lsst.geom.Point2D(20.0, 0.0), msf1)
+        self.assertEqual(cache.getSize(), 1)
+        self.assertIsNone(cache.find(self.psf, lsst.geom.Point2D(0.0, 0.0)))
+
     def testSingleFrameConfigIO(self):
         config1 = lsst.meas.base.SingleFrameMeasurementTask.ConfigClass()
         config2 = lsst.meas.base.SingleFrameMeasurementTask.ConfigClass()
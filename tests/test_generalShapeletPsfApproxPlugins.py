@@ -195,6 +195,72 @@ class GeneralShapeletPsfApproxPluginsTestCase(lsst.utils.tests.TestCase):
         self.assertTrue(measRecord.get("modelfit_GeneralShapeletPsfApprox_Full_flag_max_outer_iterations"))
         self.assertFalse(measRecord.get("modelfit_GeneralShapeletPsfApprox_Full_flag_exception"))
 
+    def makeGalsimExposure(self):
+        psfImage = lsst.afw.image.ImageD(os.path.join(self.psfDir, "galsimPsf_0.9.fits"))
+        psfImage.setXY0(lsst.geom.Point2I(0, 0))
+        self.exposure.setPsf(lsst.meas.algorithms.KernelPsf(lsst.afw.math.FixedKernel(psfImage)))
+        return lsst.geom.Point2D(psfImage.getArray().shape[0]/2, psfImage.getArray().shape[1]/2)
+
+    def runFull(self, positions, warmStartMaxDistance=0.0, maxOuterIterations=None, warmStart=None):
+        """Measure the "Full" model at the given positions, returning the records and plugin.
+
+        If warmStart is not None, it is inserted into the plugin's cache at the first position, and
+        the remaining positions are measured.
+        """
+        config = self.makeBlankConfig()
+        config.plugins.names = ["modelfit_GeneralShapeletPsfApprox"]
+        pluginConfig = config.plugins["modelfit_GeneralShapeletPsfApprox"]
+        pluginConfig.sequence = ["Full"]
+        pluginConfig.warmStartMaxDistance = warmStartMaxDistance
+        if maxOuterIterations is not None:
+            pluginConfig.models["Full"].optimizer.maxOuterIterations = maxOuterIterations
+        schema = lsst.afw.table.SourceTable.makeMinimalSchema()
+        centroidKey = lsst.afw.table.Point2DKey.addFields(schema, "centroid", "centroid", "pixel")
+        schema.getAliasMap().set("slot_Centroid", "centroid")
+        task = lsst.meas.base.SingleFrameMeasurementTask(config=config, schema=schema)
+        plugin = task.plugins["modelfit_GeneralShapeletPsfApprox"]
+        if warmStart is not None:
+            plugin.caches[0].insert(self.exposure.getPsf(), positions[0], warmStart)
+            positions = positions[1:]
+        measCat = lsst.afw.table.SourceCatalog(schema)
+        for position in positions:
+            measCat.addNew().set(centroidKey, position)
+        task.run(measCat, self.exposure)
+        key = lsst.shapelet.MultiShapeletFunctionKey(schema["modelfit"]["GeneralShapeletPsfApprox"]["Full"])
+        return measCat, key
+
+    def testWarmStart(self):
+        """Test that warm-starting the plugin from nearby fits gives the same results as fitting each
+        source from its moments, with fewer optimizer iterations.
+        """
+        center = self.makeGalsimExposure()
+        positions = [center, center + lsst.geom.Extent2D(1.0, 0.5)]
+        cold, key = self.runFull(positions)
+        warm, key = self.runFull(positions, warmStartMaxDistance=5.0)
+        for coldRecord, warmRecord in zip(cold, warm):
+            self.assertFalse(coldRecord.get("modelfit_GeneralShapeletPsfApprox_Full_flag"))
+            self.assertFalse(warmRecord.get("modelfit_GeneralShapeletPsfApprox_Full_flag"))
+            bbox = lsst.geom.Box2I(lsst.geom.Point2I(-10, -10), lsst.geom.Point2I(10, 10))
+            coldImage = lsst.afw.image.ImageD(bbox)
+            warmImage = lsst.afw.image.ImageD(bbox)
+            coldRecord.get(key).evaluate().addToImage(coldImage)
+            warmRecord.get(key).evaluate().addToImage(warmImage)
+            self.assertFloatsAlmostEqual(coldImage.getArray(), warmImage.getArray(),
+                                         atol=1E-4*coldImage.getArray().max())
+        # Find the fewest outer iterations the second source can be fit with, with and without a warm
+        # start from the first source's fit.
+        reference = cold[0].get(key)
+
+        def countIterations(warmStart):
+            for maxOuterIterations in range(1, 200):
+                measCat, _ = self.runFull(positions, maxOuterIterations=maxOuterIterations,
+                                          warmStartMaxDistance=5.0 if warmStart else 0.0,
+                                          warmStart=reference if warmStart else None)
+                if not measCat[-1].get("modelfit_GeneralShapeletPsfApprox_Full_flag"):
+                    return maxOuterIterations
+            self.fail("fit did not converge")
+        self.assertLess(countIterations(True), countIterations(False))
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
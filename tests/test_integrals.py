@@ -40,6 +40,22 @@ class IntegralsTestCase(lsst.utils.tests.TestCase):
             p2 = lsst.meas.modelfit.detail.bvnu(h, k, r)
             self.assertFloatsAlmostEqual(p1, p2, rtol=1E-14)
 
+    def testBVNBatch(self):
+        """Test that the vectorized bvnu matches the reference data and the scalar version.
+        """
+        data = numpy.loadtxt(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                          "reference", "bvn.txt"), delimiter=',')
+        # shuffle so the |rho| regimes are interleaved, and add some special cases
+        data = data[numpy.random.permutation(data.shape[0])]
+        h = numpy.concatenate([data[:, 0], [numpy.inf, -numpy.inf, -numpy.inf, 0.5, 0.3]])
+        k = numpy.concatenate([data[:, 1], [0.0, -numpy.inf, 0.2, -numpy.inf, -0.4]])
+        rho = numpy.concatenate([data[:, 2], [0.5, 0.5, -0.3, 0.9, 0.0]])
+        out = numpy.zeros(h.size, dtype=float)
+        lsst.meas.modelfit.detail.bvnu(h, k, rho, out)
+        self.assertFloatsAlmostEqual(out[:data.shape[0]], data[:, 3], rtol=1E-14)
+        for hi, ki, ri, pi in zip(h, k, rho, out):
+            self.assertFloatsAlmostEqual(lsst.meas.modelfit.detail.bvnu(hi, ki, ri), pi, rtol=1E-14)
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
@@ -25,6 +25,7 @@ import unittest
 import numpy
 
 import lsst.utils.tests
+import lsst.pex.exceptions
 import lsst.meas.modelfit
 
 try:
@@ -132,6 +133,125 @@ class MixtureTestCase(lsst.utils.tests.TestCase):
             self.assertFloatsAlmostEqual(c1.getSigma(), c2.getSigma())
         os.remove(filename)
 
+    def testEvaluateBlocks(self):
+        """Test that vectorized evaluation over many points matches single-point evaluation.
+        """
+        for df in [float("inf"), 4.0]:
+            mixture = self.makeRandomMixture(3, 5, df=df)
+            x = numpy.random.randn(300, 3)*4
+            p = numpy.zeros(300, dtype=float)
+            pc = numpy.zeros((300, 5), dtype=float)
+            mixture.evaluate(x, p)
+            mixture.evaluateComponents(x, pc)
+            for i in range(x.shape[0]):
+                self.assertFloatsAlmostEqual(p[i], mixture.evaluate(x[i]), rtol=1E-12)
+                for k, component in enumerate(mixture):
+                    self.assertFloatsAlmostEqual(pc[i, k], mixture.evaluate(component, x[i]), rtol=1E-12)
+
+    def testCounterRandomDraw(self):
+        """Test that drawing with a CounterRandom is reproducible, independent of the number of threads
+        and batching, and has the right moments.
+        """
+        for df in [float("inf"), 4.0]:
+            mixture = self.makeRandomMixture(2, 3, df=df)
+            rng = lsst.meas.modelfit.CounterRandom(seed=42, sourceId=7)
+            x1 = numpy.zeros((3000, 2), dtype=float)
+            mixture.draw(rng, x1)
+            x2 = numpy.zeros((3000, 2), dtype=float)
+            mixture.draw(rng, x2, nThreads=4)
+            self.assertTrue((x1 == x2).all())
+            x3 = numpy.zeros((3000, 2), dtype=float)
+            mixture.draw(rng, x3[:1000], offset=0, nThreads=2)
+            mixture.draw(rng, x3[1000:], offset=1000, nThreads=3)
+            self.assertTrue((x1 == x3).all())
+            x4 = numpy.zeros((3000, 2), dtype=float)
+            mixture.draw(lsst.meas.modelfit.CounterRandom(seed=42, sourceId=8), x4)
+            self.assertFalse((x1 == x4).any())
+            mean = sum(component.weight*component.getMu() for component in mixture)
+            self.assertFloatsAlmostEqual(x1.mean(axis=0), mean, atol=0.2)
+
+    def testEMStatistics(self):
+        """Test that EM updates from batched and multithreaded sufficient statistics match a single
+        direct update, for both Gaussian and Student's T mixtures.
+        """
+        restriction = lsst.meas.modelfit.Mixture.UpdateRestriction(3)
+        for df in [float("inf"), 4.0]:
+            mixture = self.makeRandomMixture(3, 4, df=df)
+            x = numpy.zeros((5000, 3), dtype=float)
+            mixture.draw(self.rng, x)
+            w = numpy.random.rand(5000)
+            direct = mixture.clone()
+            direct.updateEM(x, w, restriction)
+            for nThreads in [1, 3]:
+                batched = mixture.clone()
+                stats = lsst.meas.modelfit.Mixture.EMStatistics(batched)
+                batched.accumulateEM(x[:2000], w[:2000], stats, nThreads=nThreads)
+                batched.accumulateEM(x[2000:], w[2000:], stats, nThreads=nThreads)
+                self.assertFloatsAlmostEqual(stats.getTotalWeight(), w.sum(), rtol=1E-12)
+                batched.updateEM(stats, restriction)
+                for c1, c2 in zip(direct, batched):
+                    self.assertFloatsAlmostEqual(c1.weight, c2.weight, rtol=1E-10)
+                    self.assertFloatsAlmostEqual(c1.getMu(), c2.getMu(), rtol=1E-8, atol=1E-10)
+                    self.assertFloatsAlmostEqual(c1.getSigma(), c2.getSigma(), rtol=1E-8, atol=1E-10)
+
+    def testOnlineEM(self):
+        """Test two online EM updates, each blending a new batch into a running average of the
+        statistics with scale() and add(), against the same update computed directly.
+        """
+        restriction = lsst.meas.modelfit.Mixture.UpdateRestriction(3)
+        mixture = self.makeRandomMixture(3, 4)
+        batches = []
+        for i in range(2):
+            x = numpy.zeros((3000, 3), dtype=float)
+            mixture.draw(self.rng, x)
+            batches.append((x, numpy.random.rand(3000)))
+        running = lsst.meas.modelfit.Mixture.EMStatistics(mixture)
+        expected = [None]*len(mixture)
+        for x, w in batches:
+            # expected statistics: decayed sums of responsibility-weighted moments around the origin
+            p = numpy.zeros((x.shape[0], len(mixture)), dtype=float)
+            mixture.evaluateComponents(x, p)
+            r = w[:, numpy.newaxis]*p/p.sum(axis=1)[:, numpy.newaxis]
+            for k in range(len(mixture)):
+                s0, s1, s2 = (0.0, 0.0, 0.0) if expected[k] is None else expected[k]
+                expected[k] = (0.5*s0 + 0.5*r[:, k].sum(),
+                               0.5*s1 + 0.5*numpy.dot(r[:, k], x),
+                               0.5*s2 + 0.5*numpy.dot(x.transpose()*r[:, k], x))
+            # the new batch is centered on the current mus, which differ from the running centers
+            batch = lsst.meas.modelfit.Mixture.EMStatistics(mixture)
+            mixture.accumulateEM(x, w, batch)
+            running.scale(0.5)
+            running.add(batch, 0.5)
+            self.assertFloatsAlmostEqual(running.getTotalWeight(), sum(e[0] for e in expected), rtol=1E-12)
+            mixture.updateEM(running, restriction)
+            for component, (s0, s1, s2) in zip(mixture, expected):
+                mu = s1/s0
+                self.assertFloatsAlmostEqual(component.getMu(), mu, rtol=1E-8, atol=1E-10)
+                self.assertFloatsAlmostEqual(component.getSigma(), s2/s0 - numpy.outer(mu, mu),
+                                             rtol=1E-7, atol=1E-9)
+
+    def testEvaluationTolerance(self):
+        """Test that skipping negligible components keeps the error within the requested tolerance.
+        """
+        tolerance = 1E-4
+        exact = self.makeRandomMixture(3, 20)
+        pruned = exact.clone()
+        pruned.setEvaluationTolerance(tolerance)
+        self.assertEqual(pruned.getEvaluationTolerance(), tolerance)
+        x = numpy.random.randn(200, 3)*6
+        pExact = numpy.zeros(200, dtype=float)
+        pPruned = numpy.zeros(200, dtype=float)
+        exact.evaluate(x, pExact)
+        pruned.evaluate(x, pPruned)
+        self.assertTrue((pPruned <= pExact*(1.0 + 1E-12)).all())
+        self.assertFloatsAlmostEqual(pPruned, pExact, rtol=tolerance)
+        for xi, pi in zip(x, pExact):
+            p, errorBound = pruned.evaluateWithErrorBound(xi)
+            self.assertLessEqual(pi - p, errorBound*(1.0 + 1E-12) + 1E-300)
+            self.assertLessEqual(errorBound, tolerance*p)
+        with self.assertRaises(lsst.pex.exceptions.InvalidParameterError):
+            pruned.setEvaluationTolerance(-1.0)
+
     def testDerivatives(self):
         epsilon = 1E-7
         g = self.makeRandomMixture(3, 4)
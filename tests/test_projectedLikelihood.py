@@ -194,6 +194,53 @@ class UnitTransformedLikelihoodTestCase(lsst.utils.tests.TestCase):
                                      exposure1c.getMaskedImage().getImage().getArray(),
                                      rtol=1E-5, atol=1E-6, **ASSERT_CLOSE_KWDS)
 
+    def testFromStandard(self):
+        """Test that LocalUnitTransform.fromStandard agrees with constructing the standard UnitSystem
+        and its Wcs pair transform explicitly.
+        """
+        wcs = lsst.afw.geom.makeSkyWcs(crpix=lsst.geom.Point2D(10.0, -20.0),
+                                       crval=self.position,
+                                       cdMatrix=lsst.afw.geom.makeCdMatrix(scale=0.3*lsst.geom.arcseconds,
+                                                                           orientation=30*lsst.geom.degrees))
+        sys = lsst.meas.modelfit.UnitSystem(wcs, lsst.afw.image.PhotoCalib(30))
+        flux = 25.0
+        for pixel in (lsst.geom.Point2D(10.0, -20.0), lsst.geom.Point2D(230.5, 415.0)):
+            standard = lsst.meas.modelfit.UnitSystem(wcs.pixelToSky(pixel), sys.photoCalib, flux)
+            t1 = lsst.meas.modelfit.LocalUnitTransform(standard.wcs.getPixelOrigin(), standard, sys)
+            t2 = lsst.meas.modelfit.LocalUnitTransform.fromStandard(pixel, flux, sys)
+            self.assertFloatsAlmostEqual(t1.geometric.getParameterVector(),
+                                         t2.geometric.getParameterVector(),
+                                         rtol=1E-6, atol=1E-6)
+            self.assertFloatsAlmostEqual(t1.flux, t2.flux, rtol=1E-12)
+            self.assertFloatsAlmostEqual(t1.sb, t2.sb, rtol=1E-6)
+
+    def testWcsLinearizationCache(self):
+        """Test that interpolated Wcs linearizations agree with exact ones to within the tolerance,
+        and that caches are shared by WcsLinearizationCache.get.
+        """
+        wcs = lsst.afw.geom.makeSkyWcs(crpix=lsst.geom.Point2D(1000.0, 1000.0),
+                                       crval=self.position,
+                                       cdMatrix=lsst.afw.geom.makeCdMatrix(scale=0.5*lsst.geom.arcseconds,
+                                                                           orientation=30*lsst.geom.degrees))
+        bbox = lsst.geom.Box2I(lsst.geom.Point2I(0, 0), lsst.geom.Extent2I(2000, 1500))
+        tolerance = 1E-6
+        cache = lsst.meas.modelfit.WcsLinearizationCache(wcs, bbox, tolerance)
+        self.assertTrue(cache.isInterpolated())
+        sys = lsst.meas.modelfit.UnitSystem(wcs, lsst.afw.image.PhotoCalib(30))
+        rng = numpy.random.RandomState(5)
+        for x, y in zip(rng.uniform(-0.5, 1999.5, size=20), rng.uniform(-0.5, 1499.5, size=20)):
+            pixel = lsst.geom.Point2D(x, y)
+            exact = lsst.meas.modelfit.WcsLinearizationCache.computePixelToTangent(wcs, pixel).getMatrix()
+            interpolated = cache.getPixelToTangent(pixel).getMatrix()
+            self.assertLess(numpy.abs(interpolated - exact).max(), tolerance*numpy.abs(exact).max())
+            t1 = lsst.meas.modelfit.LocalUnitTransform.fromStandard(pixel, 25.0, sys)
+            t2 = lsst.meas.modelfit.LocalUnitTransform.fromStandard(pixel, 25.0, sys, cache)
+            self.assertFloatsAlmostEqual(t1.geometric.getParameterVector(),
+                                         t2.geometric.getParameterVector(),
+                                         rtol=1E-5, atol=1E-5)
+        shared = lsst.meas.modelfit.WcsLinearizationCache.get(wcs, bbox, tolerance)
+        self.assertIs(lsst.meas.modelfit.WcsLinearizationCache.get(wcs, bbox, tolerance), shared)
+
     def testDirect(self):
         """Test likelihood evaluation when the fit system is the same as the data system.
         """
@@ -254,6 +301,49 @@ class UnitTransformedLikelihoodTestCase(lsst.utils.tests.TestCase):
                                                            efv, ctrl)
         self.checkLikelihood(l1d, data*weights)
 
+    def testProjectedWcsCache(self):
+        """Test that multi-epoch likelihoods whose EpochFootprints carry a WcsLinearizationCache (and
+        hence use LocalUnitTransform.fromJacobians) agree with those that linearize the Wcs directly.
+        """
+        # Put the source far from the data Wcs' reference pixel, and rotate it relative to the fit
+        # system, so the interpolated linearization is not trivially exact.
+        wcs1 = lsst.afw.geom.makeSkyWcs(crpix=lsst.geom.Point2D(-1500.0, 2500.0),
+                                        crval=self.position,
+                                        cdMatrix=lsst.afw.geom.makeCdMatrix(scale=0.4*lsst.geom.arcseconds,
+                                                                            orientation=20*lsst.geom.degrees))
+        pixel1 = wcs1.skyToPixel(self.position)
+        center1 = lsst.geom.Point2I(int(round(pixel1.getX())), int(round(pixel1.getY())))
+        bbox1 = lsst.geom.Box2I(center1 - lsst.geom.Extent2I(40, 40), lsst.geom.Extent2I(81, 81))
+        footprint1 = lsst.afw.detection.Footprint(lsst.afw.geom.SpanSet(bbox1))
+        exposure1 = lsst.afw.image.ExposureF(bbox1)
+        exposure1.setWcs(wcs1)
+        exposure1.setPhotoCalib(self.sys1.photoCalib)
+        t01 = lsst.meas.modelfit.LocalUnitTransform(self.sys0.wcs.skyToPixel(self.position), self.sys0,
+                                                    lsst.meas.modelfit.UnitSystem(exposure1))
+        addGaussian(exposure1, self.ellipse.transform(t01.geometric), self.flux*t01.flux, psf=self.psf1)
+        var = numpy.random.rand(bbox1.getHeight(), bbox1.getWidth()) + 2.0
+        exposure1.getMaskedImage().getVariance().getArray()[:, :] = var
+        cache = lsst.meas.modelfit.WcsLinearizationCache(wcs1, bbox1)
+        self.assertTrue(cache.isInterpolated())
+        ctrl = lsst.meas.modelfit.UnitTransformedLikelihoodControl()
+        ctrl.usePixelWeights = True
+        results = []
+        for wcsCache in (None, cache):
+            efv = [lsst.meas.modelfit.EpochFootprint(self.footprint0, self.exposure0, self.psf0),
+                   lsst.meas.modelfit.EpochFootprint(footprint1, exposure1, self.psf1, wcsCache)]
+            likelihood = lsst.meas.modelfit.UnitTransformedLikelihood(
+                self.model, self.fixed, self.sys0, self.position, efv, ctrl
+            )
+            matrix = numpy.zeros((1, likelihood.getDataDim()), dtype=lsst.meas.modelfit.Pixel).transpose()
+            likelihood.computeModelMatrix(matrix, self.nonlinear)
+            results.append((likelihood.getData().copy(), numpy.dot(matrix, self.amplitudes)))
+        self.assertFloatsAlmostEqual(results[0][0], results[1][0], rtol=1E-12, **ASSERT_CLOSE_KWDS)
+        self.assertFloatsAlmostEqual(results[0][1], results[1][1], rtol=1E-5, atol=1E-6,
+                                     **ASSERT_CLOSE_KWDS)
+        # both should reproduce the data, which was simulated with the exact transform
+        self.assertFloatsAlmostEqual(results[1][1], results[1][0], rtol=1E-5, atol=1E-6,
+                                     **ASSERT_CLOSE_KWDS)
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
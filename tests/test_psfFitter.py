@@ -272,6 +272,46 @@ class GeneralPsfFitterTestCase(lsst.utils.tests.TestCase):
                                              atol=tolerances[configKey],
                                              plotOnFailure=True)
 
+    def testDifferentiateModel(self):
+        """Test MultiShapeletPsfLikelihood's analytic model derivatives against finite differences
+        of its model matrix.
+        """
+        image = numpy.zeros((41, 41), dtype=lsst.meas.modelfit.Pixel)
+        xy0 = lsst.geom.Point2I(-20, -20)
+        step = 1E-3
+        # Use a private generator so the random parameters do not depend on which tests ran first.
+        rng = numpy.random.RandomState(500)
+        for configKey in ["full", "ellipse"]:
+            fitter = lsst.meas.modelfit.GeneralPsfFitter(self.configs[configKey].makeControl())
+            model = fitter.getModel()
+            ellipses = model.makeEllipseVector()
+            for i, ellipse in enumerate(ellipses):
+                ellipse.setParameterVector(numpy.array([0.1 - 0.05*i, -0.05 + 0.03*i, 0.6 + 0.3*i,
+                                                        0.2, -0.3]))
+            nonlinear = numpy.zeros(model.getNonlinearDim(), dtype=lsst.meas.modelfit.Scalar)
+            fixed = numpy.zeros(model.getFixedDim(), dtype=lsst.meas.modelfit.Scalar)
+            model.readEllipses(ellipses, nonlinear, fixed)
+            nonlinear[:] = 0.05*rng.randn(model.getNonlinearDim())
+            amplitudes = rng.randn(model.getAmplitudeDim())
+            likelihood = lsst.meas.modelfit.MultiShapeletPsfLikelihood(image, xy0, model, 1.0, fixed)
+
+            def computeModel(parameters):
+                modelMatrix = numpy.zeros((likelihood.getDataDim(), likelihood.getAmplitudeDim()),
+                                          dtype=lsst.meas.modelfit.Pixel)
+                likelihood.computeModelMatrix(modelMatrix, parameters)
+                return numpy.dot(modelMatrix.astype(lsst.meas.modelfit.Scalar), amplitudes)
+
+            analytic = numpy.zeros((likelihood.getDataDim(), likelihood.getNonlinearDim()),
+                                   dtype=lsst.meas.modelfit.Scalar)
+            self.assertTrue(likelihood.differentiateModel(analytic, nonlinear, amplitudes))
+            numeric = numpy.zeros(analytic.shape, dtype=lsst.meas.modelfit.Scalar)
+            for k in range(likelihood.getNonlinearDim()):
+                offset = numpy.zeros(likelihood.getNonlinearDim(), dtype=lsst.meas.modelfit.Scalar)
+                offset[k] = step
+                numeric[:, k] = (computeModel(nonlinear + offset) - computeModel(nonlinear - offset))/(2*step)
+            # The model matrix is single precision, so allow for round-off in the finite differences.
+            self.assertFloatsAlmostEqual(analytic, numeric, atol=1E-3*numpy.abs(numeric).max())
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
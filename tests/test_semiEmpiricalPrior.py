@@ -62,6 +62,16 @@ class SemiEmpiricalPriorTestCase(lsst.utils.tests.TestCase):
             p = self.prior.evaluate(numpy.array([row["eta1"], row["eta2"], row["lnR"]]), self.amplitudes)
             self.assertFloatsAlmostEqual(row["p"], p)
 
+    def testEvaluateBatch(self):
+        nonlinear = numpy.array([self.data["eta1"], self.data["eta2"], self.data["lnR"]]).transpose().copy()
+        amplitudes = numpy.ones((len(self.data), 1), dtype=lsst.meas.modelfit.Scalar)
+        amplitudes[::3] = -1.0
+        output = numpy.zeros(len(self.data), dtype=lsst.meas.modelfit.Scalar)
+        self.prior.evaluateBatch(nonlinear, amplitudes, output)
+        expected = self.data["p"].copy()
+        expected[::3] = 0.0
+        self.assertFloatsAlmostEqual(output, expected)
+
     def testGradient(self):
         for row in self.data:
             grad = numpy.zeros(4, dtype=float)
@@ -92,6 +102,28 @@ class SemiEmpiricalPriorTestCase(lsst.utils.tests.TestCase):
             self.assertFloatsAlmostEqual(row["d2_eta2_eta2"], hess[1, 1])
             self.assertFloatsAlmostEqual(row["d2_eta2_lnR"], hess[1, 2])
             self.assertFloatsAlmostEqual(row["d2_lnR_lnR"], hess[2, 2])
+            self.assertFloatsAlmostEqual(hess[:3, :3], hess[:3, :3].transpose())
+
+    def testTabulation(self):
+        self.assertEqual(self.prior.getTabulationError(), 0.0)
+        self.ctrl.tabulationTolerance = 1E-8
+        tabulated = lsst.meas.modelfit.SemiEmpiricalPrior(self.ctrl)
+        self.assertLess(tabulated.getTabulationError(), self.ctrl.tabulationTolerance)
+        for row in self.data:
+            nonlinear = numpy.array([row["eta1"], row["eta2"], row["lnR"]])
+            grad = numpy.zeros(4, dtype=float)
+            hess = numpy.zeros((4, 4), dtype=float)
+            tabulated.evaluateDerivatives(nonlinear, self.amplitudes,
+                                          grad[:3], grad[3:], hess[:3, :3], hess[3:, 3:], hess[:3, 3:])
+            self.assertFloatsAlmostEqual(row["p"], tabulated.evaluate(nonlinear, self.amplitudes),
+                                         rtol=1E-6, atol=1E-12)
+            self.assertFloatsAlmostEqual(row["d_lnR"], grad[2], rtol=1E-6, atol=1E-12)
+            self.assertFloatsAlmostEqual(row["d2_lnR_lnR"], hess[2, 2], rtol=1E-6, atol=1E-12)
+        nonlinear = numpy.array([self.data["eta1"], self.data["eta2"], self.data["lnR"]]).transpose().copy()
+        amplitudes = numpy.ones((len(self.data), 1), dtype=lsst.meas.modelfit.Scalar)
+        output = numpy.zeros(len(self.data), dtype=lsst.meas.modelfit.Scalar)
+        tabulated.evaluateBatch(nonlinear, amplitudes, output)
+        self.assertFloatsAlmostEqual(output, self.data["p"], rtol=1E-6, atol=1E-12)
 
     def evaluatePrior(self, eta1, eta2, lnR):
         b = numpy.broadcast(eta1, eta2, lnR)
@@ -123,6 +123,23 @@ class SoftenedLinearPriorTestCase(lsst.utils.tests.TestCase):
                 for r in logRadiusPoints:
                     self.checkDerivatives(e1, e2, r)
 
+    def testEvaluateBatch(self):
+        """Test that evaluateBatch() matches evaluate() in every zone, including negative amplitudes.
+        """
+        ctrl = self.prior.getControl()
+        n = 500
+        nonlinear = numpy.zeros((n, 3), dtype=lsst.meas.modelfit.Scalar)
+        nonlinear[:, :2] = numpy.random.uniform(-ctrl.ellipticityMaxOuter, ctrl.ellipticityMaxOuter,
+                                                size=(n, 2))
+        nonlinear[:, 2] = numpy.random.uniform(ctrl.logRadiusMinOuter - 1.0, ctrl.logRadiusMaxOuter + 1.0,
+                                               size=n)
+        amplitudes = numpy.random.uniform(-0.1, 1.0, size=(n, 1))
+        output = numpy.zeros(n, dtype=lsst.meas.modelfit.Scalar)
+        self.prior.evaluateBatch(nonlinear, amplitudes, output)
+        for i in range(n):
+            self.assertFloatsAlmostEqual(output[i], self.prior.evaluate(nonlinear[i], amplitudes[i]),
+                                         rtol=1E-14, atol=1E-14)
+
     @unittest.skipIf(scipy is None, "could not import scipy")
     def testIntegral(self):
         """Test that the prior is properly normalized.
@@ -32,6 +32,7 @@ except ImportError:
 import lsst.log
 import lsst.log.utils
 import lsst.utils.tests
+import lsst.afw.math
 import lsst.meas.modelfit
 
 
@@ -189,6 +190,128 @@ class TruncatedGaussianTestCase(lsst.utils.tests.TestCase):
                                          rtol=1E-13)
             self.check2d(mu, hessian, tg, isDegenerate=True)
 
+    def testMaximize(self):
+        """Test that maximize() finds the constrained optimum in 2-d, including cases where clamping
+        the negative elements of the untruncated mean is not optimal.
+        """
+        def objective(alpha, mu, hessian):
+            delta = alpha - mu
+            return 0.5*numpy.dot(delta, numpy.dot(hessian, delta))
+
+        for i in range(50):
+            a = numpy.random.randn(5, 2)
+            hessian = numpy.dot(a.transpose(), a)
+            mu = numpy.random.randn(2)
+            tg = lsst.meas.modelfit.TruncatedGaussian.fromSeriesParameters(
+                0.0, -numpy.dot(hessian, mu), hessian
+            )
+            alpha = tg.maximize()
+            self.assertTrue((alpha >= 0.0).all())
+            # brute-force enumeration of the active sets
+            candidates = [numpy.zeros(2)]
+            if (mu >= 0.0).all():
+                candidates.append(mu)
+            for j in range(2):
+                c = numpy.zeros(2)
+                c[j] = max(mu[j] + hessian[j, 1-j]*mu[1-j]/hessian[j, j], 0.0)
+                candidates.append(c)
+            best = min(objective(c, mu, hessian) for c in candidates)
+            self.assertFloatsAlmostEqual(objective(alpha, mu, hessian), best, rtol=1E-12, atol=1E-14)
+            self.assertFloatsAlmostEqual(tg.evaluateLog()(alpha),
+                                         tg.getLogPeakAmplitude() + objective(alpha, mu, hessian),
+                                         rtol=1E-10)
+        tg1 = lsst.meas.modelfit.TruncatedGaussian.fromStandardParameters(numpy.array([-1.0]),
+                                                                          numpy.array([[2.0]]))
+        self.assertFloatsAlmostEqual(tg1.maximize(), numpy.zeros(1))
+
+    def testMaximizeSeries(self):
+        """Test the N-d active-set solver against the KKT conditions, with and without a warm start,
+        and against the 2-d closed-form solution.
+        """
+        for n in [2, 5, 12]:
+            for i in range(10):
+                a = numpy.random.randn(n + 3, n)
+                hessian = numpy.dot(a.transpose(), a)
+                mu = numpy.random.randn(n)
+                gradient = -numpy.dot(hessian, mu)
+                alpha = lsst.meas.modelfit.TruncatedGaussian.maximizeSeries(gradient, hessian)
+                w = numpy.dot(hessian, alpha) + gradient
+                self.assertTrue((alpha >= 0.0).all())
+                self.assertFloatsAlmostEqual(w[alpha > 0.0], 0.0, atol=1E-10)
+                self.assertTrue((w[alpha == 0.0] > -1E-10).all())
+                warm = lsst.meas.modelfit.TruncatedGaussian.maximizeSeries(gradient, hessian, mu)
+                self.assertFloatsAlmostEqual(warm, alpha, rtol=1E-10, atol=1E-12)
+                if n == 2:
+                    tg = lsst.meas.modelfit.TruncatedGaussian.fromSeriesParameters(0.0, gradient, hessian)
+                    self.assertFloatsAlmostEqual(tg.maximize(), alpha, rtol=1E-10, atol=1E-12)
+
+    def testMaximizeSeriesDegenerate(self):
+        """Test that the N-d active-set solver converges on rank-deficient problems with duplicated
+        columns, where round-off can otherwise make the active set cycle.
+        """
+        for n in [4, 8, 12]:
+            for i in range(20):
+                a = numpy.random.randn(n - 1, n)
+                a[:, -1] = a[:, 0]
+                a[:, -2] = 2.0*a[:, 1]
+                hessian = numpy.dot(a.transpose(), a)
+                gradient = -numpy.dot(a.transpose(), numpy.random.randn(n - 1))
+                alpha = lsst.meas.modelfit.TruncatedGaussian.maximizeSeries(gradient, hessian)
+                w = numpy.dot(hessian, alpha) + gradient
+                self.assertTrue((alpha >= 0.0).all())
+                self.assertFloatsAlmostEqual(w[alpha > 0.0], 0.0, atol=1E-8)
+                self.assertTrue((w[alpha == 0.0] > -1E-8).all())
+
+    def testBatchedSampling(self):
+        """Test that batched rejection sampling matches one-at-a-time sampling, and that the number of
+        candidates per sample is reported correctly.
+        """
+        mu = numpy.array([0.2, -0.5])
+        sigma = numpy.array([[1.0, 0.3], [0.3, 0.5]])
+        tg = lsst.meas.modelfit.TruncatedGaussian.fromStandardParameters(mu, sigma)
+        for strategy in (lsst.meas.modelfit.TruncatedGaussian.DIRECT_WITH_REJECTION,
+                         lsst.meas.modelfit.TruncatedGaussian.ALIGN_AND_WEIGHT):
+            sampler = tg.sample(strategy)
+            rng1 = lsst.afw.math.Random("MT19937", 10)
+            rng2 = lsst.afw.math.Random("MT19937", 10)
+            alpha1 = numpy.zeros((5000, 2), dtype=float)
+            weights1 = numpy.zeros(5000, dtype=float)
+            rate = sampler(rng1, alpha1, weights1)
+            alpha2 = numpy.zeros((5000, 2), dtype=float)
+            weights2 = numpy.zeros(5000, dtype=float)
+            for i in range(5000):
+                weights2[i] = sampler(rng2, alpha2[i])
+            self.assertFloatsAlmostEqual(alpha1, alpha2, rtol=1E-14)
+            self.assertFloatsAlmostEqual(weights1, weights2, rtol=1E-14)
+            self.assertEqual(rng1.uniform(), rng2.uniform())
+            if strategy == lsst.meas.modelfit.TruncatedGaussian.DIRECT_WITH_REJECTION:
+                self.assertFloatsAlmostEqual(rate, 1.0/tg.getUntruncatedFraction(), rtol=0.05)
+            else:
+                self.assertEqual(rate, 1.0)
+
+    def testCounterRandomSampler(self):
+        """Test that sampling with a CounterRandom gives identical results for any number of threads,
+        for all sampling strategies.
+        """
+        mu = numpy.array([0.5, -0.2])
+        sigma = numpy.array([[1.0, 0.3], [0.3, 0.5]])
+        rng = lsst.meas.modelfit.CounterRandom(seed=5)
+        for tg in (lsst.meas.modelfit.TruncatedGaussian.fromStandardParameters(mu, sigma),
+                   lsst.meas.modelfit.TruncatedGaussian.fromStandardParameters(mu[:1], sigma[:1, :1])):
+            for strategy in (lsst.meas.modelfit.TruncatedGaussian.DIRECT_WITH_REJECTION,
+                             lsst.meas.modelfit.TruncatedGaussian.ALIGN_AND_WEIGHT):
+                sampler = tg.sample(strategy)
+                alpha1 = numpy.zeros((2000, tg.getDim()), dtype=float)
+                weights1 = numpy.zeros(2000, dtype=float)
+                sampler(rng, alpha1, weights1)
+                alpha2 = numpy.zeros((2000, tg.getDim()), dtype=float)
+                weights2 = numpy.zeros(2000, dtype=float)
+                sampler(rng, alpha2, weights2, nThreads=4)
+                self.assertTrue((alpha1 == alpha2).all())
+                self.assertTrue((weights1 == weights2).all())
+                self.assertTrue((alpha1 >= 0.0).all())
+                self.assertTrue((weights1 > 0.0).all())
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass